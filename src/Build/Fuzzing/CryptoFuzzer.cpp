@@ -0,0 +1,46 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+// libFuzzer target comparing the optimized cipher, XTS and hash implementations with
+// the reference ones (see Volume/CryptoDifferentialTest.h). Build and run:
+//
+//   make crypto-fuzzer FUZZER=1 NOGUI=1 CC=clang CXX=clang++
+//   Build/Fuzzing/crypto-fuzzer -max_len=256 corpus/
+//
+// A mismatch aborts with the name of the algorithm, and the saved crash input reproduces it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "Platform/Platform.h"
+#include "Volume/CryptoDifferentialTest.h"
+#include "Crypto/cpu.h"
+
+using namespace VeraCrypt;
+
+extern "C" int LLVMFuzzerInitialize (int *argc, char ***argv)
+{
+#ifdef CRYPTOPP_CPUID_AVAILABLE
+	DetectX86Features ();
+#endif
+	return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
+{
+	try
+	{
+		CryptoDifferentialTest::TestInput (ConstBufferPtr (data, size));
+	}
+	catch (Exception &e)
+	{
+		fprintf (stderr, "%s: %ls\n", e.what(), e.GetSubject().c_str());
+		abort();
+	}
+
+	return 0;
+}
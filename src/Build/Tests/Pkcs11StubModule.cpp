@@ -0,0 +1,218 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+// Minimal PKCS #11 module used by SecurityTokenTest.cpp. It provides two slots with
+// three private data objects each, simulates 20 ms of token latency per object call
+// and exports counters and switches through which the test observes and changes the
+// token state:
+//
+//   StubAttributeCalls       number of C_GetAttributeValue calls
+//   StubMaxConcurrentCalls   highest number of object calls executed concurrently
+//   StubHandleGeneration     changing it invalidates all object handles
+//   StubObjectShift          changing it makes object handles refer to other objects
+//   StubLoggedIn[slot]       clearing it logs the user out of the slot
+//   StubPendingSlotEvent     slot reported by the next C_WaitForSlotEvent
+//
+// If the environment variable STUB_INIT_ERROR is set, C_Initialize called with
+// arguments fails with the given return value.
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+
+#define CK_PTR *
+#define CK_DEFINE_FUNCTION(returnType, name) returnType name
+#define CK_DECLARE_FUNCTION(returnType, name) returnType name
+#define CK_DECLARE_FUNCTION_POINTER(returnType, name) returnType (* name)
+#define CK_CALLBACK_FUNCTION(returnType, name) returnType (* name)
+#ifndef NULL_PTR
+#	define NULL_PTR 0
+#endif
+
+#include <pkcs11.h>
+
+extern "C"
+{
+	std::atomic <int> StubAttributeCalls (0);
+	std::atomic <int> StubMaxConcurrentCalls (0);
+	int StubHandleGeneration = 0;
+	int StubLoggedIn[2] = { 0, 0 };
+	int StubObjectShift = 0;
+	int StubPendingSlotEvent = -1;
+}
+
+static const CK_ULONG SlotCount = 2;
+static const CK_ULONG ObjectCount = 3;
+
+static std::atomic <int> ConcurrentCalls (0);
+static thread_local CK_ULONG FindPosition;
+static CK_FUNCTION_LIST FunctionList;
+
+static void SimulateTokenLatency ()
+{
+	int concurrent = ++ConcurrentCalls;
+	int max = StubMaxConcurrentCalls;
+
+	while (concurrent > max && !StubMaxConcurrentCalls.compare_exchange_weak (max, concurrent));
+
+	usleep (20000);
+	--ConcurrentCalls;
+}
+
+static CK_RV Initialize (CK_VOID_PTR initArgs)
+{
+	const char *initError = getenv ("STUB_INIT_ERROR");
+
+	if (initArgs && initError)
+		return strtoul (initError, nullptr, 0);
+
+	return CKR_OK;
+}
+
+static CK_RV Finalize (CK_VOID_PTR)
+{
+	return CKR_OK;
+}
+
+static CK_RV GetSlotList (CK_BBOOL, CK_SLOT_ID_PTR slotList, CK_ULONG_PTR count)
+{
+	if (slotList)
+	{
+		for (CK_ULONG i = 0; i < SlotCount; ++i)
+			slotList[i] = i;
+	}
+
+	*count = SlotCount;
+	return CKR_OK;
+}
+
+static CK_RV GetSlotInfo (CK_SLOT_ID, CK_SLOT_INFO_PTR info)
+{
+	memset (info, 0, sizeof (*info));
+	info->flags = CKF_TOKEN_PRESENT;
+	return CKR_OK;
+}
+
+static CK_RV GetTokenInfo (CK_SLOT_ID slotId, CK_TOKEN_INFO_PTR info)
+{
+	memset (info, ' ', sizeof (*info));
+	memcpy (info->label, slotId == 0 ? "tokA" : "tokB", 4);
+	info->flags = CKF_LOGIN_REQUIRED | CKF_TOKEN_INITIALIZED;
+	return CKR_OK;
+}
+
+static CK_RV OpenSession (CK_SLOT_ID slotId, CK_FLAGS, CK_VOID_PTR, CK_NOTIFY, CK_SESSION_HANDLE_PTR session)
+{
+	*session = slotId + 1;
+	return CKR_OK;
+}
+
+static CK_RV CloseSession (CK_SESSION_HANDLE)
+{
+	return CKR_OK;
+}
+
+static CK_RV GetSessionInfo (CK_SESSION_HANDLE session, CK_SESSION_INFO_PTR info)
+{
+	memset (info, 0, sizeof (*info));
+	info->slotID = session - 1;
+	info->state = StubLoggedIn[session - 1] ? CKS_RW_USER_FUNCTIONS : CKS_RW_PUBLIC_SESSION;
+	return CKR_OK;
+}
+
+static CK_RV Login (CK_SESSION_HANDLE session, CK_USER_TYPE, CK_UTF8CHAR_PTR, CK_ULONG)
+{
+	StubLoggedIn[session - 1] = 1;
+	return CKR_OK;
+}
+
+static CK_RV FindObjectsInit (CK_SESSION_HANDLE, CK_ATTRIBUTE_PTR, CK_ULONG)
+{
+	FindPosition = 0;
+	return CKR_OK;
+}
+
+static CK_RV FindObjects (CK_SESSION_HANDLE session, CK_OBJECT_HANDLE_PTR objects, CK_ULONG, CK_ULONG_PTR count)
+{
+	SimulateTokenLatency ();
+
+	if (FindPosition < ObjectCount)
+	{
+		*objects = StubHandleGeneration * 1000 + (session - 1) * 100 + FindPosition++;
+		*count = 1;
+	}
+	else
+		*count = 0;
+
+	return CKR_OK;
+}
+
+static CK_RV FindObjectsFinal (CK_SESSION_HANDLE)
+{
+	return CKR_OK;
+}
+
+static CK_RV GetAttributeValue (CK_SESSION_HANDLE, CK_OBJECT_HANDLE object, CK_ATTRIBUTE_PTR attribute, CK_ULONG)
+{
+	++StubAttributeCalls;
+	SimulateTokenLatency ();
+
+	if (object / 1000 != (CK_OBJECT_HANDLE) StubHandleGeneration)
+		return CKR_OBJECT_HANDLE_INVALID;
+
+	CK_ULONG objectId = object % 1000 / 100 * 100 + (object % 100 + StubObjectShift) % ObjectCount;
+	std::string value;
+
+	if (attribute->type == CKA_PRIVATE)
+		value.assign (1, (char) CK_TRUE);
+	else if (attribute->type == CKA_LABEL)
+		value = "kf" + std::to_string (objectId);
+	else
+		value = "secret" + std::to_string (objectId);
+
+	if (attribute->pValue)
+		memcpy (attribute->pValue, value.data(), value.size());
+
+	attribute->ulValueLen = value.size();
+	return CKR_OK;
+}
+
+static CK_RV WaitForSlotEvent (CK_FLAGS, CK_SLOT_ID_PTR slotId, CK_VOID_PTR)
+{
+	if (StubPendingSlotEvent < 0)
+		return CKR_NO_EVENT;
+
+	*slotId = StubPendingSlotEvent;
+	StubPendingSlotEvent = -1;
+	return CKR_OK;
+}
+
+extern "C" CK_RV C_GetFunctionList (CK_FUNCTION_LIST_PTR_PTR functionList)
+{
+	memset (&FunctionList, 0, sizeof (FunctionList));
+
+	FunctionList.C_Initialize = Initialize;
+	FunctionList.C_Finalize = Finalize;
+	FunctionList.C_GetSlotList = GetSlotList;
+	FunctionList.C_GetSlotInfo = GetSlotInfo;
+	FunctionList.C_GetTokenInfo = GetTokenInfo;
+	FunctionList.C_OpenSession = OpenSession;
+	FunctionList.C_CloseSession = CloseSession;
+	FunctionList.C_GetSessionInfo = GetSessionInfo;
+	FunctionList.C_Login = Login;
+	FunctionList.C_FindObjectsInit = FindObjectsInit;
+	FunctionList.C_FindObjects = FindObjects;
+	FunctionList.C_FindObjectsFinal = FindObjectsFinal;
+	FunctionList.C_GetAttributeValue = GetAttributeValue;
+	FunctionList.C_WaitForSlotEvent = WaitForSlotEvent;
+
+	*functionList = &FunctionList;
+	return CKR_OK;
+}
@@ -0,0 +1,140 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+// Regression test of the security token keyfile cache and of the library initialization,
+// run against the stub PKCS #11 module in Pkcs11StubModule.cpp. Build and run:
+//
+//   make security-token-test NOGUI=1
+//   Build/Tests/security-token-test Build/Tests/libpkcs11stub.so
+//
+// The test exits with a nonzero status and prints the failed check on error.
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include "Common/SecurityToken.h"
+
+using namespace VeraCrypt;
+
+#define TEST_CHECK(condition) do { if (!(condition)) { fprintf (stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); exit (1); } } while (false)
+
+struct TestPinFunctor : public GetPinFunctor
+{
+	virtual void operator() (string &pin) { pin = "1234"; }
+	virtual void notifyIncorrectPin () { }
+};
+
+struct TestWarningFunctor : public SendExceptionFunctor
+{
+	virtual void operator() (const Exception &) { }
+};
+
+static void InitLibrary (const string &modulePath)
+{
+	SecurityToken::InitLibrary (modulePath, unique_ptr <GetPinFunctor> (new TestPinFunctor), unique_ptr <SendExceptionFunctor> (new TestWarningFunctor));
+}
+
+int main (int argc, char **argv)
+{
+	if (argc != 2)
+	{
+		fprintf (stderr, "Usage: %s <stub module>\n", argv[0]);
+		return 2;
+	}
+
+	try
+	{
+		string modulePath (argv[1]);
+		InitLibrary (modulePath);
+
+		// The library is loaded already, so this returns the same instance
+		void *module = dlopen (modulePath.c_str(), RTLD_NOW);
+		TEST_CHECK (module);
+
+		std::atomic <int> &attributeCalls = *(std::atomic <int> *) dlsym (module, "StubAttributeCalls");
+		std::atomic <int> &maxConcurrentCalls = *(std::atomic <int> *) dlsym (module, "StubMaxConcurrentCalls");
+		int &handleGeneration = *(int *) dlsym (module, "StubHandleGeneration");
+		int *loggedIn = (int *) dlsym (module, "StubLoggedIn");
+		int &objectShift = *(int *) dlsym (module, "StubObjectShift");
+		int &pendingSlotEvent = *(int *) dlsym (module, "StubPendingSlotEvent");
+
+		// Tokens are enumerated concurrently and the keyfiles are cached
+		vector <SecurityTokenKeyfile> keyfiles = SecurityToken::GetAvailableKeyfiles();
+		TEST_CHECK (keyfiles.size() == 6);
+		TEST_CHECK (maxConcurrentCalls > 1);
+
+		int calls = attributeCalls;
+		keyfiles = SecurityToken::GetAvailableKeyfiles();
+		TEST_CHECK (keyfiles.size() == 6);
+		TEST_CHECK (attributeCalls == calls);
+
+		SecurityTokenKeyfile keyfile (wstring (L"token://slot/1/file/kf101"));
+		vector <byte> keyfileData;
+		SecurityToken::GetKeyfileData (keyfile, keyfileData);
+		TEST_CHECK (string (keyfileData.begin(), keyfileData.end()) == "secret101");
+
+		// Stale object handles are resolved again
+		handleGeneration = 1;
+		keyfileData.clear();
+		SecurityToken::GetKeyfileData (keyfile, keyfileData);
+		TEST_CHECK (string (keyfileData.begin(), keyfileData.end()) == "secret101");
+
+		// Object handles referring to other objects are resolved again
+		objectShift = 1;
+		keyfileData.clear();
+		SecurityToken::GetKeyfileData (keyfile, keyfileData);
+		TEST_CHECK (string (keyfileData.begin(), keyfileData.end()) == "secret101");
+
+		// A slot event invalidates the cache
+		pendingSlotEvent = 0;
+		calls = attributeCalls;
+		keyfiles = SecurityToken::GetAvailableKeyfiles();
+		TEST_CHECK (keyfiles.size() == 6);
+		TEST_CHECK (attributeCalls > calls);
+
+		// A logout invalidates the cache of the slot
+		loggedIn[1] = 0;
+		calls = attributeCalls;
+		keyfiles = SecurityToken::GetAvailableKeyfiles();
+		TEST_CHECK (keyfiles.size() == 6);
+		TEST_CHECK (attributeCalls > calls);
+
+		calls = attributeCalls;
+		keyfiles = SecurityToken::GetAvailableKeyfiles();
+		TEST_CHECK (attributeCalls == calls);
+
+		// Closing the sessions invalidates the cache
+		SecurityToken::CloseAllSessions();
+		calls = attributeCalls;
+		keyfiles = SecurityToken::GetAvailableKeyfiles();
+		TEST_CHECK (keyfiles.size() == 6);
+		TEST_CHECK (attributeCalls > calls);
+
+		// A library rejecting the locking arguments is initialized without them and used by a single thread
+		SecurityToken::CloseLibrary();
+		setenv ("STUB_INIT_ERROR", "0x7" /* CKR_ARGUMENTS_BAD */, 1);
+		InitLibrary (modulePath);
+
+		maxConcurrentCalls = 0;
+		keyfiles = SecurityToken::GetAvailableKeyfiles();
+		TEST_CHECK (keyfiles.size() == 6);
+		TEST_CHECK (maxConcurrentCalls == 1);
+
+		SecurityToken::CloseLibrary();
+		dlclose (module);
+	}
+	catch (Exception &e)
+	{
+		fprintf (stderr, "Exception: %s\n", e.what());
+		return 1;
+	}
+
+	puts ("Security token tests passed");
+	return 0;
+}
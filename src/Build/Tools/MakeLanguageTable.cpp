@@ -0,0 +1,264 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+// Converts Language.xml to a C++ header containing a perfect-hashed string table.
+// Usage: MakeLanguageTable Language.xml Language.table.h
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../../Main/LanguageTable.h"
+
+using namespace std;
+using namespace VeraCrypt;
+
+struct Entry
+{
+	string Key;
+	string Text;
+};
+
+struct LargerBucketFirst
+{
+	LargerBucketFirst (const vector < vector <size_t> > &buckets) : Buckets (buckets) { }
+	bool operator() (size_t a, size_t b) const { return Buckets[a].size() > Buckets[b].size(); }
+	const vector < vector <size_t> > &Buckets;
+};
+
+static void Replace (string &str, const string &from, const string &to)
+{
+	size_t pos = 0;
+	while ((pos = str.find (from, pos)) != string::npos)
+	{
+		str.replace (pos, from.size(), to);
+		pos += to.size();
+	}
+}
+
+// Must produce the same text as XmlParser and LanguageStrings did at run time
+static string ConvertEscapedChars (string str)
+{
+	Replace (str, "&lt;", "<");
+	Replace (str, "&gt;", ">");
+	Replace (str, "&amp;", "&");
+	Replace (str, "&quot;", "\"");
+	return str;
+}
+
+static bool ReadEntries (const string &xml, vector <Entry> &entries)
+{
+	map <string, size_t> keyIndex;
+	size_t pos = 0;
+
+	while ((pos = xml.find ("<entry", pos)) != string::npos)
+	{
+		size_t tagEnd = xml.find ('>', pos);
+		if (tagEnd == string::npos)
+			return false;
+
+		string tag = xml.substr (pos, tagEnd - pos);
+		size_t keyPos = tag.find (" key=\"");
+		if (keyPos == string::npos)
+			return false;
+
+		keyPos += 6;
+		size_t keyEnd = tag.find ('"', keyPos);
+		if (keyEnd == string::npos)
+			return false;
+
+		size_t textEnd = xml.find ("</entry>", tagEnd);
+		if (textEnd == string::npos)
+			return false;
+
+		Entry entry;
+		entry.Key = ConvertEscapedChars (tag.substr (keyPos, keyEnd - keyPos));
+		entry.Text = ConvertEscapedChars (xml.substr (tagEnd + 1, textEnd - tagEnd - 1));
+		Replace (entry.Text, "\\n", "\n");
+
+		// Later definitions replace earlier ones
+		if (keyIndex.count (entry.Key))
+			entries[keyIndex[entry.Key]] = entry;
+		else
+		{
+			keyIndex[entry.Key] = entries.size();
+			entries.push_back (entry);
+		}
+
+		pos = textEnd;
+	}
+
+	return !entries.empty();
+}
+
+static string ToLiteral (const string &str)
+{
+	string literal = "\"";
+	size_t lineLength = 0;
+
+	for (size_t i = 0; i < str.size(); ++i)
+	{
+		unsigned char c = (unsigned char) str[i];
+
+		if (c == '\\' || c == '"')
+		{
+			literal += '\\';
+			literal += (char) c;
+		}
+		else if (c == '\n')
+			literal += "\\n";
+		else if (c >= 0x20 && c < 0x7f && c != '?')	// '?' is escaped to avoid trigraphs
+		{
+			literal += (char) c;
+		}
+		else
+		{
+			// Octal escapes are at most three digits long and cannot absorb the following character
+			literal += '\\';
+			literal += (char) ('0' + ((c >> 6) & 7));
+			literal += (char) ('0' + ((c >> 3) & 7));
+			literal += (char) ('0' + (c & 7));
+		}
+
+		if (++lineLength >= 100 && i + 1 < str.size())
+		{
+			literal += "\"\n\t\"";
+			lineLength = 0;
+		}
+	}
+
+	return literal + "\"";
+}
+
+int main (int argc, char **argv)
+{
+	if (argc != 3)
+	{
+		cerr << "Usage: " << argv[0] << " Language.xml Language.table.h" << endl;
+		return 1;
+	}
+
+	ifstream input (argv[1], ios::binary);
+	stringstream xml;
+	xml << input.rdbuf();
+
+	vector <Entry> entries;
+	if (!input || !ReadEntries (xml.str(), entries))
+	{
+		cerr << argv[1] << ": no language entries found" << endl;
+		return 1;
+	}
+
+	// Assign keys to buckets and place the largest buckets first
+	const size_t entryCount = entries.size();
+	const size_t bucketCount = (entryCount + 3) / 4;
+
+	vector < vector <size_t> > buckets (bucketCount);
+	for (size_t i = 0; i < entryCount; ++i)
+		buckets[LanguageTableHash (entries[i].Key.c_str(), entries[i].Key.size(), 0) % bucketCount].push_back (i);
+
+	vector <size_t> bucketOrder (bucketCount);
+	for (size_t i = 0; i < bucketCount; ++i)
+		bucketOrder[i] = i;
+
+	stable_sort (bucketOrder.begin(), bucketOrder.end(), LargerBucketFirst (buckets));
+
+	vector <uint32_t> bucketSeeds (bucketCount, 0);
+	vector <long> slots (entryCount, -1);
+
+	for (size_t n = 0; n < bucketCount; ++n)
+	{
+		size_t b = bucketOrder[n];
+		if (buckets[b].empty())
+			continue;
+
+		for (uint32_t seed = 1; ; ++seed)
+		{
+			if (seed == 0x1000000)
+			{
+				cerr << argv[1] << ": unable to build perfect hash" << endl;
+				return 1;
+			}
+
+			vector <size_t> placed;
+			bool collision = false;
+
+			for (size_t i = 0; i < buckets[b].size(); ++i)
+			{
+				size_t e = buckets[b][i];
+				size_t slot = LanguageTableHash (entries[e].Key.c_str(), entries[e].Key.size(), seed) % entryCount;
+				if (slots[slot] != -1 || find (placed.begin(), placed.end(), slot) != placed.end())
+				{
+					collision = true;
+					break;
+				}
+				placed.push_back (slot);
+			}
+
+			if (collision)
+				continue;
+
+			for (size_t i = 0; i < placed.size(); ++i)
+				slots[placed[i]] = (long) buckets[b][i];
+
+			bucketSeeds[b] = seed;
+			break;
+		}
+	}
+
+	// Intern strings
+	string keys, text;
+	map <string, size_t> textOffsets;
+	vector <LanguageTableEntry> table (entryCount);
+
+	for (size_t slot = 0; slot < entryCount; ++slot)
+	{
+		const Entry &entry = entries[slots[slot]];
+
+		table[slot].KeyOffset = (uint32_t) keys.size();
+		table[slot].KeyLength = (uint32_t) entry.Key.size();
+		keys += entry.Key;
+
+		if (!textOffsets.count (entry.Text))
+		{
+			textOffsets[entry.Text] = text.size();
+			text += entry.Text;
+		}
+
+		table[slot].TextOffset = (uint32_t) textOffsets[entry.Text];
+		table[slot].TextLength = (uint32_t) entry.Text.size();
+	}
+
+	ofstream output (argv[2], ios::binary | ios::trunc);
+	output << "// Generated from " << argv[1] << " by MakeLanguageTable - do not edit\n\n";
+
+	output << "static const uint32_t LanguageTableBucketSeeds[" << bucketCount << "] =\n{";
+	for (size_t i = 0; i < bucketCount; ++i)
+		output << (i % 16 == 0 ? "\n\t" : " ") << bucketSeeds[i] << ",";
+	output << "\n};\n\n";
+
+	output << "static const LanguageTableEntry LanguageTableEntries[" << entryCount << "] =\n{\n";
+	for (size_t i = 0; i < entryCount; ++i)
+		output << "\t{ " << table[i].KeyOffset << ", " << table[i].KeyLength << ", " << table[i].TextOffset << ", " << table[i].TextLength << " },\n";
+	output << "};\n\n";
+
+	output << "static const char LanguageTableKeys[] =\n\t" << ToLiteral (keys) << ";\n\n";
+	output << "static const char LanguageTableText[] =\n\t" << ToLiteral (text) << ";\n";
+
+	output.close();
+	if (!output)
+	{
+		cerr << argv[2] << ": write failed" << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -10,6 +10,7 @@
  code distribution packages.
 */
 
+#include <algorithm>
 #include "Platform/Finally.h"
 #include "Platform/ForEach.h"
 
@@ -17,6 +18,7 @@
 #	include "Platform/SerializerFactory.h"
 #	include "Platform/StringConverter.h"
 #	include "Platform/SystemException.h"
+#	include "Platform/Thread.h"
 #else
 #	include "Dictionary.h"
 #	include "Language.h"
@@ -115,6 +117,39 @@ namespace VeraCrypt
 		Sessions.erase (Sessions.find (slotId));
 	}
 
+	void SecurityToken::CloseSessionsOfChangedSlots (const list <CK_SLOT_ID> &presentSlots)
+	{
+		list <CK_SLOT_ID> changedSlots;
+
+		// Tokens inserted or removed since the last call (at most one event is pending per slot)
+		for (size_t i = 0; i <= Sessions.size() + presentSlots.size(); ++i)
+		{
+			CK_SLOT_ID slotId;
+			if (Pkcs11Functions->C_WaitForSlotEvent (CKF_DONT_BLOCK, &slotId, NULL_PTR) != CKR_OK)
+				break;
+
+			changedSlots.push_back (slotId);
+		}
+
+		for (map <CK_SLOT_ID, Pkcs11Session>::const_iterator i = Sessions.begin(); i != Sessions.end(); ++i)
+		{
+			if (find (presentSlots.begin(), presentSlots.end(), i->first) == presentSlots.end())
+				changedSlots.push_back (i->first);
+		}
+
+		foreach (CK_SLOT_ID slotId, changedSlots)
+		{
+			if (Sessions.find (slotId) != Sessions.end())
+			{
+				try
+				{
+					CloseSession (slotId);
+				}
+				catch (...) { }
+			}
+		}
+	}
+
 	void SecurityToken::CreateKeyfile (CK_SLOT_ID slotId, vector <byte> &keyfileData, const string &name)
 	{
 		if (name.empty())
@@ -122,6 +157,9 @@ namespace VeraCrypt
 
 		LoginUserIfRequired (slotId);
 
+		// Keyfiles may have been created by other applications
+		Sessions[slotId].KeyfilesCached = false;
+
 		foreach (const SecurityTokenKeyfile &keyfile, GetAvailableKeyfiles (&slotId))
 		{
 			if (keyfile.IdUtf8 == name)
@@ -143,6 +181,7 @@ namespace VeraCrypt
 		CK_OBJECT_HANDLE keyfileHandle;
 
 		CK_RV status = Pkcs11Functions->C_CreateObject (Sessions[slotId].Handle, keyfileTemplate, array_capacity (keyfileTemplate), &keyfileHandle);
+		Sessions[slotId].KeyfilesCached = false;
 
 		switch (status)
 		{
@@ -176,26 +215,114 @@ namespace VeraCrypt
 		LoginUserIfRequired (keyfile.SlotId);
 
 		CK_RV status = Pkcs11Functions->C_DestroyObject (Sessions[keyfile.SlotId].Handle, keyfile.Handle);
+		Sessions[keyfile.SlotId].KeyfilesCached = false;
+
 		if (status != CKR_OK)
 			throw Pkcs11Exception (status);
 	}
 
+	void SecurityToken::CacheKeyfiles (const vector <CK_SLOT_ID> &slots)
+	{
+		vector <CK_SLOT_ID> uncachedSlots;
+		foreach (CK_SLOT_ID slotId, slots)
+		{
+			if (!Sessions[slotId].KeyfilesCached)
+				uncachedSlots.push_back (slotId);
+		}
+
+#if !defined (TC_WINDOWS) || defined (TC_PROTOTYPE)
+		if (MultiThreadingSupported && uncachedSlots.size() > 1)
+		{
+			// Each token is read in its own session, which allows the library to access the tokens concurrently
+			struct ReaderState
+			{
+				vector <SecurityTokenKeyfile> Keyfiles;
+				CK_SESSION_HANDLE Session;
+				shared_ptr <Exception> ThreadException;
+				SecurityTokenInfo Token;
+			};
+
+			struct ReaderFunctor : public Functor
+			{
+				ReaderFunctor (ReaderState &state) : State (state) { }
+
+				virtual void operator() ()
+				{
+					try
+					{
+						SecurityToken::ReadKeyfileObjects (State.Session, State.Token, State.Keyfiles);
+					}
+					catch (Exception &e)
+					{
+						State.ThreadException.reset (e.CloneNew());
+					}
+					catch (exception &e)
+					{
+						State.ThreadException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+					}
+					catch (...)
+					{
+						State.ThreadException.reset (new UnknownException (SRC_POS));
+					}
+				}
+
+				ReaderState &State;
+			};
+
+			vector <ReaderState> states (uncachedSlots.size());
+			list < shared_ptr <Thread> > threads;
+
+			for (size_t i = 0; i < uncachedSlots.size(); ++i)
+			{
+				states[i].Session = Sessions[uncachedSlots[i]].Handle;
+				states[i].Token = Sessions[uncachedSlots[i]].Token;
+
+				make_shared_auto (Thread, thread);
+				thread->Start (new ReaderFunctor (states[i]));
+				threads.push_back (thread);
+			}
+
+			foreach_ref (const Thread &thread, threads)
+				thread.Join();
+
+			for (size_t i = 0; i < uncachedSlots.size(); ++i)
+			{
+				if (states[i].ThreadException)
+					states[i].ThreadException->Throw();
+			}
+
+			for (size_t i = 0; i < uncachedSlots.size(); ++i)
+			{
+				Sessions[uncachedSlots[i]].Keyfiles = states[i].Keyfiles;
+				Sessions[uncachedSlots[i]].KeyfilesCached = true;
+			}
+
+			return;
+		}
+#endif
+		foreach (CK_SLOT_ID slotId, uncachedSlots)
+		{
+			Pkcs11Session &session = Sessions[slotId];
+			session.Keyfiles.clear();
+
+			ReadKeyfileObjects (session.Handle, session.Token, session.Keyfiles);
+			session.KeyfilesCached = true;
+		}
+	}
+
 	vector <SecurityTokenKeyfile> SecurityToken::GetAvailableKeyfiles (CK_SLOT_ID *slotIdFilter, const wstring keyfileIdFilter)
 	{
 		bool unrecognizedTokenPresent = false;
-		vector <SecurityTokenKeyfile> keyfiles;
+		vector <CK_SLOT_ID> slots;
 
 		foreach (const CK_SLOT_ID &slotId, GetTokenSlots())
 		{
-			SecurityTokenInfo token;
-
 			if (slotIdFilter && *slotIdFilter != slotId)
 				continue;
 
 			try
 			{
 				LoginUserIfRequired (slotId);
-				token = GetTokenInfo (slotId);
 			}
 			catch (UserAbort &)
 			{
@@ -212,34 +339,23 @@ namespace VeraCrypt
 				throw;
 			}
 
-			foreach (const CK_OBJECT_HANDLE &dataHandle, GetObjects (slotId, CKO_DATA))
-			{
-				SecurityTokenKeyfile keyfile;
-				keyfile.Handle = dataHandle;
-				keyfile.SlotId = slotId;
-				keyfile.Token = token;
-
-				vector <byte> privateAttrib;
-				GetObjectAttribute (slotId, dataHandle, CKA_PRIVATE, privateAttrib);
+			slots.push_back (slotId);
+		}
 
-				if (privateAttrib.size() == sizeof (CK_BBOOL) && *(CK_BBOOL *) &privateAttrib.front() != CK_TRUE)
-					continue;
+		CacheKeyfiles (slots);
 
-				vector <byte> label;
-				GetObjectAttribute (slotId, dataHandle, CKA_LABEL, label);
-				label.push_back (0);
+		vector <SecurityTokenKeyfile> keyfiles;
 
-				keyfile.IdUtf8 = (char *) &label.front();
+		foreach (CK_SLOT_ID slotId, slots)
+		{
+			const vector <SecurityTokenKeyfile> &slotKeyfiles = Sessions[slotId].Keyfiles;
 
-#if defined (TC_WINDOWS) && !defined (TC_PROTOTYPE)
-				keyfile.Id = Utf8StringToWide ((const char *) &label.front());
-#else
-				keyfile.Id = StringConverter::ToWide ((const char *) &label.front());
-#endif
-				if (keyfile.Id.empty() || (!keyfileIdFilter.empty() && keyfileIdFilter != keyfile.Id))
+			for (size_t i = 0; i < slotKeyfiles.size(); ++i)
+			{
+				if (!keyfileIdFilter.empty() && keyfileIdFilter != slotKeyfiles[i].Id)
 					continue;
 
-				keyfiles.push_back (keyfile);
+				keyfiles.push_back (slotKeyfiles[i]);
 
 				if (!keyfileIdFilter.empty())
 					break;
@@ -315,24 +431,57 @@ namespace VeraCrypt
 	void SecurityToken::GetKeyfileData (const SecurityTokenKeyfile &keyfile, vector <byte> &keyfileData)
 	{
 		LoginUserIfRequired (keyfile.SlotId);
-		GetObjectAttribute (keyfile.SlotId, keyfile.Handle, CKA_VALUE, keyfileData);
+
+		// The handle may have been cached before the object was deleted or replaced by another
+		// application, in which case it can be invalid or refer to a different object
+		bool handleValid;
+
+		try
+		{
+			vector <byte> label;
+			GetObjectAttribute (keyfile.SlotId, keyfile.Handle, CKA_LABEL, label);
+
+			handleValid = (string (label.begin(), label.end()) == keyfile.IdUtf8);
+		}
+		catch (Pkcs11Exception &e)
+		{
+			if (e.GetErrorCode() != CKR_OBJECT_HANDLE_INVALID)
+				throw;
+
+			handleValid = false;
+		}
+
+		if (handleValid)
+		{
+			GetObjectAttribute (keyfile.SlotId, keyfile.Handle, CKA_VALUE, keyfileData);
+			return;
+		}
+
+		if (keyfile.Id.empty())
+			throw SecurityTokenKeyfileNotFound();
+
+		CK_SLOT_ID slotId = keyfile.SlotId;
+		Sessions[slotId].KeyfilesCached = false;
+
+		vector <SecurityTokenKeyfile> keyfiles = GetAvailableKeyfiles (&slotId, keyfile.Id);
+		if (keyfiles.empty())
+			throw SecurityTokenKeyfileNotFound();
+
+		GetObjectAttribute (slotId, keyfiles.front().Handle, CKA_VALUE, keyfileData);
 	}
 
-	vector <CK_OBJECT_HANDLE> SecurityToken::GetObjects (CK_SLOT_ID slotId, CK_ATTRIBUTE_TYPE objectClass)
+	vector <CK_OBJECT_HANDLE> SecurityToken::GetObjects (CK_SESSION_HANDLE session, CK_ATTRIBUTE_TYPE objectClass)
 	{
-		if (Sessions.find (slotId) == Sessions.end())
-			throw ParameterIncorrect (SRC_POS);
-
 		CK_ATTRIBUTE findTemplate;
 		findTemplate.type = CKA_CLASS;
 		findTemplate.pValue = &objectClass;
 		findTemplate.ulValueLen = sizeof (objectClass);
 
-		CK_RV status = Pkcs11Functions->C_FindObjectsInit (Sessions[slotId].Handle, &findTemplate, 1);
+		CK_RV status = Pkcs11Functions->C_FindObjectsInit (session, &findTemplate, 1);
 		if (status != CKR_OK)
 			throw Pkcs11Exception (status);
 
-		finally_do_arg (CK_SLOT_ID, slotId, { Pkcs11Functions->C_FindObjectsFinal (Sessions[finally_arg].Handle); });
+		finally_do_arg (CK_SESSION_HANDLE, session, { Pkcs11Functions->C_FindObjectsFinal (finally_arg); });
 
 		CK_ULONG objectCount;
 		vector <CK_OBJECT_HANDLE> objects;
@@ -340,7 +489,7 @@ namespace VeraCrypt
 		while (true)
 		{
 			CK_OBJECT_HANDLE object;
-			CK_RV status = Pkcs11Functions->C_FindObjects (Sessions[slotId].Handle, &object, 1, &objectCount);
+			CK_RV status = Pkcs11Functions->C_FindObjects (session, &object, 1, &objectCount);
 			if (status != CKR_OK)
 				throw Pkcs11Exception (status);
 
@@ -360,11 +509,18 @@ namespace VeraCrypt
 		if (Sessions.find (slotId) == Sessions.end())
 			throw ParameterIncorrect (SRC_POS);
 
+		GetSessionObjectAttribute (Sessions[slotId].Handle, tokenObject, attributeType, attributeValue);
+	}
+
+	void SecurityToken::GetSessionObjectAttribute (CK_SESSION_HANDLE session, CK_OBJECT_HANDLE tokenObject, CK_ATTRIBUTE_TYPE attributeType, vector <byte> &attributeValue)
+	{
+		attributeValue.clear();
+
 		CK_ATTRIBUTE attribute;
 		attribute.type = attributeType;
 		attribute.pValue = NULL_PTR;
 
-		CK_RV status = Pkcs11Functions->C_GetAttributeValue (Sessions[slotId].Handle, tokenObject, &attribute, 1);
+		CK_RV status = Pkcs11Functions->C_GetAttributeValue (session, tokenObject, &attribute, 1);
 		if (status != CKR_OK)
 			throw Pkcs11Exception (status);
 
@@ -374,7 +530,7 @@ namespace VeraCrypt
 		attributeValue = vector <byte> (attribute.ulValueLen);
 		attribute.pValue = &attributeValue.front();
 
-		status = Pkcs11Functions->C_GetAttributeValue (Sessions[slotId].Handle, tokenObject, &attribute, 1);
+		status = Pkcs11Functions->C_GetAttributeValue (session, tokenObject, &attribute, 1);
 		if (status != CKR_OK)
 			throw Pkcs11Exception (status);
 	}
@@ -409,6 +565,7 @@ namespace VeraCrypt
 			}
 		}
 
+		CloseSessionsOfChangedSlots (slots);
 		return slots;
 	}
 
@@ -449,7 +606,13 @@ namespace VeraCrypt
 
 			if (status == CKR_OK)
 			{
-				Sessions[slotId].UserLoggedIn = (sessionInfo.state == CKS_RO_USER_FUNCTIONS || sessionInfo.state == CKS_RW_USER_FUNCTIONS);
+				bool userLoggedIn = (sessionInfo.state == CKS_RO_USER_FUNCTIONS || sessionInfo.state == CKS_RW_USER_FUNCTIONS);
+
+				// Private objects are not visible until the user logs in again
+				if (Sessions[slotId].UserLoggedIn && !userLoggedIn)
+					Sessions[slotId].KeyfilesCached = false;
+
+				Sessions[slotId].UserLoggedIn = userLoggedIn;
 			}
 			else
 			{
@@ -544,7 +707,21 @@ namespace VeraCrypt
 		if (status != CKR_OK)
 			throw Pkcs11Exception (status);
 
+#if !defined (TC_WINDOWS) || defined (TC_PROTOTYPE)
+		// Tokens can be enumerated concurrently if the library is thread-safe
+		CK_C_INITIALIZE_ARGS initArgs;
+		memset (&initArgs, 0, sizeof (initArgs));
+		initArgs.flags = CKF_OS_LOCKING_OK;
+
+		status = Pkcs11Functions->C_Initialize (&initArgs);
+		MultiThreadingSupported = (status == CKR_OK);
+
+		// Libraries may reject the locking flag with any error code (CKR_CANT_LOCK, CKR_ARGUMENTS_BAD, ...)
+		if (status != CKR_OK)
+			status = Pkcs11Functions->C_Initialize (NULL_PTR);
+#else
 		status = Pkcs11Functions->C_Initialize (NULL_PTR);
+#endif
 		if (status != CKR_OK)
 			throw Pkcs11Exception (status);
 
@@ -562,8 +739,9 @@ namespace VeraCrypt
 		CK_SESSION_HANDLE session;
 
 		CK_FLAGS flags = CKF_SERIAL_SESSION;
+		SecurityTokenInfo token = GetTokenInfo (slotId);
 
-		if (!(GetTokenInfo (slotId).Flags & CKF_WRITE_PROTECTED))
+		if (!(token.Flags & CKF_WRITE_PROTECTED))
 			 flags |= CKF_RW_SESSION;
 
 		CK_RV status = Pkcs11Functions->C_OpenSession (slotId, flags, NULL_PTR, NULL_PTR, &session);
@@ -571,6 +749,40 @@ namespace VeraCrypt
 			throw Pkcs11Exception (status);
 
 		Sessions[slotId].Handle = session;
+		Sessions[slotId].Token = token;
+	}
+
+	void SecurityToken::ReadKeyfileObjects (CK_SESSION_HANDLE session, const SecurityTokenInfo &token, vector <SecurityTokenKeyfile> &keyfiles)
+	{
+		foreach (const CK_OBJECT_HANDLE &dataHandle, GetObjects (session, CKO_DATA))
+		{
+			SecurityTokenKeyfile keyfile;
+			keyfile.Handle = dataHandle;
+			keyfile.SlotId = token.SlotId;
+			keyfile.Token = token;
+
+			vector <byte> privateAttrib;
+			GetSessionObjectAttribute (session, dataHandle, CKA_PRIVATE, privateAttrib);
+
+			if (privateAttrib.size() == sizeof (CK_BBOOL) && *(CK_BBOOL *) &privateAttrib.front() != CK_TRUE)
+				continue;
+
+			vector <byte> label;
+			GetSessionObjectAttribute (session, dataHandle, CKA_LABEL, label);
+			label.push_back (0);
+
+			keyfile.IdUtf8 = (char *) &label.front();
+
+#if defined (TC_WINDOWS) && !defined (TC_PROTOTYPE)
+			keyfile.Id = Utf8StringToWide ((const char *) &label.front());
+#else
+			keyfile.Id = StringConverter::ToWide ((const char *) &label.front());
+#endif
+			if (keyfile.Id.empty())
+				continue;
+
+			keyfiles.push_back (keyfile);
+		}
 	}
 
 	Pkcs11Exception::operator string () const
@@ -732,6 +944,7 @@ namespace VeraCrypt
 	unique_ptr <SendExceptionFunctor> SecurityToken::WarningCallback;
 
 	bool SecurityToken::Initialized;
+	bool SecurityToken::MultiThreadingSupported;
 	CK_FUNCTION_LIST_PTR SecurityToken::Pkcs11Functions;
 	map <CK_SLOT_ID, Pkcs11Session> SecurityToken::Sessions;
 
@@ -158,11 +158,17 @@ namespace VeraCrypt
 #endif // !TC_HEADER_Platform_Exception
 
 
+	// Keyfile objects and token information are cached with the session of a slot, as reading them
+	// from slow smart cards may take seconds. The cache is discarded when the session is closed, when
+	// the token is removed or the user is logged out, and when keyfiles are created or deleted.
 	struct Pkcs11Session
 	{
-		Pkcs11Session () : Handle (CK_UNAVAILABLE_INFORMATION), UserLoggedIn (false) { }
+		Pkcs11Session () : Handle (CK_UNAVAILABLE_INFORMATION), KeyfilesCached (false), UserLoggedIn (false) { Token.SlotId = CK_UNAVAILABLE_INFORMATION; Token.Flags = 0; }
 
 		CK_SESSION_HANDLE Handle;
+		vector <SecurityTokenKeyfile> Keyfiles;
+		bool KeyfilesCached;
+		SecurityTokenInfo Token;
 		bool UserLoggedIn;
 	};
 
@@ -201,16 +207,21 @@ namespace VeraCrypt
 		static const size_t MaxPasswordLength = 128;
 
 	protected:
+		static void CacheKeyfiles (const vector <CK_SLOT_ID> &slots);
 		static void CloseSession (CK_SLOT_ID slotId);
-		static vector <CK_OBJECT_HANDLE> GetObjects (CK_SLOT_ID slotId, CK_ATTRIBUTE_TYPE objectClass);
+		static void CloseSessionsOfChangedSlots (const list <CK_SLOT_ID> &presentSlots);
+		static vector <CK_OBJECT_HANDLE> GetObjects (CK_SESSION_HANDLE session, CK_ATTRIBUTE_TYPE objectClass);
 		static void GetObjectAttribute (CK_SLOT_ID slotId, CK_OBJECT_HANDLE tokenObject, CK_ATTRIBUTE_TYPE attributeType, vector <byte> &attributeValue);
+		static void GetSessionObjectAttribute (CK_SESSION_HANDLE session, CK_OBJECT_HANDLE tokenObject, CK_ATTRIBUTE_TYPE attributeType, vector <byte> &attributeValue);
 		static list <CK_SLOT_ID> GetTokenSlots ();
 		static void Login (CK_SLOT_ID slotId, const char* pin);
 		static void LoginUserIfRequired (CK_SLOT_ID slotId);
 		static void OpenSession (CK_SLOT_ID slotId);
+		static void ReadKeyfileObjects (CK_SESSION_HANDLE session, const SecurityTokenInfo &token, vector <SecurityTokenKeyfile> &keyfiles);
 		static void CheckLibraryStatus ();
 
 		static bool Initialized;
+		static bool MultiThreadingSupported;	// The library was initialized with OS locking
 		static unique_ptr <GetPinFunctor> PinCallback;
 		static CK_FUNCTION_LIST_PTR Pkcs11Functions;
 #ifdef TC_WINDOWS
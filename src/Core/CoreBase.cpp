@@ -12,6 +12,7 @@
 
 #include <set>
 
+#include "Platform/Time.h"
 #include "CoreBase.h"
 #include "RandomNumberGenerator.h"
 #include "Volume/Volume.h"
@@ -109,6 +110,76 @@ namespace VeraCrypt
 			options.MountPoint.reset (new DirectoryPath (SlotNumberToMountPoint (options.SlotNumber)));
 	}
 
+	uint64 CoreBase::CompactVolumeContainer (const FilePath &containerPath) const
+	{
+		if (containerPath.IsDevice())
+			throw ParameterIncorrect (SRC_POS);
+
+		if (IsVolumeMounted (wstring (containerPath)))
+			throw VolumeAlreadyMounted (SRC_POS);
+
+		File container;
+		container.Open (containerPath, File::OpenReadWrite, File::ShareNone, File::PreserveTimestamps);
+
+		// Only blocks whose ciphertext is all zeroes are deallocated, as a hole reads back
+		// as zeroes. Deallocating blocks which decrypt to zeroes would alter volume data.
+		uint64 allocatedSize = container.GetAllocatedSize();
+		uint64 containerLength = container.Length();
+		uint64 position = container.SeekData (0);
+
+		SecureBuffer buffer (File::GetOptimalReadSize());
+		size_t blockSize = File::GetSparseBlockSize();
+
+		ProgressReporter progress ("compact", wstring (containerPath), containerLength);
+
+		while (position < containerLength)
+		{
+			uint64 dataEnd = container.SeekHole (position);
+			uint64 zeroStart = position;
+
+			while (position < dataEnd)
+			{
+				size_t len = (size_t) container.ReadAt (buffer.GetRange (0, (size_t) VC_MIN (dataEnd - position, (uint64) buffer.Size())), position);
+				if (len == 0)
+					break;
+
+				for (size_t offset = 0; offset < len; offset += blockSize)
+				{
+					if (!File::IsZero (buffer.GetRange (offset, VC_MIN (len - offset, blockSize))))
+					{
+						if (position + offset > zeroStart)
+							container.PunchHole (zeroStart, position + offset - zeroStart);
+
+						zeroStart = position + VC_MIN (offset + blockSize, len);
+					}
+				}
+
+				position += len;
+				progress.Update (position);
+			}
+
+			if (position > zeroStart)
+				container.PunchHole (zeroStart, position - zeroStart);
+
+			position = container.SeekData (dataEnd);
+		}
+
+		container.Flush();
+		progress.Complete();
+
+		uint64 compactedSize = container.GetAllocatedSize();
+		return allocatedSize > compactedSize ? allocatedSize - compactedSize : 0;
+	}
+
+	void CoreBase::CopyVolumeContainer (const FilePath &sourcePath, const FilePath &destinationPath) const
+	{
+		// A copy of a mounted volume would not be consistent
+		if (IsVolumeMounted (wstring (sourcePath)))
+			throw VolumeAlreadyMounted (SRC_POS);
+
+		File::Copy (sourcePath, destinationPath, true);
+	}
+
 	void CoreBase::CreateKeyfile (const FilePath &keyfilePath) const
 	{
 		SecureBuffer keyfileBuffer (VolumePassword::MaxSize);
@@ -264,7 +335,21 @@ namespace VeraCrypt
 	shared_ptr <Volume> CoreBase::OpenVolume (shared_ptr <VolumePath> volumePath, bool preserveTimestamps, shared_ptr <VolumePassword> password, int pim, shared_ptr<Pkcs5Kdf> kdf, bool truecryptMode, shared_ptr <KeyfileList> keyfiles, VolumeProtection::Enum protection, shared_ptr <VolumePassword> protectionPassword, int protectionPim, shared_ptr<Pkcs5Kdf> protectionKdf, shared_ptr <KeyfileList> protectionKeyfiles, bool sharedAccessAllowed, VolumeType::Enum volumeType, bool useBackupHeaders, bool partitionInSystemEncryptionScope) const
 	{
 		make_shared_auto (Volume, volume);
-		volume->Open (*volumePath, preserveTimestamps, password, pim, kdf, truecryptMode, keyfiles, protection, protectionPassword, protectionPim, protectionKdf, protectionKeyfiles, sharedAccessAllowed, volumeType, useBackupHeaders, partitionInSystemEncryptionScope);
+		uint64 startTime = Time::GetMonotonic();
+
+		try
+		{
+			volume->Open (*volumePath, preserveTimestamps, password, pim, kdf, truecryptMode, keyfiles, protection, protectionPassword, protectionPim, protectionKdf, protectionKeyfiles, sharedAccessAllowed, volumeType, useBackupHeaders, partitionInSystemEncryptionScope);
+		}
+		catch (PasswordIncorrect &e)
+		{
+			// The time spent on the incorrect password is reported with the error
+			VolumeOpenStatistics statistics = volume->GetOpenStatistics();
+			statistics.TotalTime = Time::GetMonotonic() - startTime;
+			e.SetOpenStatistics (statistics);
+			throw;
+		}
+
 		return volume;
 	}
 
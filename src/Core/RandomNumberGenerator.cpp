@@ -14,6 +14,8 @@
 #include <sys/types.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #ifndef ERESTART
 #define ERESTART EINTR
@@ -21,11 +23,38 @@
 
 #endif
 
+#include "Platform/StartupProfiler.h"
+#include "Platform/Time.h"
 #include "RandomNumberGenerator.h"
 #include "Volume/Crc32.h"
+#include "Crypto/chachaRng.h"
 
 namespace VeraCrypt
 {
+	// ChaCha20 generator of a thread, which serves GetDataFast() without hash mixing the pool
+	struct RandomThreadDrbg
+	{
+		ChaCha20RngCtx Context;
+		uint64 BytesSinceReseed;
+		uint64 Generation;
+		pid_t ProcessId;
+	};
+
+	static __thread SecureBuffer *ThreadDrbg = nullptr;
+	static pthread_key_t ThreadDrbgKey;
+	static pthread_once_t ThreadDrbgKeyCreated = PTHREAD_ONCE_INIT;
+	static int ThreadDrbgKeyStatus;
+
+	static void FreeThreadDrbg (void *drbg)
+	{
+		delete static_cast <SecureBuffer *> (drbg);
+	}
+
+	static void CreateThreadDrbgKey ()
+	{
+		ThreadDrbgKeyStatus = pthread_key_create (&ThreadDrbgKey, FreeThreadDrbg);
+	}
+
 	void RandomNumberGenerator::AddSystemDataToPool (bool fast)
 	{
 		SecureBuffer buffer (PoolSize);
@@ -73,27 +102,17 @@ namespace VeraCrypt
 			}
 			
 			AddToPool (buffer);
-			
-			/* use JitterEntropy library to get good quality random bytes based on CPU timing jitter */
-			if (JitterRngCtx)
-			{
-				ssize_t rndLen = jent_read_entropy (JitterRngCtx, (char*) buffer.Ptr(), buffer.Size());
-				if (rndLen > 0)
-				{
-					AddToPool (buffer);
-				}
-			}
 		}
 #endif
 	}
 
 	void RandomNumberGenerator::AddToPool (const ConstBufferPtr &data)
 	{
+		ScopeLock lock (AccessMutex);
+
 		if (!Running)
 			throw NotInitialized (SRC_POS);
 
-		ScopeLock lock (AccessMutex);
-
 		for (size_t i = 0; i < data.Size(); ++i)
 		{
 			Pool[WriteOffset++] += data[i];
@@ -114,18 +133,15 @@ namespace VeraCrypt
 		if (!allowAnyLength && (buffer.Size() > PoolSize))
 			throw ParameterIncorrect (SRC_POS);
 
+		if (!fast)
+			WaitForMinimumEntropy();
+
 		ScopeLock lock (AccessMutex);
 		size_t bufferLen = buffer.Size(), loopLen;
 		byte* pbBuffer = buffer.Get();
-		
-		// Initialize JitterEntropy RNG for this call
-		if (0 == jent_entropy_init ())
-		{
-			JitterRngCtx = jent_entropy_collector_alloc (1, 0);
-		}
 
 		// Poll system for data
-		AddSystemDataToPool (fast);
+		AddSystemDataToPool (true);
 		HashMixPool();
 
 		while (bufferLen > 0)
@@ -170,12 +186,27 @@ namespace VeraCrypt
 
 			pbBuffer += loopLen;
 		}
-		
-		if (JitterRngCtx)
-		{
-			jent_entropy_collector_free (JitterRngCtx);
-			JitterRngCtx = NULL;
-		}
+
+		// Gather fresh entropy for the next secret in the background
+		if (!fast)
+			EntropyRequestEvent.Signal();
+	}
+
+	void RandomNumberGenerator::GetDataFast (const BufferPtr &buffer, bool allowAnyLength)
+	{
+		if (!Running)
+			throw NotInitialized (SRC_POS);
+
+		if (!allowAnyLength && (buffer.Size() > PoolSize))
+			throw ParameterIncorrect (SRC_POS);
+
+		GetThreadDrbgData (buffer);
+	}
+
+	EntropyGatheringStatistics RandomNumberGenerator::GetEntropyGatheringStatistics ()
+	{
+		ScopeLock lock (AccessMutex);
+		return GatheringStatistics;
 	}
 
 	shared_ptr <Hash> RandomNumberGenerator::GetHash ()
@@ -184,6 +215,135 @@ namespace VeraCrypt
 		return PoolHash;
 	}
 
+	void RandomNumberGenerator::GatherEntropy (uint64 generation)
+	{
+		try
+		{
+			uint64 startTime = Time::GetMonotonic();
+
+			struct rand_data *jitterRngCtx = nullptr;
+			if (jent_entropy_init() == 0)
+				jitterRngCtx = jent_entropy_collector_alloc (1, 0);
+
+			finally_do_arg (struct rand_data *, jitterRngCtx, { if (finally_arg) jent_entropy_collector_free (finally_arg); });
+
+			uint64 jitterInitTime = Time::GetMonotonic() - startTime;
+			SecureBuffer buffer (PoolSize);
+
+			while (true)
+			{
+				{
+					ScopeLock lock (AccessMutex);
+					if (!Running || generation != PoolGeneration)
+						break;
+				}
+
+				uint64 devRandomStartTime = Time::GetMonotonic();
+				AddSystemDataToPool (false);
+
+				uint64 jitterStartTime = Time::GetMonotonic();
+				ssize_t jitterLength = 0;
+
+				// Random bytes of good quality based on CPU timing jitter
+				if (jitterRngCtx)
+				{
+					jitterLength = jent_read_entropy (jitterRngCtx, (char *) buffer.Ptr(), buffer.Size());
+					if (jitterLength > 0)
+						AddToPool (buffer.GetRange (0, (size_t) jitterLength));
+				}
+
+				uint64 endTime = Time::GetMonotonic();
+
+				{
+					ScopeLock lock (AccessMutex);
+					if (!Running || generation != PoolGeneration)
+						break;
+
+					GatheringStatistics.DevRandomTime += jitterStartTime - devRandomStartTime;
+					GatheringStatistics.GatheredBytes += PoolSize + (jitterLength > 0 ? jitterLength : 0);
+					GatheringStatistics.JitterInitTime = jitterInitTime;
+					GatheringStatistics.JitterTime += endTime - jitterStartTime;
+					++GatheringStatistics.RoundCount;
+
+					if (!MinimumEntropyGathered)
+					{
+						GatheringStatistics.MinimumEntropyTime = endTime - GatheringStartTime;
+						MinimumEntropyGathered = true;
+						StartupProfiler::Mark ("entropy gathering");
+					}
+				}
+
+				EntropyGatheredEvent.Signal();
+				EntropyRequestEvent.Wait();
+			}
+		}
+		catch (Exception &e)
+		{
+			ScopeLock lock (AccessMutex);
+			if (generation == PoolGeneration)
+				GatheringException.reset (e.CloneNew());
+		}
+		catch (exception &e)
+		{
+			ScopeLock lock (AccessMutex);
+			if (generation == PoolGeneration)
+				GatheringException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+		}
+
+		EntropyGatheredEvent.Signal();
+	}
+
+	void RandomNumberGenerator::GetThreadDrbgData (const BufferPtr &buffer)
+	{
+		pthread_once (&ThreadDrbgKeyCreated, CreateThreadDrbgKey);
+
+		if (!ThreadDrbg)
+		{
+			if (ThreadDrbgKeyStatus != 0)
+				throw bad_alloc();
+
+			ThreadDrbg = new SecureBuffer (sizeof (RandomThreadDrbg), 16);
+			ThreadDrbg->Zero();
+			pthread_setspecific (ThreadDrbgKey, ThreadDrbg);
+		}
+
+		RandomThreadDrbg &drbg = *reinterpret_cast <RandomThreadDrbg *> (ThreadDrbg->Ptr());
+
+		for (size_t offset = 0; offset < buffer.Size(); )
+		{
+			size_t length = buffer.Size() - offset;
+			if (length > MaxDrbgBytesBeforeReseed)
+				length = MaxDrbgBytesBeforeReseed;
+
+			{
+				ScopeLock lock (AccessMutex);
+
+				if (!Running)
+					throw NotInitialized (SRC_POS);
+
+				// Generators seeded before the pool was restarted are reseeded as well. A child process
+				// inherits the state of the forking thread, which must not produce the same output as the parent.
+				pid_t processId = getpid();
+
+				if (drbg.Generation != PoolGeneration || drbg.ProcessId != processId || drbg.BytesSinceReseed + length > MaxDrbgBytesBeforeReseed)
+				{
+					SecureBuffer seed (CHACHA20RNG_KEYSZ + CHACHA20RNG_IVSZ);
+					seed.Zero();
+					GetData (seed, true, false);
+
+					ChaCha20RngInit (&drbg.Context, seed, nullptr, 0);
+					drbg.BytesSinceReseed = 0;
+					drbg.Generation = PoolGeneration;
+					drbg.ProcessId = processId;
+				}
+			}
+
+			ChaCha20RngGetBytes (&drbg.Context, buffer.Get() + offset, length);
+			drbg.BytesSinceReseed += length;
+			offset += length;
+		}
+	}
+
 	void RandomNumberGenerator::HashMixPool ()
 	{
 		BytesAddedSincePoolHashMix = 0;
@@ -219,8 +379,13 @@ namespace VeraCrypt
 		BytesAddedSincePoolHashMix = 0;
 		ReadOffset = 0;
 		WriteOffset = 0;
+		++PoolGeneration;
 		Running = true;
 		EnrichedByUser = false;
+		GatheringException.reset();
+		GatheringStartTime = Time::GetMonotonic();
+		GatheringStatistics = EntropyGatheringStatistics();
+		MinimumEntropyGathered = false;
 
 		Pool.Allocate (PoolSize, 16);
 		Test();
@@ -232,21 +397,81 @@ namespace VeraCrypt
 		}
 
 		AddSystemDataToPool (true);
+
+		// /dev/random and the jitter collector may take long to provide entropy, which is
+		// therefore gathered while the user is prompted and waited for only by GetData()
+		struct GatheringThreadFunctor : public Functor
+		{
+			GatheringThreadFunctor (uint64 generation) : Generation (generation) { }
+			virtual void operator() ()
+			{
+				RandomNumberGenerator::GatherEntropy (Generation);
+			}
+			uint64 Generation;
+		};
+
+		GatheringThread.reset (new Thread);
+		GatheringThread->Start (new GatheringThreadFunctor (PoolGeneration));
+
+		StartupProfiler::Mark ("random number generator");
 	}
 
 	void RandomNumberGenerator::Stop ()
 	{
-		ScopeLock lock (AccessMutex);
+		shared_ptr <Thread> gatheringThread;
+
+		{
+			ScopeLock lock (AccessMutex);
 
-		if (Pool.IsAllocated())
-			Pool.Free ();
+			if (Pool.IsAllocated())
+				Pool.Free ();
 
-		PoolHash.reset();
+			PoolHash.reset();
+			++PoolGeneration;
 
-		EnrichedByUser = false;
-		Running = false;
-		DevRandomSucceeded = false;
-		DevRandomBytesCount = 0;
+			EnrichedByUser = false;
+			Running = false;
+			DevRandomSucceeded = false;
+			DevRandomBytesCount = 0;
+
+			gatheringThread = GatheringThread;
+			GatheringThread.reset();
+
+			// Wake the gathering thread and callers waiting for entropy
+			EntropyRequestEvent.Signal();
+			EntropyGatheredEvent.Signal();
+		}
+
+		// The thread acquires AccessMutex before it exits
+		if (gatheringThread)
+			gatheringThread->Join();
+	}
+
+	void RandomNumberGenerator::WaitForMinimumEntropy ()
+	{
+		ScopeLock gateLock (EntropyGateMutex);
+		uint64 startTime = Time::GetMonotonic();
+
+		while (true)
+		{
+			{
+				ScopeLock lock (AccessMutex);
+
+				if (!Running)
+					throw NotInitialized (SRC_POS);
+
+				if (GatheringException)
+					GatheringException->Throw();
+
+				if (MinimumEntropyGathered)
+				{
+					GatheringStatistics.WaitTime += Time::GetMonotonic() - startTime;
+					return;
+				}
+			}
+
+			EntropyGatheredEvent.Wait();
+		}
 	}
 
 	void RandomNumberGenerator::Test ()
@@ -272,18 +497,39 @@ namespace VeraCrypt
 		if (Crc32::ProcessBuffer (Pool) != 0xcb88e019)
 			throw TestFailed (SRC_POS);
 
+		ChaCha20RngCtx drbgContext;
+		byte drbgSeed[CHACHA20RNG_KEYSZ + CHACHA20RNG_IVSZ];
+		for (size_t i = 0; i < sizeof (drbgSeed); ++i)
+			drbgSeed[i] = (byte) i;
+
+		ChaCha20RngInit (&drbgContext, drbgSeed, nullptr, 0);
+		buffer.Allocate (CHACHA20RNG_RSBUFSZ * 4);
+		ChaCha20RngGetBytes (&drbgContext, buffer, buffer.Size());
+		burn (&drbgContext, sizeof (drbgContext));
+
+		if (Crc32::ProcessBuffer (buffer) != 0x844f104c)
+			throw TestFailed (SRC_POS);
+
 		PoolHash = origPoolHash;
 	}
 
 	Mutex RandomNumberGenerator::AccessMutex;
 	size_t RandomNumberGenerator::BytesAddedSincePoolHashMix;
 	bool RandomNumberGenerator::EnrichedByUser;
+	Mutex RandomNumberGenerator::EntropyGateMutex;
+	SyncEvent RandomNumberGenerator::EntropyGatheredEvent;
+	SyncEvent RandomNumberGenerator::EntropyRequestEvent;
+	shared_ptr <Exception> RandomNumberGenerator::GatheringException;
+	uint64 RandomNumberGenerator::GatheringStartTime;
+	EntropyGatheringStatistics RandomNumberGenerator::GatheringStatistics;
+	shared_ptr <Thread> RandomNumberGenerator::GatheringThread;
+	bool RandomNumberGenerator::MinimumEntropyGathered = false;
 	SecureBuffer RandomNumberGenerator::Pool;
+	uint64 RandomNumberGenerator::PoolGeneration = 0;
 	shared_ptr <Hash> RandomNumberGenerator::PoolHash;
 	size_t RandomNumberGenerator::ReadOffset;
 	bool RandomNumberGenerator::Running = false;
 	size_t RandomNumberGenerator::WriteOffset;
-	struct rand_data *RandomNumberGenerator::JitterRngCtx = NULL;
 	bool RandomNumberGenerator::DevRandomSucceeded = false;
 	int RandomNumberGenerator::DevRandomBytesCount = 0;
 }
@@ -20,12 +20,26 @@
 
 namespace VeraCrypt
 {
+	struct EntropyGatheringStatistics
+	{
+		EntropyGatheringStatistics () : DevRandomTime (0), GatheredBytes (0), JitterInitTime (0), JitterTime (0), MinimumEntropyTime (0), RoundCount (0), WaitTime (0) { }
+
+		uint64 DevRandomTime;		// Nanoseconds spent reading /dev/random
+		uint64 GatheredBytes;		// Bytes added from /dev/random and the jitter collector
+		uint64 JitterInitTime;		// Nanoseconds spent testing and allocating the jitter collector
+		uint64 JitterTime;			// Nanoseconds spent reading the jitter collector
+		uint64 MinimumEntropyTime;	// Nanoseconds from Start() until the first round completed
+		uint64 RoundCount;
+		uint64 WaitTime;			// Nanoseconds GetData() was blocked waiting for the first round
+	};
+
 	class RandomNumberGenerator
 	{
 	public:
 		static void AddToPool (const ConstBufferPtr &buffer);
 		static void GetData (const BufferPtr &buffer, bool allowAnyLength = false) { GetData (buffer, false, allowAnyLength); }
-		static void GetDataFast (const BufferPtr &buffer, bool allowAnyLength = false) { GetData (buffer, true, allowAnyLength); }
+		static void GetDataFast (const BufferPtr &buffer, bool allowAnyLength = false);
+		static EntropyGatheringStatistics GetEntropyGatheringStatistics ();
 		static shared_ptr <Hash> GetHash ();
 		static bool IsEnrichedByUser () { return EnrichedByUser; }
 		static bool IsRunning () { return Running; }
@@ -39,22 +53,34 @@ namespace VeraCrypt
 
 	protected:
 		static void AddSystemDataToPool (bool fast);
+		static void GatherEntropy (uint64 generation);
 		static void GetData (const BufferPtr &buffer, bool fast, bool allowAnyLength);
+		static void GetThreadDrbgData (const BufferPtr &buffer);
 		static void HashMixPool ();
 		static void Test ();
+		static void WaitForMinimumEntropy ();
 		RandomNumberGenerator ();
 
 		static const size_t MaxBytesAddedBeforePoolHashMix = RANDMIX_BYTE_INTERVAL;
+		static const uint64 MaxDrbgBytesBeforeReseed = 1024 * 1024;
 
 		static Mutex AccessMutex;
 		static size_t BytesAddedSincePoolHashMix;
 		static bool EnrichedByUser;
+		static Mutex EntropyGateMutex;
+		static SyncEvent EntropyGatheredEvent;
+		static SyncEvent EntropyRequestEvent;
+		static shared_ptr <Exception> GatheringException;
+		static uint64 GatheringStartTime;
+		static EntropyGatheringStatistics GatheringStatistics;
+		static shared_ptr <Thread> GatheringThread;
+		static bool MinimumEntropyGathered;
 		static SecureBuffer Pool;
+		static uint64 PoolGeneration;		// Incremented when the generator is started or stopped
 		static shared_ptr <Hash> PoolHash;
 		static size_t ReadOffset;
 		static bool Running;
 		static size_t WriteOffset;
-		static struct rand_data *JitterRngCtx;
 		static bool DevRandomSucceeded;
 		static int DevRandomBytesCount;
 	};
@@ -188,6 +188,10 @@ namespace VeraCrypt
 					MountVolumeRequest *mountRequest = dynamic_cast <MountVolumeRequest*> (request.get());
 					if (mountRequest)
 					{
+						// The volume is opened, and its FUSE service forked, in this process
+						if (mountRequest->HostCalibrated)
+							Calibration::Apply (mountRequest->HostCalibration);
+
 						MountVolumeResponse (
 							Core->MountVolume (*mountRequest->Options)
 						).Serialize (outputStream);
@@ -538,7 +542,7 @@ namespace VeraCrypt
 
 			try
 			{
-				shared_ptr <Stream> stream (new MemoryStream (ConstBufferPtr ((byte *) &errOutput[0], errOutput.size())));
+				shared_ptr <Stream> stream (new MemoryReadStream (ConstBufferPtr ((byte *) &errOutput[0], errOutput.size())));
 				deserializedObject.reset (Serializable::DeserializeNew (stream));
 				deserializedException = dynamic_cast <Exception*> (deserializedObject.get());
 			}
@@ -13,7 +13,9 @@
 #ifndef TC_HEADER_Core_Windows_CoreServiceProxy
 #define TC_HEADER_Core_Windows_CoreServiceProxy
 
+#include "Platform/Time.h"
 #include "CoreService.h"
+#include "Volume/KeyfileCache.h"
 #include "Volume/VolumePasswordCache.h"
 
 namespace VeraCrypt
@@ -77,6 +79,10 @@ namespace VeraCrypt
 				finally_do_arg (MountOptions*, &options, { if (finally_arg->Password) finally_arg->Password.reset(); });
 
 				PasswordIncorrect passwordException;
+
+				// Time spent on the cached passwords that failed, which is reported with the result
+				VolumeOpenStatistics failedStatistics;
+
 				foreach (shared_ptr <VolumePassword> password, VolumePasswordCache::GetPasswords())
 				{
 					try
@@ -87,46 +93,84 @@ namespace VeraCrypt
 					}
 					catch (PasswordIncorrect &e)
 					{
+						VolumeOpenStatistics statistics = e.GetOpenStatistics();
+						for (KdfTrialList::iterator trial = statistics.KdfTrials.begin(); trial != statistics.KdfTrials.end(); ++trial)
+							trial->Source = L"cache";
+
+						failedStatistics.Add (statistics);
+						failedStatistics.TotalTime += statistics.TotalTime;
 						passwordException = e;
 					}
 				}
 
 				if (!mountedVolume)
+				{
+					passwordException.SetOpenStatistics (failedStatistics);
 					passwordException.Throw();
+				}
+
+				mountedVolume->OpenStatistics.Add (failedStatistics);
+				mountedVolume->OpenStatistics.TotalTime += failedStatistics.TotalTime;
 			}
 			else
 			{
 				MountOptions newOptions = options;
 
-				newOptions.Password = Keyfile::ApplyListToPassword (options.Keyfiles, options.Password);
+				// Keyfiles are applied here, so the service does not measure the time spent on them
+				uint64 keyfileStartTime = Time::GetMonotonic();
+
+				newOptions.Password = Keyfile::ApplyListToPassword (options.Keyfiles, options.Password, options.CachePassword);
 				if (newOptions.Keyfiles)
 					newOptions.Keyfiles->clear();
 
-				newOptions.ProtectionPassword = Keyfile::ApplyListToPassword (options.ProtectionKeyfiles, options.ProtectionPassword);
+				newOptions.ProtectionPassword = Keyfile::ApplyListToPassword (options.ProtectionKeyfiles, options.ProtectionPassword, options.CachePassword);
 				if (newOptions.ProtectionKeyfiles)
 					newOptions.ProtectionKeyfiles->clear();
 
+				uint64 keyfileTime = Time::GetMonotonic() - keyfileStartTime;
+
 				try
 				{
 					mountedVolume = CoreService::RequestMountVolume (newOptions);
 				}
 				catch (ProtectionPasswordIncorrect &e)
 				{
+					VolumeOpenStatistics statistics = e.GetOpenStatistics();
+					statistics.KeyfileTime += keyfileTime;
+					statistics.TotalTime += keyfileTime;
+					e.SetOpenStatistics (statistics);
+
 					if (options.ProtectionKeyfiles && !options.ProtectionKeyfiles->empty())
-						throw ProtectionPasswordKeyfilesIncorrect (e.what());
+					{
+						ProtectionPasswordKeyfilesIncorrect keyfilesException (e.what());
+						keyfilesException.SetOpenStatistics (statistics);
+						throw keyfilesException;
+					}
 					throw;
 				}
 				catch (PasswordIncorrect &e)
 				{
+					VolumeOpenStatistics statistics = e.GetOpenStatistics();
+					statistics.KeyfileTime += keyfileTime;
+					statistics.TotalTime += keyfileTime;
+					e.SetOpenStatistics (statistics);
+
 					if (options.Keyfiles && !options.Keyfiles->empty())
-						throw PasswordKeyfilesIncorrect (e.what());
+					{
+						PasswordKeyfilesIncorrect keyfilesException (e.what());
+						keyfilesException.SetOpenStatistics (statistics);
+						throw keyfilesException;
+					}
 					throw;
 				}
 
+				mountedVolume->OpenStatistics.KeyfileTime += keyfileTime;
+				mountedVolume->OpenStatistics.TotalTime += keyfileTime;
+
 				if (options.CachePassword
 					&& ((options.Password && !options.Password->IsEmpty()) || (options.Keyfiles && !options.Keyfiles->empty())))
 				{
-					VolumePasswordCache::Store (*Keyfile::ApplyListToPassword (options.Keyfiles, options.Password));
+					VolumePasswordCache::Store (*Keyfile::ApplyListToPassword (options.Keyfiles, options.Password, true));
 				}
 			}
 
@@ -149,6 +193,7 @@ namespace VeraCrypt
 		virtual void WipePasswordCache () const
 		{
 			VolumePasswordCache::Clear();
+			KeyfileCache::Clear();
 		}
 	};
 }
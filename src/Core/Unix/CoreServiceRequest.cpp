@@ -200,6 +200,10 @@ namespace VeraCrypt
 		Serializer sr (stream);
 		DeserializedOptions = Serializable::DeserializeNew <MountOptions> (stream);
 		Options = DeserializedOptions.get();
+
+		sr.Deserialize ("HostCalibrated", HostCalibrated);
+		if (HostCalibrated)
+			HostCalibration.Deserialize (sr, "HostCalibration");
 	}
 
 	bool MountVolumeRequest::RequiresElevation () const
@@ -228,6 +232,10 @@ namespace VeraCrypt
 		CoreServiceRequest::Serialize (stream);
 		Serializer sr (stream);
 		Options->Serialize (stream);
+
+		sr.Serialize ("HostCalibrated", HostCalibrated);
+		if (HostCalibrated)
+			HostCalibration.Serialize (sr, "HostCalibration");
 	}
 
 	// SetFileOwnerRequest
@@ -15,6 +15,7 @@
 
 #include "Platform/Serializable.h"
 #include "Core/Core.h"
+#include "Volume/Calibration.h"
 
 namespace VeraCrypt
 {
@@ -112,11 +113,14 @@ namespace VeraCrypt
 	struct MountVolumeRequest : CoreServiceRequest
 	{
 		MountVolumeRequest () { }
-		MountVolumeRequest (MountOptions *options) : Options (options) { }
+		MountVolumeRequest (MountOptions *options) : HostCalibrated (Calibration::IsCalibrated()), HostCalibration (Calibration::Get()), Options (options) { }
 		TC_SERIALIZABLE (MountVolumeRequest);
 
 		virtual bool RequiresElevation () const;
 
+		// Calibration of the host, applied by the service before the volume is opened
+		bool HostCalibrated;
+		CalibrationData HostCalibration;
 		MountOptions *Options;
 
 	protected:
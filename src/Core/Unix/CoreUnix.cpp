@@ -18,7 +18,7 @@
 #include <sys/types.h>
 #include <stdio.h>
 #include <unistd.h>
-#include "Platform/FileStream.h"
+#include "Platform/MemoryStream.h"
 #include "Driver/Fuse/FuseService.h"
 #include "Volume/VolumePasswordCache.h"
 
@@ -291,8 +291,15 @@ namespace VeraCrypt
 				shared_ptr <File> controlFile (new File);
 				controlFile->Open (string (mf.MountPoint) + FuseService::GetControlPath());
 
-				shared_ptr <Stream> controlFileStream (new FileStream (controlFile));
-				mountedVol = Serializable::DeserializeNew <VolumeInfo> (controlFileStream);
+				// The control file is read at once, as each read from it is a request to the FUSE service
+				shared_ptr <MemoryStream> controlFileData (new MemoryStream);
+				Buffer readBuffer (File::GetOptimalReadSize());
+				uint64 length;
+
+				while ((length = controlFile->Read (readBuffer)) > 0)
+					controlFileData->Write (readBuffer.GetRange (0, (size_t) length));
+
+				mountedVol = Serializable::DeserializeNew <VolumeInfo> (controlFileData);
 			}
 			catch (...)
 			{
@@ -21,6 +21,7 @@
 #include "CoreLinux.h"
 #include "Platform/SystemInfo.h"
 #include "Platform/TextReader.h"
+#include "Platform/Tracepoint.h"
 #include "Volume/EncryptionModeXTS.h"
 #include "Driver/Fuse/FuseService.h"
 #include "Core/Unix/CoreServiceProxy.h"
@@ -78,9 +79,12 @@ namespace VeraCrypt
 			args.push_back (loopDev);
 			args.push_back (filePath);
 
+			TC_TRACE2 (loop_attach_start, loopDev.c_str(), (int) readOnly);
+
 			try
 			{
 				Process::Execute ("losetup", args);
+				TC_TRACE2 (loop_attach_done, loopDev.c_str(), 0);
 				return loopDev;
 			}
 			catch (ExecutedProcessFailed&)
@@ -91,10 +95,13 @@ namespace VeraCrypt
 					{
 						args.erase (readOnlyArg);
 						Process::Execute ("losetup", args);
+						TC_TRACE2 (loop_attach_done, loopDev.c_str(), 0);
 						return loopDev;
 					}
 					catch (ExecutedProcessFailed&) { }
 				}
+
+				TC_TRACE2 (loop_attach_done, loopDev.c_str(), -1);
 			}
 		}
 
@@ -107,11 +114,14 @@ namespace VeraCrypt
 		args.push_back ("-d");
 		args.push_back (devicePath);
 
+		TC_TRACE1 (loop_detach_start, args.back().c_str());
+
 		for (int t = 0; true; t++)
 		{
 			try
 			{
 				Process::Execute ("losetup", args);
+				TC_TRACE2 (loop_detach_done, args.back().c_str(), t);
 				break;
 			}
 			catch (ExecutedProcessFailed&)
@@ -137,11 +147,14 @@ namespace VeraCrypt
 			dmsetupArgs.push_back ("remove");
 			dmsetupArgs.push_back (StringConverter::Split (devPath, "/").back());
 
+			TC_TRACE1 (dm_remove_start, devPath.c_str());
+
 			for (int t = 0; true; t++)
 			{
 				try
 				{
 					Process::Execute ("dmsetup", dmsetupArgs);
+					TC_TRACE2 (dm_remove_done, devPath.c_str(), t);
 					break;
 				}
 				catch (...)
@@ -408,6 +421,7 @@ namespace VeraCrypt
 				execArgs.push_back ("create");
 				execArgs.push_back (nativeDevName.str());
 
+				TC_TRACE2 (dm_create_start, nativeDevPath.c_str(), nativeDevCount);
 				Process::Execute ("dmsetup", execArgs, -1, nullptr, &dmCreateArgsBuf);
 
 				// Wait for the device to be created
@@ -427,11 +441,13 @@ namespace VeraCrypt
 					}
 				}
 
+				TC_TRACE2 (dm_create_done, nativeDevPath.c_str(), nativeDevCount);
 				nativeDevCreated = true;
 				++nativeDevCount;
 			}
 
 			// Test whether the device mapper is able to read and decrypt the last sector
+			TC_TRACE1 (dm_test_start, nativeDevPath.c_str());
 			SecureBuffer lastSectorBuf (volume->GetSectorSize());
 			uint64 lastSectorOffset = volume->GetSize() - volume->GetSectorSize();
 
@@ -445,15 +461,19 @@ namespace VeraCrypt
 			if (memcmp (lastSectorBuf.Ptr(), lastSectorBuf2.Ptr(), volume->GetSectorSize()) != 0)
 				throw KernelCryptoServiceTestFailed (SRC_POS);
 
+			TC_TRACE1 (dm_test_done, nativeDevPath.c_str());
+
 			// Mount filesystem
 			if (!options.NoFilesystem && options.MountPoint && !options.MountPoint->IsEmpty())
 			{
+				TC_TRACE1 (filesystem_mount_start, nativeDevPath.c_str());
 				MountFilesystem (nativeDevPath, *options.MountPoint,
 					StringConverter::ToSingle (options.FilesystemType),
 					options.Protection == VolumeProtection::ReadOnly,
 					StringConverter::ToSingle (options.FilesystemOptions));
 
 				filesystemMounted = true;
+				TC_TRACE1 (filesystem_mount_done, nativeDevPath.c_str());
 			}
 
 			FuseService::SendAuxDeviceInfo (auxMountPoint, nativeDevPath, volumePath);
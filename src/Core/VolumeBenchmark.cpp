@@ -0,0 +1,399 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "Platform/SystemException.h"
+#include "Platform/Time.h"
+#include "VolumeBenchmark.h"
+#include "VolumeCreator.h"
+
+namespace VeraCrypt
+{
+	string VolumeBenchmarkWorkload::GetName () const
+	{
+		stringstream name;
+		name << (Random ? "rand" : "seq");
+
+		if (ReadPercentage >= 100)
+			name << "read";
+		else if (ReadPercentage == 0)
+			name << "write";
+		else
+			name << "rw" << ReadPercentage;
+
+		name << "-";
+		if (BlockSize % BYTES_PER_MB == 0)
+			name << BlockSize / BYTES_PER_MB << "M";
+		else if (BlockSize % BYTES_PER_KB == 0)
+			name << BlockSize / BYTES_PER_KB << "K";
+		else
+			name << BlockSize;
+
+		name << "-qd" << QueueDepth << "-j" << ThreadCount;
+		return name.str();
+	}
+
+	JsonObject VolumeBenchmarkResult::ToJson () const
+	{
+		JsonObject json;
+		json.Add ("category", "volume");
+		json.Add ("workload", Workload.GetName());
+		json.Add ("pattern", Workload.Random ? "random" : "sequential");
+		json.Add ("block_size", (uint64) Workload.BlockSize);
+		json.Add ("queue_depth", (uint64) Workload.QueueDepth);
+		json.Add ("threads", (uint64) Workload.ThreadCount);
+		json.Add ("read_percentage", Workload.ReadPercentage);
+		json.Add ("elapsed_s", Elapsed);
+		json.Add ("reads", ReadCount);
+		json.Add ("writes", WriteCount);
+		json.Add ("iops", GetIops());
+		json.Add ("throughput_bps", GetThroughput());
+		json.Add ("lat_mean_us", LatencyMean);
+		json.Add ("lat_p50_us", LatencyP50);
+		json.Add ("lat_p90_us", LatencyP90);
+		json.Add ("lat_p99_us", LatencyP99);
+		json.Add ("lat_p999_us", LatencyP999);
+		json.Add ("lat_max_us", LatencyMax);
+		return json;
+	}
+
+	VolumeBenchmark::VolumeBenchmark (const VolumeBenchmarkOptions &options)
+		: ContainerCreated (false), Options (options)
+	{
+	}
+
+	VolumeBenchmark::~VolumeBenchmark ()
+	{
+		try
+		{
+			if (BenchmarkVolume)
+				BenchmarkVolume->Close();
+		}
+		catch (...) { }
+
+		if (ContainerCreated)
+		{
+			try
+			{
+				FilesystemPath (wstring (Options.ContainerPath)).Delete();
+			}
+			catch (...) { }
+		}
+	}
+
+	void VolumeBenchmark::CreateContainer ()
+	{
+		// The file is created exclusively and is then reused by VolumeCreator, so that a file or
+		// link planted at the path (e.g., in a shared temporary directory) is never written
+		if (Options.ContainerPath.IsEmpty())
+		{
+			const char *tempDir = getenv ("TMPDIR");
+			string path = string (tempDir ? tempDir : "/tmp") + "/.veracrypt-benchmark-XXXXXX";
+
+			vector <char> pathBuffer (path.begin(), path.end());
+			pathBuffer.push_back (0);
+
+			int fd = mkstemp (&pathBuffer.front());
+			throw_sys_sub_if (fd == -1, StringConverter::ToWide (path));
+			close (fd);
+
+			Options.ContainerPath = FilePath (StringConverter::ToWide (string (&pathBuffer.front())));
+		}
+		else
+		{
+			int fd = open (string (Options.ContainerPath).c_str(), O_CREAT | O_EXCL | O_NOFOLLOW | O_WRONLY, S_IRUSR | S_IWUSR);
+
+			// An existing file is never overwritten
+			if (fd == -1 && errno == EEXIST)
+				throw ParameterIncorrect (SRC_POS);
+
+			throw_sys_sub_if (fd == -1, wstring (Options.ContainerPath));
+			close (fd);
+		}
+
+		ContainerCreated = true;
+
+		make_shared_auto (VolumeCreationOptions, options);
+		options->Path = VolumePath (wstring (Options.ContainerPath));
+		options->Type = VolumeType::Normal;
+		options->Size = Options.ContainerSize;
+		options->Password.reset (new VolumePassword ((const byte *) "benchmark", 9));
+		options->Pim = 1;	// Lowest iteration count; key derivation is not measured
+		options->VolumeHeaderKdf = Pkcs5Kdf::GetAlgorithm (Sha512(), false);
+		options->EA = Options.EA ? Options.EA->GetNew() : shared_ptr <EncryptionAlgorithm> (new AES());
+		options->Filesystem = VolumeCreationOptions::FilesystemType::None;
+		options->FilesystemClusterSize = 0;
+		options->Quick = false;
+
+		RandomNumberGenerator::Start();
+
+		VolumeCreator creator;
+		creator.CreateVolume (options);
+
+		while (creator.GetProgressInfo().CreationInProgress)
+			Thread::Sleep (50);
+
+		creator.CheckResult();
+
+		BenchmarkVolume.reset (new Volume);
+		BenchmarkVolume->Open (options->Path, false, options->Password, options->Pim, options->VolumeHeaderKdf, false, shared_ptr <KeyfileList> ());
+	}
+
+	list <VolumeBenchmarkWorkload> VolumeBenchmark::GetDefaultWorkloads ()
+	{
+		list <VolumeBenchmarkWorkload> workloads;
+		VolumeBenchmarkWorkload workload;
+
+		workload.BlockSize = 1 * BYTES_PER_MB;
+		workload.ReadPercentage = 100;
+		workloads.push_back (workload);
+
+		workload.ReadPercentage = 0;
+		workloads.push_back (workload);
+
+		workload.Random = true;
+		workload.BlockSize = 4 * BYTES_PER_KB;
+		workload.ReadPercentage = 100;
+		workloads.push_back (workload);
+
+		workload.QueueDepth = 16;
+		workloads.push_back (workload);
+
+		workload.QueueDepth = 4;
+		workload.ThreadCount = 4;
+		workloads.push_back (workload);
+
+		workload.QueueDepth = 1;
+		workload.ThreadCount = 1;
+		workload.ReadPercentage = 0;
+		workloads.push_back (workload);
+
+		workload.QueueDepth = 16;
+		workloads.push_back (workload);
+
+		workload.QueueDepth = 4;
+		workload.ReadPercentage = 70;
+		workloads.push_back (workload);
+
+		workload.BlockSize = 64 * BYTES_PER_KB;
+		workload.ReadPercentage = 100;
+		workloads.push_back (workload);
+
+		return workloads;
+	}
+
+	list <VolumeBenchmarkResult> VolumeBenchmark::Run (VolumeBenchmarkListener *listener)
+	{
+		list <VolumeBenchmarkResult> results;
+
+		if (!BenchmarkVolume)
+			CreateContainer();
+
+		list <VolumeBenchmarkWorkload> workloads = Options.Workloads;
+		if (workloads.empty())
+			workloads = GetDefaultWorkloads();
+
+		foreach (const VolumeBenchmarkWorkload &workload, workloads)
+		{
+			results.push_back (RunWorkload (workload));
+			if (listener)
+				(*listener) (results.back());
+		}
+
+		return results;
+	}
+
+	VolumeBenchmarkResult VolumeBenchmark::RunWorkload (const VolumeBenchmarkWorkload &workload)
+	{
+		uint64 dataSize = BenchmarkVolume->GetSize();
+		size_t workerCount = workload.ThreadCount * workload.QueueDepth;
+
+		if (workload.BlockSize == 0
+			|| workload.BlockSize % BenchmarkVolume->GetSectorSize() != 0
+			|| workload.BlockSize > dataSize
+			|| workerCount < 1
+			|| workerCount > 256)
+		{
+			throw ParameterIncorrect (SRC_POS);
+		}
+
+		struct WorkerState
+		{
+			WorkerState () : BytesRead (0), BytesWritten (0), ReadCount (0), WriteCount (0) { }
+
+			uint64 BytesRead;
+			uint64 BytesWritten;
+			vector <uint64> Latencies;
+			uint64 ReadCount;
+			shared_ptr <Exception> ThreadException;
+			uint64 WriteCount;
+		};
+
+		struct WorkerFunctor : public Functor
+		{
+			WorkerFunctor (shared_ptr <Volume> volume, const VolumeBenchmarkWorkload &workload, WorkerState &state, uint64 regionStart, uint64 regionSize, uint64 seed, uint64 endTime)
+				: EndTime (endTime), RegionSize (regionSize), RegionStart (regionStart), Seed (seed), State (state), BenchmarkVolume (volume), Workload (workload) { }
+
+			virtual void operator() ()
+			{
+				try
+				{
+					Buffer buffer (Workload.BlockSize);
+					for (size_t i = 0; i < buffer.Size(); ++i)
+						buffer[i] = (byte) (i * 7 + Seed);
+
+					uint64 blockCount = RegionSize / Workload.BlockSize;
+					uint64 position = 0;
+					uint64 random = Seed | 1;
+
+					State.Latencies.reserve (64 * 1024);
+
+					while (Time::GetMonotonic() < EndTime)
+					{
+						uint64 offset;
+						if (Workload.Random)
+							offset = RegionStart + (NextRandom (random) % blockCount) * Workload.BlockSize;
+						else
+						{
+							offset = RegionStart + position * Workload.BlockSize;
+							if (++position >= blockCount)
+								position = 0;
+						}
+
+						bool read = Workload.ReadPercentage >= 100
+							|| (Workload.ReadPercentage > 0 && NextRandom (random) % 100 < Workload.ReadPercentage);
+
+						uint64 startTime = Time::GetMonotonic();
+
+						if (read)
+							BenchmarkVolume->ReadSectors (buffer, offset);
+						else
+							BenchmarkVolume->WriteSectors (buffer, offset);
+
+						State.Latencies.push_back (Time::GetMonotonic() - startTime);
+
+						if (read)
+						{
+							++State.ReadCount;
+							State.BytesRead += Workload.BlockSize;
+						}
+						else
+						{
+							++State.WriteCount;
+							State.BytesWritten += Workload.BlockSize;
+						}
+					}
+				}
+				catch (Exception &e)
+				{
+					State.ThreadException.reset (e.CloneNew());
+				}
+				catch (exception &e)
+				{
+					State.ThreadException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+				}
+				catch (...)
+				{
+					State.ThreadException.reset (new UnknownException (SRC_POS));
+				}
+			}
+
+			// xorshift64: offsets only need to be spread evenly, not unpredictably
+			static uint64 NextRandom (uint64 &state)
+			{
+				state ^= state << 13;
+				state ^= state >> 7;
+				state ^= state << 17;
+				return state;
+			}
+
+			uint64 EndTime;
+			uint64 RegionSize;
+			uint64 RegionStart;
+			uint64 Seed;
+			WorkerState &State;
+			shared_ptr <Volume> BenchmarkVolume;
+			const VolumeBenchmarkWorkload &Workload;
+		};
+
+		// Each submitter of a sequential workload streams through its own region of the volume
+		uint64 regionSize = dataSize;
+		if (!workload.Random && dataSize / workerCount >= workload.BlockSize)
+			regionSize = (dataSize / workerCount) / workload.BlockSize * workload.BlockSize;
+
+		vector <WorkerState> states (workerCount);
+		list < shared_ptr <Thread> > threads;
+
+		uint64 startTime = Time::GetMonotonic();
+		uint64 endTime = startTime + Options.Duration * 1000000ULL;
+
+		for (size_t i = 0; i < workerCount; ++i)
+		{
+			uint64 regionStart = (regionSize == dataSize) ? 0 : i * regionSize;
+
+			make_shared_auto (Thread, thread);
+			thread->Start (new WorkerFunctor (BenchmarkVolume, workload, states[i], regionStart, regionSize, 0x9E3779B97F4A7C15ULL * (i + 1), endTime));
+			threads.push_back (thread);
+		}
+
+		foreach_ref (const Thread &thread, threads)
+			thread.Join();
+
+		VolumeBenchmarkResult result;
+		result.Workload = workload;
+		result.Elapsed = (double) (Time::GetMonotonic() - startTime) / 1000000000.0;
+
+		vector <uint64> latencies;
+		foreach (const WorkerState &state, states)
+		{
+			if (state.ThreadException)
+				state.ThreadException->Throw();
+
+			result.BytesRead += state.BytesRead;
+			result.BytesWritten += state.BytesWritten;
+			result.ReadCount += state.ReadCount;
+			result.WriteCount += state.WriteCount;
+			latencies.insert (latencies.end(), state.Latencies.begin(), state.Latencies.end());
+		}
+
+		if (!latencies.empty())
+		{
+			std::sort (latencies.begin(), latencies.end());
+
+			double sum = 0;
+			foreach (uint64 latency, latencies)
+				sum += latency;
+
+			struct Percentile
+			{
+				static double Get (const vector <uint64> &sorted, double percentile)
+				{
+					size_t index = (size_t) (percentile / 100.0 * sorted.size());
+					if (index >= sorted.size())
+						index = sorted.size() - 1;
+
+					return (double) sorted[index] / 1000.0;
+				}
+			};
+
+			result.LatencyMean = sum / latencies.size() / 1000.0;
+			result.LatencyP50 = Percentile::Get (latencies, 50);
+			result.LatencyP90 = Percentile::Get (latencies, 90);
+			result.LatencyP99 = Percentile::Get (latencies, 99);
+			result.LatencyP999 = Percentile::Get (latencies, 99.9);
+			result.LatencyMax = (double) latencies.back() / 1000.0;
+		}
+
+		return result;
+	}
+}
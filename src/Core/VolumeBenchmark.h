@@ -0,0 +1,110 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Core_VolumeBenchmark
+#define TC_HEADER_Core_VolumeBenchmark
+
+#include "Platform/Platform.h"
+#include "Platform/JsonObject.h"
+#include "Volume/Volume.h"
+
+namespace VeraCrypt
+{
+	struct VolumeBenchmarkWorkload
+	{
+		VolumeBenchmarkWorkload () : BlockSize (4096), QueueDepth (1), Random (false), ReadPercentage (100), ThreadCount (1) { }
+
+		string GetName () const;
+
+		size_t BlockSize;
+		size_t QueueDepth;		// The volume API is synchronous; each job runs QueueDepth concurrent submitters
+		bool Random;
+		uint32 ReadPercentage;
+		size_t ThreadCount;		// Number of jobs
+	};
+
+	struct VolumeBenchmarkOptions
+	{
+		VolumeBenchmarkOptions () : ContainerSize (256 * BYTES_PER_MB), Duration (2000) { }
+
+		uint64 ContainerSize;
+		FilePath ContainerPath;				// Defaults to a temporary file in $TMPDIR
+		uint32 Duration;					// Milliseconds per workload
+		shared_ptr <EncryptionAlgorithm> EA;	// Defaults to AES
+		list <VolumeBenchmarkWorkload> Workloads;
+	};
+
+	struct VolumeBenchmarkResult
+	{
+		VolumeBenchmarkResult ()
+			: BytesRead (0),
+			BytesWritten (0),
+			Elapsed (0),
+			LatencyMax (0),
+			LatencyMean (0),
+			LatencyP50 (0),
+			LatencyP90 (0),
+			LatencyP99 (0),
+			LatencyP999 (0),
+			ReadCount (0),
+			WriteCount (0)
+		{
+		}
+
+		double GetIops () const { return Elapsed > 0 ? (double) (ReadCount + WriteCount) / Elapsed : 0; }
+		double GetThroughput () const { return Elapsed > 0 ? (double) (BytesRead + BytesWritten) / Elapsed : 0; }
+		JsonObject ToJson () const;
+
+		uint64 BytesRead;
+		uint64 BytesWritten;
+		double Elapsed;			// Seconds
+		double LatencyMax;		// Latencies are in microseconds
+		double LatencyMean;
+		double LatencyP50;
+		double LatencyP90;
+		double LatencyP99;
+		double LatencyP999;
+		uint64 ReadCount;
+		VolumeBenchmarkWorkload Workload;
+		uint64 WriteCount;
+	};
+
+	struct VolumeBenchmarkListener
+	{
+		virtual ~VolumeBenchmarkListener () { }
+		virtual void operator() (const VolumeBenchmarkResult &result) = 0;
+	};
+
+	// Measures end-to-end I/O performance of the volume layer (sector encryption,
+	// host file I/O, buffer allocation and thread pool dispatch) by driving the
+	// Volume API of a temporary file container directly. No mounting or
+	// administrator privileges are required.
+	class VolumeBenchmark
+	{
+	public:
+		VolumeBenchmark (const VolumeBenchmarkOptions &options);
+		virtual ~VolumeBenchmark ();
+
+		static list <VolumeBenchmarkWorkload> GetDefaultWorkloads ();
+		list <VolumeBenchmarkResult> Run (VolumeBenchmarkListener *listener = nullptr);
+
+	protected:
+		void CreateContainer ();
+		VolumeBenchmarkResult RunWorkload (const VolumeBenchmarkWorkload &workload);
+
+		bool ContainerCreated;
+		VolumeBenchmarkOptions Options;
+		shared_ptr <Volume> BenchmarkVolume;
+
+	private:
+		VolumeBenchmark (const VolumeBenchmark &);
+		VolumeBenchmark &operator= (const VolumeBenchmark &);
+	};
+}
+
+#endif // TC_HEADER_Core_VolumeBenchmark
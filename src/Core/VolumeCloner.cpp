@@ -0,0 +1,521 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include "Volume/EncryptionTest.h"
+#include "Volume/EncryptionModeXTS.h"
+#include "Core.h"
+
+#ifdef TC_UNIX
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "VolumeCloner.h"
+
+namespace VeraCrypt
+{
+	VolumeCloner::VolumeCloner ()
+		: AbortRequested (false), SizeDone (0), ChunksReady (0), ReaderFinished (false)
+	{
+		mProgressInfo.CloneInProgress = false;
+		mProgressInfo.TotalSize = 0;
+		mProgressInfo.SizeDone = 0;
+	}
+
+	VolumeCloner::~VolumeCloner ()
+	{
+	}
+
+	void VolumeCloner::Abort ()
+	{
+		AbortRequested = true;
+	}
+
+	void VolumeCloner::CheckResult ()
+	{
+		if (ThreadException)
+			ThreadException->Throw();
+	}
+
+	void VolumeCloner::CloneThread ()
+	{
+		ProgressReporter progress ("clone", wstring (Options->Path), Source->GetSize());
+
+		try
+		{
+			struct ReaderThreadFunctor : public Functor
+			{
+				ReaderThreadFunctor (VolumeCloner *cloner) : Cloner (cloner) { }
+				virtual void operator() ()
+				{
+					Cloner->ReaderThread ();
+				}
+				VolumeCloner *Cloner;
+			};
+
+			Thread readerThread;
+			readerThread.Start (new ReaderThreadFunctor (this));
+
+			uint64 sizeDone = SizeDone.Get();
+
+			try
+			{
+				uint64 checkpointSize = sizeDone;
+				size_t readIndex = 0;
+
+				while (!AbortRequested && sizeDone < Source->GetSize())
+				{
+					while (true)
+					{
+						{
+							ScopeLock lock (ChunkMutex);
+							if (ChunksReady > 0 || ReaderFinished)
+								break;
+						}
+						ChunkReadyEvent.Wait();
+					}
+
+					{
+						ScopeLock lock (ChunkMutex);
+						if (ChunksReady == 0)
+							break;
+					}
+
+					Chunk &chunk = Chunks[readIndex];
+					BufferPtr data = chunk.Data.GetRange (0, chunk.Length);
+
+					TargetEA->EncryptSectors (data, (DataStart + chunk.Offset) / ENCRYPTION_DATA_UNIT_SIZE, chunk.Length / ENCRYPTION_DATA_UNIT_SIZE, ENCRYPTION_DATA_UNIT_SIZE);
+					VolumeFile->WriteAt (data, DataStart + chunk.Offset);
+
+					sizeDone = chunk.Offset + chunk.Length;
+					SizeDone.Set (sizeDone);
+					progress.Update (sizeDone);
+
+					{
+						ScopeLock lock (ChunkMutex);
+						--ChunksReady;
+					}
+					ChunkFreeEvent.Signal();
+
+					if (++readIndex >= ChunkCount)
+						readIndex = 0;
+
+					if (sizeDone - checkpointSize >= CheckpointInterval)
+					{
+						VolumeFile->Flush();
+						WriteCheckpoint (sizeDone);
+						checkpointSize = sizeDone;
+					}
+				}
+			}
+			catch (...)
+			{
+				StopReaderThread (readerThread);
+				throw;
+			}
+
+			StopReaderThread (readerThread);
+
+			if (ReaderException)
+				ReaderException->Throw();
+
+			VolumeFile->Flush();
+
+			if (sizeDone < Source->GetSize())
+			{
+				WriteCheckpoint (sizeDone);
+				throw UserAbort (SRC_POS);
+			}
+
+			// The clone is complete
+			Options->CheckpointPath.Delete();
+			progress.Complete();
+		}
+		catch (Exception &e)
+		{
+			ThreadException.reset (e.CloneNew());
+			progress.Fail (StringConverter::ToExceptionString (e));
+		}
+		catch (exception &e)
+		{
+			ThreadException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+			progress.Fail (StringConverter::ToExceptionString (e));
+		}
+		catch (...)
+		{
+			ThreadException.reset (new UnknownException (SRC_POS));
+			progress.Fail (StringConverter::ToExceptionString (UnknownException (SRC_POS)));
+		}
+
+		if (ThreadException && !dynamic_cast <UserAbort *> (ThreadException.get()))
+		{
+			// Record the progress made so far to allow the clone to be resumed
+			try
+			{
+				VolumeFile->Flush();
+				WriteCheckpoint (SizeDone.Get());
+			}
+			catch (...) { }
+		}
+
+		VolumeFile.reset();
+		mProgressInfo.CloneInProgress = false;
+	}
+
+	void VolumeCloner::CloneVolume (shared_ptr <Volume> source, shared_ptr <VolumeCloneOptions> options)
+	{
+		EncryptionTest::TestAll();
+
+		if (options->CheckpointPath.IsEmpty())
+			throw ParameterIncorrect (SRC_POS);
+
+		// Opening the target would truncate the source
+		if (IsSameVolume (source->GetPath(), options->Path))
+			throw ParameterIncorrect (SRC_POS);
+
+		// A resumed clone uses the algorithms of the target, which are checked against the options in OpenTarget()
+		if (!options->Resume)
+		{
+			if (!options->EA)
+				options->EA = source->GetEncryptionAlgorithm()->GetNew();
+
+			if (!options->VolumeHeaderKdf)
+				options->VolumeHeaderKdf = source->GetPkcs5Kdf();
+		}
+
+		{
+#ifdef TC_UNIX
+			// Temporarily take ownership of a device if the user is not an administrator
+			UserId origDeviceOwner ((uid_t) -1);
+
+			if (!Core->HasAdminPrivileges() && options->Path.IsDevice())
+			{
+				origDeviceOwner = FilesystemPath (wstring (options->Path)).GetOwner();
+				Core->SetFileOwner (options->Path, UserId (getuid()));
+			}
+
+			finally_do_arg2 (FilesystemPath, options->Path, UserId, origDeviceOwner,
+			{
+				if (finally_arg2.SystemId != (uid_t) -1)
+					Core->SetFileOwner (finally_arg, finally_arg2);
+			});
+#endif
+
+			VolumeFile.reset (new File);
+			VolumeFile->Open (options->Path,
+				(options->Path.IsDevice() || options->Resume) ? File::OpenReadWrite : File::CreateReadWrite,
+				File::ShareNone);
+		}
+
+		try
+		{
+			uint32 sectorSize;
+
+			if (options->Path.IsDevice())
+			{
+				sectorSize = VolumeFile->GetDeviceSectorSize();
+				HostSize = VolumeFile->Length();
+
+				if (sectorSize < TC_MIN_VOLUME_SECTOR_SIZE
+					|| sectorSize > TC_MAX_VOLUME_SECTOR_SIZE
+#if !defined (TC_LINUX) && !defined (TC_MACOSX)
+					|| sectorSize != TC_SECTOR_SIZE_LEGACY
+#endif
+					|| sectorSize % ENCRYPTION_DATA_UNIT_SIZE != 0)
+				{
+					throw UnsupportedSectorSize (SRC_POS);
+				}
+			}
+			else
+			{
+				sectorSize = TC_SECTOR_SIZE_FILE_HOSTED_VOLUME;
+				HostSize = source->GetSize() + TC_TOTAL_VOLUME_HEADERS_SIZE;
+			}
+
+			// The data area is copied unchanged and must therefore fit the target exactly
+			if (source->GetSize() % sectorSize != 0 || VolumeLayoutV2Normal().GetMaxDataSize (HostSize) < source->GetSize())
+				throw ParameterIncorrect (SRC_POS);
+
+			Source = source;
+			Options = options;
+
+			if (options->Resume)
+				OpenTarget();
+			else
+				CreateTarget (sectorSize);
+
+			for (size_t i = 0; i < ChunkCount; ++i)
+				Chunks[i].Data.Allocate (ChunkSize);
+
+			ChunksReady = 0;
+			ReaderFinished = false;
+			AbortRequested = false;
+
+			mProgressInfo.TotalSize = source->GetSize();
+			mProgressInfo.CloneInProgress = true;
+
+			struct ThreadFunctor : public Functor
+			{
+				ThreadFunctor (VolumeCloner *cloner) : Cloner (cloner) { }
+				virtual void operator() ()
+				{
+					Cloner->CloneThread ();
+				}
+				VolumeCloner *Cloner;
+			};
+
+			Thread thread;
+			thread.Start (new ThreadFunctor (this));
+		}
+		catch (...)
+		{
+			VolumeFile.reset();
+			throw;
+		}
+	}
+
+	void VolumeCloner::CreateTarget (uint32 sectorSize)
+	{
+		VolumeLayoutV2Normal layout;
+		shared_ptr <VolumeHeader> header (layout.GetHeader());
+		SecureBuffer headerBuffer (layout.GetHeaderSize());
+		shared_ptr <EncryptionAlgorithm> ea = Options->EA;
+
+		VolumeHeaderCreationOptions headerOptions;
+		headerOptions.EA = ea;
+		headerOptions.Kdf = Options->VolumeHeaderKdf;
+		headerOptions.Type = VolumeType::Normal;
+		headerOptions.SectorSize = sectorSize;
+		headerOptions.VolumeDataStart = layout.GetHeaderSize() * 2;
+		headerOptions.VolumeDataSize = Source->GetSize();
+
+		// Master data key
+		SecureBuffer masterKey (ea->GetKeySize() * 2);
+		RandomNumberGenerator::GetData (masterKey);
+		headerOptions.DataKey = masterKey;
+
+		// PKCS5 salt
+		SecureBuffer salt (VolumeHeader::GetSaltSize());
+		RandomNumberGenerator::GetData (salt);
+		headerOptions.Salt = salt;
+
+		// Header key
+		SecureBuffer headerKey (VolumeHeader::GetLargestSerializedKeySize());
+		shared_ptr <VolumePassword> passwordKey = Keyfile::ApplyListToPassword (Options->Keyfiles, Options->Password);
+		Options->VolumeHeaderKdf->DeriveKey (headerKey, *passwordKey, Options->Pim, salt);
+		headerOptions.HeaderKey = headerKey;
+
+		header->Create (headerBuffer, headerOptions);
+		VolumeFile->WriteAt (headerBuffer, layout.GetHeaderOffset());
+
+		// Backup header
+		RandomNumberGenerator::GetData (salt);
+		Options->VolumeHeaderKdf->DeriveKey (headerKey, *passwordKey, Options->Pim, salt);
+		header->EncryptNew (headerBuffer, salt, headerKey, Options->VolumeHeaderKdf);
+		VolumeFile->WriteAt (headerBuffer, HostSize + layout.GetBackupHeaderOffset());
+
+		// Write fake random headers to space reserved for hidden volume headers
+		VolumeLayoutV2Hidden hiddenLayout;
+		shared_ptr <VolumeHeader> hiddenHeader (hiddenLayout.GetHeader());
+
+		headerOptions.Type = VolumeType::Hidden;
+		headerOptions.VolumeDataStart = HostSize - hiddenLayout.GetHeaderSize() * 2 - Source->GetSize();
+		headerOptions.VolumeDataSize = hiddenLayout.GetMaxDataSize (Source->GetSize());
+
+		uint64 hiddenHeaderOffsets[] = { (uint64) layout.GetHeaderSize(), HostSize + layout.GetBackupHeaderOffset() + layout.GetHeaderSize() };
+		for (size_t i = 0; i < array_capacity (hiddenHeaderOffsets); ++i)
+		{
+			SecureBuffer hiddenMasterKey (ea->GetKeySize() * 2);
+			RandomNumberGenerator::GetData (hiddenMasterKey);
+			headerOptions.DataKey = hiddenMasterKey;
+
+			SecureBuffer hiddenSalt (VolumeHeader::GetSaltSize());
+			RandomNumberGenerator::GetData (hiddenSalt);
+			headerOptions.Salt = hiddenSalt;
+
+			SecureBuffer hiddenHeaderKey (VolumeHeader::GetLargestSerializedKeySize());
+			RandomNumberGenerator::GetData (hiddenHeaderKey);
+			headerOptions.HeaderKey = hiddenHeaderKey;
+
+			hiddenHeader->Create (headerBuffer, headerOptions);
+			VolumeFile->WriteAt (headerBuffer, hiddenHeaderOffsets[i]);
+		}
+
+		// Data area keys
+		ea->SetKey (masterKey.GetRange (0, ea->GetKeySize()));
+		shared_ptr <EncryptionMode> mode (new EncryptionModeXTS ());
+		mode->SetKey (masterKey.GetRange (ea->GetKeySize(), ea->GetKeySize()));
+		ea->SetMode (mode);
+
+		TargetEA = ea;
+		DataStart = layout.GetHeaderSize() * 2;
+		SizeDone.Set (0);
+
+		VolumeFile->Flush();
+		WriteCheckpoint (0);
+	}
+
+	VolumeCloner::ProgressInfo VolumeCloner::GetProgressInfo ()
+	{
+		mProgressInfo.SizeDone = SizeDone.Get();
+		return mProgressInfo;
+	}
+
+	bool VolumeCloner::IsSameVolume (const VolumePath &firstPath, const VolumePath &secondPath)
+	{
+		if (firstPath == secondPath)
+			return true;
+
+#ifdef TC_UNIX
+		struct stat firstStat;
+		struct stat secondStat;
+
+		if (stat (string (firstPath).c_str(), &firstStat) != 0 || stat (string (secondPath).c_str(), &secondStat) != 0)
+			return false;
+
+		if (firstStat.st_dev == secondStat.st_dev && firstStat.st_ino == secondStat.st_ino)
+			return true;
+
+		// Different device nodes may refer to the same device
+		if (((S_ISBLK (firstStat.st_mode) && S_ISBLK (secondStat.st_mode)) || (S_ISCHR (firstStat.st_mode) && S_ISCHR (secondStat.st_mode)))
+			&& firstStat.st_rdev == secondStat.st_rdev)
+		{
+			return true;
+		}
+#endif
+		return false;
+	}
+
+	void VolumeCloner::OpenTarget ()
+	{
+		// Keys of the target are obtained from its header, so that the checkpoint never contains key material
+		Volume target;
+		target.Open (VolumeFile, Options->Password, Options->Pim, shared_ptr <Pkcs5Kdf> (), false, Options->Keyfiles,
+			VolumeProtection::None, shared_ptr <VolumePassword> (), 0, shared_ptr <Pkcs5Kdf> (), shared_ptr <KeyfileList> (), VolumeType::Normal);
+
+		if (typeid (*target.GetLayout()) != typeid (VolumeLayoutV2Normal) || target.GetSize() != Source->GetSize())
+			throw ParameterIncorrect (SRC_POS);
+
+		// Algorithms requested for the resumed clone must be those it was started with
+		if ((Options->EA && Options->EA->GetName() != target.GetEncryptionAlgorithm()->GetName())
+			|| (Options->VolumeHeaderKdf && Options->VolumeHeaderKdf->GetName() != target.GetPkcs5Kdf()->GetName()))
+		{
+			throw ParameterIncorrect (SRC_POS);
+		}
+
+		uint64 sizeDone = ReadCheckpoint (Options->CheckpointPath);
+		if (sizeDone > Source->GetSize() || sizeDone % Source->GetSectorSize() != 0)
+			throw ParameterIncorrect (SRC_POS);
+
+		TargetEA = target.GetEncryptionAlgorithm();
+		DataStart = target.GetHeader()->GetEncryptedAreaStart();
+		SizeDone.Set (sizeDone);
+	}
+
+	uint64 VolumeCloner::ReadCheckpoint (const FilePath &checkpointPath)
+	{
+		File checkpointFile;
+		checkpointFile.Open (checkpointPath, File::OpenRead);
+
+		Buffer buffer (64);
+		size_t length = (size_t) checkpointFile.Read (buffer);
+
+		string str ((const char *) buffer.Ptr(), length);
+		while (!str.empty() && (str[str.size() - 1] == '\n' || str[str.size() - 1] == '\r'))
+			str.erase (str.size() - 1);
+
+		return StringConverter::ToUInt64 (str);
+	}
+
+	void VolumeCloner::ReaderThread ()
+	{
+		try
+		{
+			uint64 offset = SizeDone.Get();
+			size_t writeIndex = 0;
+
+			while (offset < Source->GetSize())
+			{
+				while (true)
+				{
+					{
+						ScopeLock lock (ChunkMutex);
+						if (AbortRequested)
+							throw UserAbort (SRC_POS);
+
+						if (ChunksReady < ChunkCount)
+							break;
+					}
+					ChunkFreeEvent.Wait();
+				}
+
+				Chunk &chunk = Chunks[writeIndex];
+				chunk.Offset = offset;
+				chunk.Length = (size_t) VC_MIN ((uint64) ChunkSize, Source->GetSize() - offset);
+
+				Source->ReadSectors (chunk.Data.GetRange (0, chunk.Length), offset);
+				offset += chunk.Length;
+
+				{
+					ScopeLock lock (ChunkMutex);
+					++ChunksReady;
+				}
+				ChunkReadyEvent.Signal();
+
+				if (++writeIndex >= ChunkCount)
+					writeIndex = 0;
+			}
+		}
+		catch (UserAbort &)
+		{
+		}
+		catch (Exception &e)
+		{
+			ReaderException.reset (e.CloneNew());
+		}
+		catch (exception &e)
+		{
+			ReaderException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+		}
+		catch (...)
+		{
+			ReaderException.reset (new UnknownException (SRC_POS));
+		}
+
+		{
+			ScopeLock lock (ChunkMutex);
+			ReaderFinished = true;
+		}
+		ChunkReadyEvent.Signal();
+	}
+
+	void VolumeCloner::StopReaderThread (Thread &readerThread)
+	{
+		{
+			ScopeLock lock (ChunkMutex);
+			AbortRequested = true;
+		}
+		ChunkFreeEvent.Signal();
+		readerThread.Join();
+	}
+
+	void VolumeCloner::WriteCheckpoint (uint64 sizeDone) const
+	{
+		string str = StringConverter::ToSingle (sizeDone) + "\n";
+		FilePath tempPath (wstring (Options->CheckpointPath) + L".tmp");
+
+		File checkpointFile;
+		checkpointFile.Open (tempPath, File::CreateWrite);
+		checkpointFile.Write (ConstBufferPtr ((const byte *) str.c_str(), str.size()));
+		checkpointFile.Flush();
+		checkpointFile.Close();
+
+		tempPath.Rename (Options->CheckpointPath);
+	}
+}
@@ -0,0 +1,103 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Core_VolumeCloner
+#define TC_HEADER_Core_VolumeCloner
+
+#include "Platform/Platform.h"
+#include "Volume/Volume.h"
+#include "RandomNumberGenerator.h"
+
+namespace VeraCrypt
+{
+	struct VolumeCloneOptions
+	{
+		VolumeCloneOptions () : Pim (0), Resume (false) { }
+
+		shared_ptr <EncryptionAlgorithm> EA;		// Defaults to the algorithm of the source volume
+		shared_ptr <KeyfileList> Keyfiles;
+		shared_ptr <VolumePassword> Password;
+		VolumePath Path;
+		FilePath CheckpointPath;
+		int Pim;
+		bool Resume;
+		shared_ptr <Pkcs5Kdf> VolumeHeaderKdf;	// Defaults to the KDF of the source volume
+	};
+
+	// Copies the data area of an open volume to a new normal volume encrypted with a
+	// freshly generated master key. Decryption of the source and encryption of the
+	// target run concurrently on the encryption thread pool. Progress is recorded in
+	// a checkpoint file, which allows an interrupted clone to be resumed.
+	class VolumeCloner
+	{
+	public:
+
+		struct ProgressInfo
+		{
+			bool CloneInProgress;
+			uint64 TotalSize;
+			uint64 SizeDone;
+		};
+
+		VolumeCloner ();
+		virtual ~VolumeCloner ();
+
+		void Abort ();
+		void CheckResult ();
+		void CloneVolume (shared_ptr <Volume> source, shared_ptr <VolumeCloneOptions> options);
+		ProgressInfo GetProgressInfo ();
+		static bool IsSameVolume (const VolumePath &firstPath, const VolumePath &secondPath);
+		static uint64 ReadCheckpoint (const FilePath &checkpointPath);
+
+		static const size_t ChunkSize = 4 * BYTES_PER_MB;
+		static const uint64 CheckpointInterval = 64 * BYTES_PER_MB;
+
+	protected:
+		struct Chunk
+		{
+			SecureBuffer Data;
+			uint64 Offset;
+			size_t Length;
+		};
+
+		void CloneThread ();
+		void CreateTarget (uint32 sectorSize);
+		void OpenTarget ();
+		void ReaderThread ();
+		void StopReaderThread (Thread &readerThread);
+		void WriteCheckpoint (uint64 sizeDone) const;
+
+		volatile bool AbortRequested;
+		uint64 DataStart;
+		uint64 HostSize;
+		shared_ptr <VolumeCloneOptions> Options;
+		shared_ptr <Volume> Source;
+		shared_ptr <EncryptionAlgorithm> TargetEA;
+		shared_ptr <Exception> ThreadException;
+		shared_ptr <Exception> ReaderException;
+
+		shared_ptr <File> VolumeFile;
+		SharedVal <uint64> SizeDone;
+		ProgressInfo mProgressInfo;
+
+		// Decrypted chunks are passed from the reader thread to the clone thread through a ring of buffers
+		static const size_t ChunkCount = 3;
+		Chunk Chunks[ChunkCount];
+		size_t ChunksReady;
+		volatile bool ReaderFinished;
+		Mutex ChunkMutex;
+		SyncEvent ChunkReadyEvent;
+		SyncEvent ChunkFreeEvent;
+
+	private:
+		VolumeCloner (const VolumeCloner &);
+		VolumeCloner &operator= (const VolumeCloner &);
+	};
+}
+
+#endif // TC_HEADER_Core_VolumeCloner
@@ -47,6 +47,8 @@ namespace VeraCrypt
 
 	void VolumeCreator::CreationThread ()
 	{
+		ProgressReporter progress ("create", wstring (Options->Path), Options->Size);
+
 		try
 		{
 			uint64 endOffset;
@@ -64,12 +66,14 @@ namespace VeraCrypt
 			// Create filesystem
 			if (Options->Filesystem == VolumeCreationOptions::FilesystemType::FAT)
 			{
+				progress.SetPhase ("filesystem");
+
 				if (filesystemSize < TC_MIN_FAT_FS_SIZE || filesystemSize > TC_MAX_FAT_SECTOR_COUNT * Options->SectorSize)
 					throw ParameterIncorrect (SRC_POS);
 
 				struct WriteSectorCallback : public FatFormatter::WriteSectorCallback
 				{
-					WriteSectorCallback (VolumeCreator *creator) : Creator (creator), OutputBuffer (File::GetOptimalWriteSize()), OutputBufferWritePos (0) { }
+					WriteSectorCallback (VolumeCreator *creator, ProgressReporter &progress) : Creator (creator), OutputBuffer (File::GetOptimalWriteSize()), OutputBufferWritePos (0), Progress (progress) { }
 
 					virtual bool operator() (const BufferPtr &sector)
 					{
@@ -89,10 +93,14 @@ namespace VeraCrypt
 							Creator->Options->EA->EncryptSectors (OutputBuffer.GetRange (0, OutputBufferWritePos),
 								Creator->WriteOffset / ENCRYPTION_DATA_UNIT_SIZE, OutputBufferWritePos / ENCRYPTION_DATA_UNIT_SIZE, ENCRYPTION_DATA_UNIT_SIZE);
 
+							if (Creator->Options->IoLimiter)
+								Creator->Options->IoLimiter->Acquire (OutputBufferWritePos);
+
 							Creator->VolumeFile->Write (OutputBuffer.GetRange (0, OutputBufferWritePos));
 
 							Creator->WriteOffset += OutputBufferWritePos;
 							Creator->SizeDone.Set (Creator->WriteOffset - Creator->DataStart);
+							Progress.Update (Creator->WriteOffset - Creator->DataStart);
 
 							OutputBufferWritePos = 0;
 						}
@@ -101,15 +109,18 @@ namespace VeraCrypt
 					VolumeCreator *Creator;
 					SecureBuffer OutputBuffer;
 					size_t OutputBufferWritePos;
+					ProgressReporter &Progress;
 				};
 
-				WriteSectorCallback sectorWriter (this);
+				WriteSectorCallback sectorWriter (this, progress);
 				FatFormatter::Format (sectorWriter, filesystemSize, Options->FilesystemClusterSize, Options->SectorSize);
 				sectorWriter.FlushOutputBuffer();
 			}
 
 			if (!Options->Quick)
 			{
+				progress.SetPhase ("data");
+
 				// Empty sectors are encrypted with different key to randomize plaintext
 				Core->RandomizeEncryptionAlgorithmKey (Options->EA);
 
@@ -123,16 +134,23 @@ namespace VeraCrypt
 
 					outputBuffer.Zero();
 					Options->EA->EncryptSectors (outputBuffer, WriteOffset / ENCRYPTION_DATA_UNIT_SIZE, dataFragmentLength / ENCRYPTION_DATA_UNIT_SIZE, ENCRYPTION_DATA_UNIT_SIZE);
+
+					if (Options->IoLimiter)
+						Options->IoLimiter->Acquire (dataFragmentLength);
+
 					VolumeFile->Write (outputBuffer, (size_t) dataFragmentLength);
 
 					WriteOffset += dataFragmentLength;
 					SizeDone.Set (WriteOffset - DataStart);
+					progress.Update (WriteOffset - DataStart);
 				}
 			}
 
 			if (!AbortRequested)
 			{
 				SizeDone.Set (Options->Size);
+				progress.SetPhase ("headers");
+				progress.Update (Options->Size);
 
 				// Backup header
 				SecureBuffer backupHeader (Layout->GetHeaderSize());
@@ -187,28 +205,33 @@ namespace VeraCrypt
 				}
 
 				VolumeFile->Flush();
+				progress.Complete();
 			}
 		}
 		catch (Exception &e)
 		{
 			ThreadException.reset (e.CloneNew());
+			progress.Fail (StringConverter::ToExceptionString (e));
 		}
 		catch (exception &e)
 		{
 			ThreadException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+			progress.Fail (StringConverter::ToExceptionString (e));
 		}
 		catch (...)
 		{
 			ThreadException.reset (new UnknownException (SRC_POS));
+			progress.Fail (StringConverter::ToExceptionString (UnknownException (SRC_POS)));
 		}
 
 		VolumeFile.reset();
 		mProgressInfo.CreationInProgress = false;
 	}
 
-	void VolumeCreator::CreateVolume (shared_ptr <VolumeCreationOptions> options)
+	void VolumeCreator::CreateVolume (shared_ptr <VolumeCreationOptions> options, bool testEncryption)
 	{
-		EncryptionTest::TestAll();
+		if (testEncryption)
+			EncryptionTest::TestAll();
 
 		{
 #ifdef TC_UNIX
@@ -32,6 +32,7 @@ namespace VeraCrypt
 		VolumePath Path;
 		VolumeType::Enum Type;
 		uint64 Size;
+		shared_ptr <RateLimiter> IoLimiter;		// Optional limit of the write rate shared by concurrent creators
 		shared_ptr <VolumePassword> Password;
 		int Pim;
 		shared_ptr <KeyfileList> Keyfiles;
@@ -161,7 +162,7 @@ namespace VeraCrypt
 
 		void Abort ();
 		void CheckResult ();
-		void CreateVolume (shared_ptr <VolumeCreationOptions> options);
+		void CreateVolume (shared_ptr <VolumeCreationOptions> options, bool testEncryption = true);
 		KeyInfo GetKeyInfo () const;
 		ProgressInfo GetProgressInfo ();
 
@@ -16,6 +16,11 @@ Public domain.
 
 #if CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE
 
+#if defined(__GNUC__) && !defined(__INTEL_COMPILER)
+/* requires SSSE3 code generation (-mssse3); only called when HasSSSE3() */
+#include <tmmintrin.h>
+#endif
+
 #ifndef _M_X64
 #ifdef _MSC_VER
 #if _MSC_VER < 1900
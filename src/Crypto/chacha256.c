@@ -9,6 +9,12 @@ and released into public domain.
 #include "cpu.h"
 #include "misc.h"
 
+#ifdef __GNUC__
+/* VC_INLINE includes "static" with GCC and Clang, which is given explicitly in this file */
+#undef VC_INLINE
+#define VC_INLINE inline __attribute__((always_inline))
+#endif
+
 
 
 #define rotater32(x,n)	rotr32(x, n)
@@ -161,7 +167,7 @@ static VC_INLINE void do_encrypt(const unsigned char* in, size_t len, unsigned c
     if (len)
         pos = 0;
 
-#if CRYPTOPP_SSSE3_AVAILABLE && !defined(_UEFI) && (!defined (TC_WINDOWS_DRIVER) || (!defined (DEBUG) && defined (_WIN64)))
+#if CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE && CRYPTOPP_SSSE3_AVAILABLE && !defined(_UEFI) && (!defined (TC_WINDOWS_DRIVER) || (!defined (DEBUG) && defined (_WIN64)))
     if (HasSSSE3())
     {
         size_t fullblocks = len - len % 64;
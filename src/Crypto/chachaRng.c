@@ -32,6 +32,12 @@
 #include "misc.h"
 #include <string.h>
 
+#ifdef __GNUC__
+/* VC_INLINE includes "static" with GCC and Clang, which is given explicitly in this file */
+#undef VC_INLINE
+#define VC_INLINE inline __attribute__((always_inline))
+#endif
+
 static VC_INLINE void ChaCha20RngReKey (ChaCha20RngCtx* pCtx, int useCallBack)
 {
 	/* fill rs_buf with the keystream */
@@ -29,6 +29,8 @@
 #include "Platform/MemoryStream.h"
 #include "Platform/Serializable.h"
 #include "Platform/SystemLog.h"
+#include "Platform/Time.h"
+#include "Platform/Tracepoint.h"
 #include "Platform/Unix/Pipe.h"
 #include "Platform/Unix/Poller.h"
 #include "Volume/EncryptionThreadPool.h"
@@ -184,7 +186,7 @@ namespace VeraCrypt
 		return -ENOENT;
 	}
 
-	static int fuse_service_read (const char *path, char *buf, size_t size, off_t offset, struct fuse_file_info *fi)
+	static int fuse_service_do_read (const char *path, char *buf, size_t size, off_t offset, struct fuse_file_info *fi)
 	{
 		try
 		{
@@ -252,6 +254,14 @@ namespace VeraCrypt
 		return -ENOENT;
 	}
 
+	static int fuse_service_read (const char *path, char *buf, size_t size, off_t offset, struct fuse_file_info *fi)
+	{
+		TC_TRACE3 (fuse_read_start, path, (uint64) offset, size);
+		int result = fuse_service_do_read (path, buf, size, offset, fi);
+		TC_TRACE4 (fuse_read_done, path, (uint64) offset, size, result);
+		return result;
+	}
+
 	static int fuse_service_readdir (const char *path, void *buf, fuse_fill_dir_t filler, off_t offset, struct fuse_file_info *fi)
 	{
 		try
@@ -275,7 +285,7 @@ namespace VeraCrypt
 		return 0;
 	}
 
-	static int fuse_service_write (const char *path, const char *buf, size_t size, off_t offset, struct fuse_file_info *fi)
+	static int fuse_service_do_write (const char *path, const char *buf, size_t size, off_t offset, struct fuse_file_info *fi)
 	{
 		try
 		{
@@ -316,6 +326,14 @@ namespace VeraCrypt
 		return -ENOENT;
 	}
 
+	static int fuse_service_write (const char *path, const char *buf, size_t size, off_t offset, struct fuse_file_info *fi)
+	{
+		TC_TRACE3 (fuse_write_start, path, (uint64) offset, size);
+		int result = fuse_service_do_write (path, buf, size, offset, fi);
+		TC_TRACE4 (fuse_write_done, path, (uint64) offset, size, result);
+		return result;
+	}
+
 	bool FuseService::CheckAccessRights ()
 	{
 		return fuse_get_context()->uid == 0 || fuse_get_context()->uid == UserId;
@@ -386,22 +404,29 @@ namespace VeraCrypt
 
 	shared_ptr <Buffer> FuseService::GetVolumeInfo ()
 	{
-		shared_ptr <Stream> stream (new MemoryStream);
+		ScopeLock lock (OpenVolumeInfoMutex);
 
-		{
-			ScopeLock lock (OpenVolumeInfoMutex);
+		// The control file is read in many requests, which are served from the cache while the volume state is unchanged.
+		// I/O does not change the state generation, so the I/O counters are refreshed when the cache expires.
+		uint64 generation = MountedVolume->GetStateGeneration();
+		uint64 time = Time::GetMonotonic();
 
-			OpenVolumeInfo.Set (*MountedVolume);
-			OpenVolumeInfo.SlotNumber = SlotNumber;
+		if (VolumeInfoCache && generation == VolumeInfoCacheGeneration && time - VolumeInfoCacheTime < VolumeInfoCacheMaxAge)
+			return VolumeInfoCache;
 
-			OpenVolumeInfo.Serialize (stream);
-		}
+		shared_ptr <MemoryStream> stream (new MemoryStream);
+		if (VolumeInfoCache)
+			stream->Reserve (VolumeInfoCache->Size());
+
+		OpenVolumeInfo.Set (*MountedVolume);
+		OpenVolumeInfo.SlotNumber = SlotNumber;
+		OpenVolumeInfo.Serialize (stream);
 
-		ConstBufferPtr infoBuf = dynamic_cast <MemoryStream&> (*stream);
-		shared_ptr <Buffer> outBuf (new Buffer (infoBuf.Size()));
-		outBuf->CopyFrom (infoBuf);
+		VolumeInfoCache.reset (new Buffer (ConstBufferPtr (*stream)));
+		VolumeInfoCacheGeneration = generation;
+		VolumeInfoCacheTime = time;
 
-		return outBuf;
+		return VolumeInfoCache;
 	}
 
 	const char *FuseService::GetVolumeImagePath ()
@@ -470,12 +495,13 @@ namespace VeraCrypt
 
 	void FuseService::ReceiveAuxDeviceInfo (const ConstBufferPtr &buffer)
 	{
-		shared_ptr <Stream> stream (new MemoryStream (buffer));
+		shared_ptr <Stream> stream (new MemoryReadStream (buffer));
 		Serializer sr (stream);
 
 		ScopeLock lock (OpenVolumeInfoMutex);
 		OpenVolumeInfo.VirtualDevice = sr.DeserializeString ("VirtualDevice");
 		OpenVolumeInfo.LoopDevice = sr.DeserializeString ("LoopDevice");
+		VolumeInfoCache.reset();
 	}
 
 	void FuseService::SendAuxDeviceInfo (const DirectoryPath &fuseMountPoint, const DevicePath &virtualDevice, const DevicePath &loopDevice)
@@ -588,6 +614,9 @@ namespace VeraCrypt
 
 	VolumeInfo FuseService::OpenVolumeInfo;
 	Mutex FuseService::OpenVolumeInfoMutex;
+	shared_ptr <Buffer> FuseService::VolumeInfoCache;
+	uint64 FuseService::VolumeInfoCacheGeneration;
+	uint64 FuseService::VolumeInfoCacheTime;
 	shared_ptr <Volume> FuseService::MountedVolume;
 	VolumeSlotNumber FuseService::SlotNumber;
 	uid_t FuseService::UserId;
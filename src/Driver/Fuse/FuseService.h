@@ -66,6 +66,10 @@ namespace VeraCrypt
 
 		static VolumeInfo OpenVolumeInfo;
 		static Mutex OpenVolumeInfoMutex;
+		static shared_ptr <Buffer> VolumeInfoCache;		// Serialized OpenVolumeInfo
+		static uint64 VolumeInfoCacheGeneration;	// Volume state generation, which does not change on I/O
+		static uint64 VolumeInfoCacheTime;
+		static const uint64 VolumeInfoCacheMaxAge = 1000000000ULL;	// Nanoseconds; bounds the staleness of I/O counters and elapsed time
 		static shared_ptr <Volume> MountedVolume;
 		static VolumeSlotNumber SlotNumber;
 		static uid_t UserId;
@@ -0,0 +1,203 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include "System.h"
+#include <time.h>
+#include "Platform/JsonObject.h"
+#include "Volume/Version.h"
+#include "BenchmarkBaseline.h"
+#include "LanguageStrings.h"
+#include "UserInterfaceException.h"
+#include "Xml.h"
+
+namespace VeraCrypt
+{
+	void BenchmarkBaseline::Add (const BenchmarkBaselineEntry &entry)
+	{
+		Entries.push_back (entry);
+	}
+
+	void BenchmarkBaseline::Add (const CryptoBenchmarkResult &result)
+	{
+		BenchmarkBaselineEntry entry;
+		wstringstream key;
+		key << StringConverter::ToWide (result.Category) << L"/" << result.Algorithm;
+
+		if (result.Category == "kdf")
+		{
+			key << L"/pim" << result.Pim;
+			entry.HigherIsBetter = false;
+			entry.Unit = L"s";
+		}
+		else
+		{
+			if (result.Category == "encryption")
+				key << L"/" << StringConverter::ToWide (result.Operation);
+
+			key << L"/" << result.BufferSize << L"/" << result.ThreadCount << L"t";
+
+			if (result.HugePages)
+				key << L"/huge";
+			entry.Unit = L"B/s";
+		}
+
+		entry.Key = key.str();
+		entry.Value = result.Statistics.Median;
+		Add (entry);
+	}
+
+	void BenchmarkBaseline::Add (const VolumeBenchmarkResult &result)
+	{
+		BenchmarkBaselineEntry entry;
+		entry.Key = L"volume/" + StringConverter::ToWide (result.Workload.GetName());
+		entry.Unit = L"IOPS";
+		entry.Value = result.GetIops();
+		Add (entry);
+	}
+
+	BenchmarkComparisonList BenchmarkBaseline::Compare (const BenchmarkBaseline &baseline) const
+	{
+		BenchmarkComparisonList comparisons;
+		map <wstring, double> measured;
+
+		foreach (const BenchmarkBaselineEntry &entry, Entries)
+			measured[entry.Key] = entry.Value;
+
+		foreach (const BenchmarkBaselineEntry &baselineEntry, baseline.Entries)
+		{
+			BenchmarkComparison comparison;
+			comparison.Key = baselineEntry.Key;
+			comparison.BaselineValue = baselineEntry.Value;
+			comparison.Tolerance = baselineEntry.Tolerance != 0 ? baselineEntry.Tolerance : baseline.DefaultTolerance;
+			comparison.Unit = baselineEntry.Unit;
+
+			map <wstring, double>::iterator it = measured.find (baselineEntry.Key);
+			if (it == measured.end())
+			{
+				comparison.Missing = true;
+				comparisons.push_back (comparison);
+				continue;
+			}
+
+			comparison.Value = it->second;
+			measured.erase (it);
+
+			if (baselineEntry.Value > 0)
+			{
+				comparison.Change = (comparison.Value - baselineEntry.Value) / baselineEntry.Value * 100;
+				if (!baselineEntry.HigherIsBetter)
+					comparison.Change = -comparison.Change;
+
+				comparison.Regression = comparison.Change < -comparison.Tolerance;
+			}
+
+			comparisons.push_back (comparison);
+		}
+
+		// Measurements without a baseline are reported in the order in which they were made
+		foreach (const BenchmarkBaselineEntry &entry, Entries)
+		{
+			if (measured.find (entry.Key) == measured.end())
+				continue;
+
+			BenchmarkComparison comparison;
+			comparison.Key = entry.Key;
+			comparison.New = true;
+			comparison.Unit = entry.Unit;
+			comparison.Value = entry.Value;
+			comparisons.push_back (comparison);
+		}
+
+		return comparisons;
+	}
+
+	void BenchmarkBaseline::Export (const FilePath &path) const
+	{
+		// Results are appended as JSON objects, one per line, to allow tracking of trends over time
+		File file;
+		if (FilesystemPath (wstring (path)).IsFile())
+		{
+			file.Open (path, File::OpenWrite);
+			file.SeekEnd (0);
+		}
+		else
+			file.Open (path, File::CreateWrite);
+
+		uint64 now = (uint64) time (nullptr);
+		wstring host (wxGetHostName());
+
+		string lines;
+		foreach (const BenchmarkBaselineEntry &entry, Entries)
+		{
+			JsonObject json;
+			json.Add ("time", now);
+			json.Add ("host", host);
+			json.Add ("version", Version::String());
+			json.Add ("key", entry.Key);
+			json.Add ("value", entry.Value);
+			json.Add ("unit", entry.Unit);
+			lines += json.ToString() + "\n";
+		}
+
+		file.Write (ConstBufferPtr ((const byte *) lines.c_str(), lines.size()));
+	}
+
+	void BenchmarkBaseline::Load (const FilePath &path)
+	{
+		XmlParser parser (path);
+		Entries.clear();
+
+		foreach (XmlNode node, parser.GetNodes (L"benchmarks"))
+		{
+			wxString tolerance = node.Attributes[L"tolerance"];
+			if (!tolerance.empty() && (!tolerance.ToDouble (&DefaultTolerance) || DefaultTolerance <= 0))
+				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + wstring (path));
+		}
+
+		foreach (XmlNode node, parser.GetNodes (L"result"))
+		{
+			BenchmarkBaselineEntry entry;
+			entry.Key = wstring (node.Attributes[L"key"]);
+			entry.Unit = wstring (node.Attributes[L"unit"]);
+			entry.HigherIsBetter = node.Attributes[L"lower-is-better"] != L"1";
+
+			if (entry.Key.empty() || !node.InnerText.ToDouble (&entry.Value)
+				|| (!node.Attributes[L"tolerance"].empty() && !node.Attributes[L"tolerance"].ToDouble (&entry.Tolerance)))
+			{
+				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + wstring (path));
+			}
+
+			Add (entry);
+		}
+	}
+
+	void BenchmarkBaseline::Save (const FilePath &path) const
+	{
+		XmlNode baselineXml (L"benchmarks");
+		baselineXml.Attributes[L"tolerance"] = StringConverter::FromNumber (DefaultTolerance);
+
+		foreach (const BenchmarkBaselineEntry &entry, Entries)
+		{
+			XmlNode node (L"result", StringConverter::FromNumber (entry.Value));
+			node.Attributes[L"key"] = entry.Key;
+			node.Attributes[L"unit"] = entry.Unit;
+
+			if (!entry.HigherIsBetter)
+				node.Attributes[L"lower-is-better"] = L"1";
+
+			if (entry.Tolerance != 0)
+				node.Attributes[L"tolerance"] = StringConverter::FromNumber (entry.Tolerance);
+
+			baselineXml.InnerNodes.push_back (node);
+		}
+
+		XmlWriter writer (path);
+		writer.WriteNode (baselineXml);
+		writer.Close();
+	}
+}
@@ -0,0 +1,73 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Main_BenchmarkBaseline
+#define TC_HEADER_Main_BenchmarkBaseline
+
+#include "System.h"
+#include "Main.h"
+#include "Core/VolumeBenchmark.h"
+#include "Volume/CryptoBenchmark.h"
+
+namespace VeraCrypt
+{
+	struct BenchmarkBaselineEntry
+	{
+		BenchmarkBaselineEntry () : HigherIsBetter (true), Tolerance (0), Value (0) { }
+
+		bool HigherIsBetter;
+		wstring Key;
+		double Tolerance;		// Percent; 0 selects the default tolerance of the baseline
+		wstring Unit;
+		double Value;
+	};
+
+	struct BenchmarkComparison
+	{
+		BenchmarkComparison () : BaselineValue (0), Change (0), Missing (false), New (false), Regression (false), Tolerance (0), Value (0) { }
+
+		double BaselineValue;
+		double Change;			// Percent; positive values are improvements
+		wstring Key;
+		bool Missing;			// Present in the baseline but not measured
+		bool New;				// Measured but not present in the baseline
+		bool Regression;
+		double Tolerance;
+		wstring Unit;
+		double Value;
+	};
+
+	typedef list <BenchmarkComparison> BenchmarkComparisonList;
+
+	// Collects benchmark results as a set of named values, which can be saved as
+	// a baseline and compared with a previously saved baseline. The median of
+	// each measurement is recorded to reduce the effect of outliers.
+	class BenchmarkBaseline
+	{
+	public:
+		BenchmarkBaseline () : DefaultTolerance (10) { }
+		virtual ~BenchmarkBaseline () { }
+
+		void Add (const CryptoBenchmarkResult &result);
+		void Add (const VolumeBenchmarkResult &result);
+		BenchmarkComparisonList Compare (const BenchmarkBaseline &baseline) const;
+		void Export (const FilePath &path) const;
+		double GetDefaultTolerance () const { return DefaultTolerance; }
+		bool IsEmpty () const { return Entries.empty(); }
+		void Load (const FilePath &path);
+		void Save (const FilePath &path) const;
+
+	protected:
+		void Add (const BenchmarkBaselineEntry &entry);
+
+		double DefaultTolerance;
+		list <BenchmarkBaselineEntry> Entries;
+	};
+}
+
+#endif // TC_HEADER_Main_BenchmarkBaseline
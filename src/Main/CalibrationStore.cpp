@@ -0,0 +1,161 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include "System.h"
+#include "Application.h"
+#include "CalibrationStore.h"
+#include "Xml.h"
+
+namespace VeraCrypt
+{
+	struct CalibrationThreadFunctor : public Functor
+	{
+		virtual void operator() ()
+		{
+			CalibrationStore::MeasureAndSave();
+		}
+	};
+
+	void CalibrationStore::EnsureCalibrated ()
+	{
+		if (Calibration::IsCalibrated())
+			return;
+
+		// Calibration only tunes performance and its failure must not prevent the requested operation
+		try
+		{
+			if (Load())
+				return;
+		}
+		catch (...) { }
+
+		// The text user interface uses the default tuning until the user runs --calibrate, as a
+		// measurement would delay the requested operation. The graphic user interface is not
+		// blocked by the measurement, and operations started before it completes use the default tuning.
+		if (Application::GetUserInterfaceType() != UserInterfaceType::Graphic)
+			return;
+
+		ScopeLock lock (CalibrationThreadMutex);
+		if (!CalibrationThreadStarted)
+		{
+			CalibrationThread.Start (new CalibrationThreadFunctor);
+			CalibrationThreadStarted = true;
+		}
+	}
+
+	bool CalibrationStore::Load ()
+	{
+		FilePath path = Application::GetConfigFilePath (GetFileName());
+		if (!path.IsFile())
+			return false;
+
+		XmlParser parser (path);
+		CalibrationData data;
+
+		foreach (XmlNode node, parser.GetNodes (L"calibration"))
+		{
+			data.CpuCount = StringConverter::ToUInt64 (wstring (node.Attributes[L"cpus"]));
+			data.MinFragmentSize = (size_t) StringConverter::ToUInt64 (wstring (node.Attributes[L"min-fragment-size"]));
+			data.Time = StringConverter::ToUInt64 (wstring (node.Attributes[L"time"]));
+		}
+
+		foreach (XmlNode node, parser.GetNodes (L"cipher"))
+		{
+			CalibrationCipherSpeed speed;
+			speed.Algorithm = wstring (node.Attributes[L"algorithm"]);
+			speed.BufferSize = (size_t) StringConverter::ToUInt64 (wstring (node.Attributes[L"size"]));
+			speed.ThreadCount = (size_t) StringConverter::ToUInt64 (wstring (node.Attributes[L"threads"]));
+
+			if (!node.InnerText.ToDouble (&speed.Speed))
+				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + wstring (path));
+
+			data.CipherSpeeds.push_back (speed);
+		}
+
+		foreach (XmlNode node, parser.GetNodes (L"kdf"))
+		{
+			double iterationTime;
+			if (!node.InnerText.ToDouble (&iterationTime))
+				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + wstring (path));
+
+			data.KdfIterationTimes[wstring (node.Attributes[L"name"])] = iterationTime;
+		}
+
+		foreach (XmlNode node, parser.GetNodes (L"device"))
+			data.DeviceLatencies[wstring (node.Attributes[L"path"])] = StringConverter::ToUInt64 (wstring (node.InnerText));
+
+		// Data measured on different hardware is not used
+		if (!Calibration::IsCurrent (data))
+			return false;
+
+		Calibration::Apply (data);
+		return true;
+	}
+
+	void CalibrationStore::MeasureAndSave ()
+	{
+		try
+		{
+			CalibrationData data = Calibration::Measure (CalibrationOptions());
+			Calibration::Apply (data);
+			Save (data);
+		}
+		catch (...) { }
+	}
+
+	void CalibrationStore::Save (const CalibrationData &data)
+	{
+		XmlNode calibrationXml (L"calibration");
+		calibrationXml.Attributes[L"cpus"] = StringConverter::FromNumber (data.CpuCount);
+		calibrationXml.Attributes[L"min-fragment-size"] = StringConverter::FromNumber ((uint64) data.MinFragmentSize);
+		calibrationXml.Attributes[L"time"] = StringConverter::FromNumber (data.Time);
+
+		foreach (const CalibrationCipherSpeed &speed, data.CipherSpeeds)
+		{
+			XmlNode node (L"cipher", StringConverter::FromNumber (speed.Speed));
+			node.Attributes[L"algorithm"] = speed.Algorithm;
+			node.Attributes[L"size"] = StringConverter::FromNumber ((uint64) speed.BufferSize);
+			node.Attributes[L"threads"] = StringConverter::FromNumber ((uint64) speed.ThreadCount);
+			calibrationXml.InnerNodes.push_back (node);
+		}
+
+		typedef pair <wstring, double> KdfTimePair;
+		foreach (KdfTimePair kdf, data.KdfIterationTimes)
+		{
+			XmlNode node (L"kdf", StringConverter::FromNumber (kdf.second));
+			node.Attributes[L"name"] = kdf.first;
+			calibrationXml.InnerNodes.push_back (node);
+		}
+
+		typedef pair <wstring, uint64> DeviceLatencyPair;
+		foreach (DeviceLatencyPair device, data.DeviceLatencies)
+		{
+			XmlNode node (L"device", StringConverter::FromNumber (device.second));
+			node.Attributes[L"path"] = device.first;
+			calibrationXml.InnerNodes.push_back (node);
+		}
+
+		XmlWriter writer (Application::GetConfigFilePath (GetFileName(), true));
+		writer.WriteNode (calibrationXml);
+		writer.Close();
+	}
+
+	void CalibrationStore::WaitForCalibration ()
+	{
+		ScopeLock lock (CalibrationThreadMutex);
+		if (CalibrationThreadStarted)
+		{
+			CalibrationThread.Join();
+			CalibrationThreadStarted = false;
+		}
+	}
+
+	Thread CalibrationStore::CalibrationThread;
+	bool CalibrationStore::CalibrationThreadStarted = false;
+	Mutex CalibrationStore::CalibrationThreadMutex;
+}
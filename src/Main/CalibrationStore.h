@@ -0,0 +1,40 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Main_CalibrationStore
+#define TC_HEADER_Main_CalibrationStore
+
+#include "System.h"
+#include "Main.h"
+#include "Volume/Calibration.h"
+
+namespace VeraCrypt
+{
+	// Keeps the calibration data of this host in the configuration directory
+	class CalibrationStore
+	{
+	public:
+		static void EnsureCalibrated ();
+		static bool Load ();
+		static void MeasureAndSave ();
+		static void Save (const CalibrationData &data);
+		static void WaitForCalibration ();
+
+	protected:
+		static wxString GetFileName () { return L"Calibration.xml"; }
+
+		static Thread CalibrationThread;
+		static bool CalibrationThreadStarted;
+		static Mutex CalibrationThreadMutex;
+
+	private:
+		CalibrationStore ();
+	};
+}
+
+#endif // TC_HEADER_Main_CalibrationStore
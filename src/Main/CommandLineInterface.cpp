@@ -11,6 +11,7 @@
 */
 
 #include "System.h"
+#include <limits.h>
 #include <wx/cmdline.h>
 #include <wx/tokenzr.h>
 #include "Core/Core.h"
@@ -24,6 +25,8 @@ namespace VeraCrypt
 	CommandLineInterface::CommandLineInterface (int argc, wchar_t** argv, UserInterfaceType::Enum interfaceType) :
 		ArgCommand (CommandId::None),
 		ArgFilesystem (VolumeCreationOptions::FilesystemType::Unknown),
+		ArgIoLimit (0),
+		ArgJsonOutput (false),
 		ArgNewPim (-1),
 		ArgNoHiddenVolumeProtection (false),
 		ArgPim (-1),
@@ -45,10 +48,26 @@ namespace VeraCrypt
 		parser.AddOption (L"",  L"auto-mount",			_("Auto mount device-hosted/favorite volumes"));
 		parser.AddSwitch (L"",  L"backup-headers",		_("Backup volume headers"));
 		parser.AddSwitch (L"",  L"background-task",		_("Start Background Task"));
+		parser.AddSwitch (L"",	L"benchmark",			_("Measure performance of algorithms and volume I/O"));
+		parser.AddOption (L"",	L"benchmark-baseline",	_("Compare benchmark results with a baseline file"));
+		parser.AddOption (L"",	L"benchmark-depths",	_("Queue depths of volume benchmark workloads"));
+		parser.AddOption (L"",	L"benchmark-export",	_("Append benchmark results to a file"));
+		parser.AddSwitch (L"",	L"benchmark-huge-pages",	_("Use buffers backed by huge pages in benchmarks"));
+		parser.AddOption (L"",	L"benchmark-repeat",	_("Number of repetitions of each measurement"));
+		parser.AddOption (L"",	L"benchmark-save-baseline", _("Save benchmark results as a baseline file"));
+		parser.AddOption (L"",	L"benchmark-sizes",		_("Buffer sizes used by benchmarks"));
+		parser.AddOption (L"",	L"benchmark-threads",	_("Thread counts used by benchmarks"));
+		parser.AddOption (L"",	L"benchmark-time",		_("Duration of each volume benchmark workload in seconds"));
+		parser.AddOption (L"",	L"benchmark-type",		_("Benchmarks to run"));
+		parser.AddOption (L"",	L"benchmark-workloads",	_("Access patterns of volume benchmark workloads"));
+		parser.AddSwitch (L"",	L"calibrate",			_("Measure performance of this computer to tune runtime decisions"));
 #ifdef TC_WINDOWS
 		parser.AddSwitch (L"",  L"cache",				_("Cache passwords and keyfiles"));
 #endif
 		parser.AddSwitch (L"C", L"change",				_("Change password or keyfiles"));
+		parser.AddOption (L"",	L"clone",				_("Clone volume to a new volume with a new master key"));
+		parser.AddSwitch (L"",	L"compact-container",	_("Deallocate unused space of a file container"));
+		parser.AddOption (L"",	L"copy-container",		_("Copy a file container preserving unallocated space"));
 		parser.AddSwitch (L"c", L"create",				_("Create new volume"));
 		parser.AddSwitch (L"",	L"create-keyfile",		_("Create new keyfile"));
 		parser.AddSwitch (L"",	L"delete-token-keyfiles", _("Delete security token keyfiles"));
@@ -65,10 +84,13 @@ namespace VeraCrypt
 		parser.AddOption (L"",	L"hash",				_("Hash algorithm"));
 		parser.AddSwitch (L"h", L"help",				_("Display detailed command line help"), wxCMD_LINE_OPTION_HELP);
 		parser.AddSwitch (L"",	L"import-token-keyfiles", _("Import keyfiles to security token"));
+		parser.AddOption (L"",	L"io-limit",			_("Maximum combined write rate in bytes per second"));
+		parser.AddSwitch (L"",	L"json",				_("Use JSON output"));
 		parser.AddOption (L"k", L"keyfiles",			_("Keyfiles"));
 		parser.AddSwitch (L"l", L"list",				_("List mounted volumes"));
 		parser.AddSwitch (L"",	L"list-token-keyfiles",	_("List security token keyfiles"));
 		parser.AddSwitch (L"",	L"load-preferences",	_("Load user preferences"));
+		parser.AddOption (L"",	L"manifest",			_("Manifest file listing volumes for batch operations"));
 		parser.AddSwitch (L"",	L"mount",				_("Mount volume interactively"));
 		parser.AddOption (L"m", L"mount-options",		_("VeraCrypt volume mount options"));
 		parser.AddOption (L"",	L"new-hash",			_("New hash algorithm"));
@@ -79,6 +101,8 @@ namespace VeraCrypt
 		parser.AddSwitch (L"",  L"stdin",				_("Read password from standard input"));
 		parser.AddOption (L"p", L"password",			_("Password"));
 		parser.AddOption (L"",  L"pim",					_("PIM"));
+		parser.AddSwitch (L"",	L"profile-startup",		_("Report duration of startup phases"));
+		parser.AddOption (L"",	L"progress-fd",			_("Write progress events to file descriptor"));
 		parser.AddOption (L"",	L"protect-hidden",		_("Protect hidden volume"));
 		parser.AddOption (L"",	L"protection-hash",		_("Hash algorithm for protected hidden volume"));
 		parser.AddOption (L"",	L"protection-keyfiles",	_("Keyfiles for protected hidden volume"));
@@ -182,6 +206,223 @@ namespace VeraCrypt
 			param1IsVolume = true;
 		}
 
+		if (parser.Found (L"benchmark"))
+		{
+			CheckCommandSingle();
+
+			if (interfaceType != UserInterfaceType::Text)
+				throw_err (L"--benchmark is supported only in text mode");
+
+			ArgCommand = CommandId::Benchmark;
+			ArgBenchmarkOptions.reset (new CryptoBenchmarkOptions);
+			param1IsFile = true;
+		}
+
+		if (parser.Found (L"calibrate"))
+		{
+			CheckCommandSingle();
+
+			if (interfaceType != UserInterfaceType::Text)
+				throw_err (L"--calibrate is supported only in text mode");
+
+			ArgCommand = CommandId::Calibrate;
+			param1IsFile = true;
+		}
+
+		if (parser.Found (L"benchmark-type", &str))
+		{
+			if (!ArgBenchmarkOptions)
+				throw_err (L"--benchmark-type can only be used with --benchmark");
+
+			ArgBenchmarkOptions->Encryption = false;
+			ArgBenchmarkOptions->Hash = false;
+			ArgBenchmarkOptions->Kdf = false;
+
+			wxStringTokenizer tokenizer (str, L",");
+			while (tokenizer.HasMoreTokens())
+			{
+				wxString token = tokenizer.GetNextToken();
+
+				if (token == L"encryption")
+					ArgBenchmarkOptions->Encryption = true;
+				else if (token == L"hash")
+					ArgBenchmarkOptions->Hash = true;
+				else if (token == L"kdf")
+					ArgBenchmarkOptions->Kdf = true;
+				else if (token == L"volume")
+					ArgVolumeBenchmarkOptions.reset (new VolumeBenchmarkOptions);
+				else
+					throw_err (LangString["UNKNOWN_OPTION"] + L": " + token);
+			}
+		}
+
+		if (parser.Found (L"benchmark-sizes", &str))
+		{
+			if (!ArgBenchmarkOptions)
+				throw_err (L"--benchmark-sizes can only be used with --benchmark");
+
+			wxStringTokenizer tokenizer (str, L",");
+			while (tokenizer.HasMoreTokens())
+			{
+				uint64 size = ParseSize (tokenizer.GetNextToken());
+				if (size < ENCRYPTION_DATA_UNIT_SIZE || size > BYTES_PER_GB || size % ENCRYPTION_DATA_UNIT_SIZE != 0)
+					throw_err (LangString["PARAMETER_INCORRECT"] + L": " + str);
+
+				ArgBenchmarkOptions->BufferSizes.push_back ((size_t) size);
+			}
+		}
+
+		if (parser.Found (L"benchmark-threads", &str))
+		{
+			if (!ArgBenchmarkOptions)
+				throw_err (L"--benchmark-threads can only be used with --benchmark");
+
+			wxStringTokenizer tokenizer (str, L",");
+			while (tokenizer.HasMoreTokens())
+			{
+				unsigned long threadCount;
+				if (!tokenizer.GetNextToken().ToULong (&threadCount) || threadCount < 1 || threadCount > 32)
+					throw_err (LangString["PARAMETER_INCORRECT"] + L": " + str);
+
+				ArgBenchmarkOptions->ThreadCounts.push_back ((size_t) threadCount);
+			}
+		}
+
+		if (parser.Found (L"benchmark-repeat", &str))
+		{
+			unsigned long repetitions;
+			if (!ArgBenchmarkOptions)
+				throw_err (L"--benchmark-repeat can only be used with --benchmark");
+
+			if (!str.ToULong (&repetitions) || repetitions < 1 || repetitions > 1000)
+				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + str);
+
+			ArgBenchmarkOptions->Repetitions = repetitions;
+		}
+
+		if (parser.Found (L"benchmark-baseline", &str))
+		{
+			if (!ArgBenchmarkOptions)
+				throw_err (L"--benchmark-baseline can only be used with --benchmark");
+
+			ArgBenchmarkBaselinePath.reset (new FilePath (wstring (str)));
+		}
+
+		if (parser.Found (L"benchmark-export", &str))
+		{
+			if (!ArgBenchmarkOptions)
+				throw_err (L"--benchmark-export can only be used with --benchmark");
+
+			ArgBenchmarkExportPath.reset (new FilePath (wstring (str)));
+		}
+
+		if (parser.Found (L"benchmark-huge-pages"))
+		{
+			if (!ArgBenchmarkOptions)
+				throw_err (L"--benchmark-huge-pages can only be used with --benchmark");
+
+			ArgBenchmarkOptions->HugePages = true;
+		}
+
+		if (parser.Found (L"benchmark-save-baseline", &str))
+		{
+			if (!ArgBenchmarkOptions)
+				throw_err (L"--benchmark-save-baseline can only be used with --benchmark");
+
+			ArgBenchmarkSaveBaselinePath.reset (new FilePath (wstring (str)));
+		}
+
+		list <wxString> volumeBenchmarkPatterns;
+		if (parser.Found (L"benchmark-workloads", &str))
+		{
+			if (!ArgVolumeBenchmarkOptions)
+				throw_err (L"--benchmark-workloads can only be used with --benchmark-type=volume");
+
+			wxStringTokenizer tokenizer (str, L",");
+			while (tokenizer.HasMoreTokens())
+			{
+				wxString token = tokenizer.GetNextToken();
+
+				if (token != L"seqread" && token != L"seqwrite" && token != L"randread" && token != L"randwrite" && token != L"randrw")
+					throw_err (LangString["UNKNOWN_OPTION"] + L": " + token);
+
+				volumeBenchmarkPatterns.push_back (token);
+			}
+		}
+
+		list <size_t> volumeBenchmarkDepths;
+		if (parser.Found (L"benchmark-depths", &str))
+		{
+			if (!ArgVolumeBenchmarkOptions)
+				throw_err (L"--benchmark-depths can only be used with --benchmark-type=volume");
+
+			wxStringTokenizer tokenizer (str, L",");
+			while (tokenizer.HasMoreTokens())
+			{
+				unsigned long depth;
+				if (!tokenizer.GetNextToken().ToULong (&depth) || depth < 1 || depth > 64)
+					throw_err (LangString["PARAMETER_INCORRECT"] + L": " + str);
+
+				volumeBenchmarkDepths.push_back ((size_t) depth);
+			}
+		}
+
+		if (parser.Found (L"benchmark-time", &str))
+		{
+			unsigned long seconds;
+			if (!ArgVolumeBenchmarkOptions)
+				throw_err (L"--benchmark-time can only be used with --benchmark-type=volume");
+
+			if (!str.ToULong (&seconds) || seconds < 1 || seconds > 3600)
+				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + str);
+
+			ArgVolumeBenchmarkOptions->Duration = seconds * 1000;
+		}
+
+		if (ArgVolumeBenchmarkOptions
+			&& (!volumeBenchmarkPatterns.empty() || !volumeBenchmarkDepths.empty()
+				|| !ArgBenchmarkOptions->BufferSizes.empty() || !ArgBenchmarkOptions->ThreadCounts.empty()))
+		{
+			// The workloads are the combinations of all given patterns, block sizes, queue depths and thread counts
+			if (volumeBenchmarkPatterns.empty())
+			{
+				volumeBenchmarkPatterns.push_back (L"randread");
+				volumeBenchmarkPatterns.push_back (L"randwrite");
+			}
+
+			list <size_t> blockSizes = ArgBenchmarkOptions->BufferSizes;
+			if (blockSizes.empty())
+				blockSizes.push_back (4 * BYTES_PER_KB);
+
+			if (volumeBenchmarkDepths.empty())
+				volumeBenchmarkDepths.push_back (1);
+
+			list <size_t> threadCounts = ArgBenchmarkOptions->ThreadCounts;
+			if (threadCounts.empty())
+				threadCounts.push_back (1);
+
+			foreach (const wxString &pattern, volumeBenchmarkPatterns)
+			{
+				foreach (size_t blockSize, blockSizes)
+				{
+					foreach (size_t depth, volumeBenchmarkDepths)
+					{
+						foreach (size_t threadCount, threadCounts)
+						{
+							VolumeBenchmarkWorkload workload;
+							workload.BlockSize = blockSize;
+							workload.QueueDepth = depth;
+							workload.Random = pattern.StartsWith (L"rand");
+							workload.ReadPercentage = pattern.EndsWith (L"read") ? 100 : (pattern.EndsWith (L"write") ? 0 : 70);
+							workload.ThreadCount = threadCount;
+
+							ArgVolumeBenchmarkOptions->Workloads.push_back (workload);
+						}
+					}
+				}
+			}
+		}
+
 		if (parser.Found (L"change"))
 		{
 			CheckCommandSingle();
@@ -189,6 +430,40 @@ namespace VeraCrypt
 			param1IsVolume = true;
 		}
 
+		if (parser.Found (L"clone", &str))
+		{
+			CheckCommandSingle();
+
+			if (interfaceType != UserInterfaceType::Text)
+				throw_err (L"--clone is supported only in text mode");
+
+			wxFileName targetPath (str);
+			targetPath.Normalize (wxPATH_NORM_ABSOLUTE | wxPATH_NORM_DOTS);
+
+			ArgCommand = CommandId::CloneVolume;
+			ArgCloneTargetPath.reset (new VolumePath (wstring (targetPath.GetFullPath())));
+			param1IsVolume = true;
+		}
+
+		if (parser.Found (L"compact-container"))
+		{
+			CheckCommandSingle();
+			ArgCommand = CommandId::CompactContainer;
+			param1IsVolume = true;
+		}
+
+		if (parser.Found (L"copy-container", &str))
+		{
+			CheckCommandSingle();
+
+			wxFileName targetPath (str);
+			targetPath.Normalize (wxPATH_NORM_ABSOLUTE | wxPATH_NORM_DOTS);
+
+			ArgCommand = CommandId::CopyContainer;
+			ArgCopyTargetPath.reset (new FilePath (wstring (targetPath.GetFullPath())));
+			param1IsVolume = true;
+		}
+
 		if (parser.Found (L"create"))
 		{
 			CheckCommandSingle();
@@ -276,6 +551,7 @@ namespace VeraCrypt
 			ArgMountOptions.CachePassword = true;
 #endif
 		ArgDisplayPassword = parser.Found (L"display-password");
+		ArgJsonOutput = parser.Found (L"json");
 
 		if (parser.Found (L"encryption", &str))
 		{
@@ -541,6 +817,15 @@ namespace VeraCrypt
 				throw_err (LangString["UNKNOWN_OPTION"] + L": " + str);
 		}
 
+		if (parser.Found (L"progress-fd", &str))
+		{
+			unsigned long fd;
+			if (!str.ToULong (&fd) || fd > INT_MAX)
+				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + str);
+
+			EventStream::SetFileDescriptor ((int) fd);
+		}
+
 		ArgQuick = parser.Found (L"quick");
 
 		if (parser.Found (L"random-source", &str))
@@ -553,6 +838,28 @@ namespace VeraCrypt
 			param1IsVolume = true;
 		}
 
+		if (parser.Found (L"manifest", &str))
+		{
+			if (interfaceType != UserInterfaceType::Text)
+				throw_err (L"--manifest is supported only in text mode");
+
+			if (ArgCommand != CommandId::BackupHeaders && ArgCommand != CommandId::RestoreHeaders && ArgCommand != CommandId::CreateVolume)
+				throw_err (L"--manifest can only be used with --backup-headers, --restore-headers or --create");
+
+			ArgManifestPath.reset (new FilePath (str.wc_str()));
+			param1IsVolume = false;
+		}
+
+		if (parser.Found (L"io-limit", &str))
+		{
+			if (!ArgManifestPath || ArgCommand != CommandId::CreateVolume)
+				throw_err (L"--io-limit can only be used with --create --manifest");
+
+			ArgIoLimit = ParseSize (str);
+			if (ArgIoLimit == 0)
+				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + str);
+		}
+
 		if (parser.Found (L"slot", &str))
 		{
 			unsigned long number;
@@ -573,43 +880,7 @@ namespace VeraCrypt
 		}
 
 		if (parser.Found (L"size", &str))
-		{
-			uint64 multiplier;
-			wxChar lastChar = str [str.Length () - 1];
-			if (lastChar >= wxT('0') && lastChar <= wxT('9'))
-				multiplier = 1;
-			else if (lastChar == wxT('K') || lastChar == wxT('k'))
-				multiplier = BYTES_PER_KB;
-			else if (lastChar == wxT('M') || lastChar == wxT('m'))
-				multiplier = BYTES_PER_MB;
-			else if (lastChar == wxT('G') || lastChar == wxT('g'))
-				multiplier = BYTES_PER_GB;
-			else if (lastChar == wxT('T') || lastChar == wxT('t'))
-				multiplier = BYTES_PER_TB;
-			else
-				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + str);
-
-			// remove suffix if present
-			if (multiplier != 1)
-				str.RemoveLast ();
-			// check that we only have digits in the string
-			size_t index = str.find_first_not_of (wxT("0123456789"));
-			if (index != (size_t) wxNOT_FOUND)
-			{
-				// restore last characater for error display
-				if (multiplier != 1)
-					str += lastChar;
-				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + str);
-			}
-			try
-			{
-				ArgSize = multiplier * StringConverter::ToUInt64 (wstring (str));
-			}
-			catch (...)
-			{
-				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + str);
-			}
-		}
+			ArgSize = ParseSize (str);
 
 		if (parser.Found (L"token-lib", &str))
 			Preferences.SecurityTokenModule = wstring (str);
@@ -704,6 +975,43 @@ namespace VeraCrypt
 			throw_err (_("Only a single command can be specified at a time."));
 	}
 
+	uint64 CommandLineInterface::ParseSize (wxString str)
+	{
+		wxString arg = str;
+		uint64 multiplier = 1;
+		wxChar lastChar = str.IsEmpty() ? wxT('0') : str [str.Length () - 1];
+
+		if (lastChar == wxT('K') || lastChar == wxT('k'))
+			multiplier = BYTES_PER_KB;
+		else if (lastChar == wxT('M') || lastChar == wxT('m'))
+			multiplier = BYTES_PER_MB;
+		else if (lastChar == wxT('G') || lastChar == wxT('g'))
+			multiplier = BYTES_PER_GB;
+		else if (lastChar == wxT('T') || lastChar == wxT('t'))
+			multiplier = BYTES_PER_TB;
+
+		if (multiplier != 1)
+			str.RemoveLast ();
+
+		if (str.IsEmpty() || str.find_first_not_of (wxT("0123456789")) != (size_t) wxNOT_FOUND)
+			throw_err (LangString["PARAMETER_INCORRECT"] + L": " + arg);
+
+		uint64 value;
+		try
+		{
+			value = StringConverter::ToUInt64 (wstring (str));
+		}
+		catch (...)
+		{
+			throw_err (LangString["PARAMETER_INCORRECT"] + L": " + arg);
+		}
+
+		if (value > ((uint64) -1) / multiplier)
+			throw_err (LangString["PARAMETER_INCORRECT"] + L": " + arg);
+
+		return value * multiplier;
+	}
+
 	shared_ptr <KeyfileList> CommandLineInterface::ToKeyfileList (const wxString &arg) const
 	{
 		wxStringTokenizer tokenizer (arg, L",", wxTOKEN_RET_EMPTY_ALL);
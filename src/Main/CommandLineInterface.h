@@ -17,6 +17,9 @@
 #include "Main.h"
 #include "Volume/VolumeInfo.h"
 #include "Core/MountOptions.h"
+#include "Core/VolumeCloner.h"
+#include "Core/VolumeBenchmark.h"
+#include "Volume/CryptoBenchmark.h"
 #include "Core/VolumeCreator.h"
 #include "UserPreferences.h"
 #include "UserInterfaceType.h"
@@ -32,7 +35,12 @@ namespace VeraCrypt
 			AutoMountDevicesFavorites,
 			AutoMountFavorites,
 			BackupHeaders,
+			Benchmark,
+			Calibrate,
 			ChangePassword,
+			CloneVolume,
+			CompactContainer,
+			CopyContainer,
 			CreateKeyfile,
 			CreateVolume,
 			DeleteSecurityTokenKeyfiles,
@@ -57,15 +65,25 @@ namespace VeraCrypt
 		CommandLineInterface (int argc, wchar_t** argv, UserInterfaceType::Enum interfaceType);
 		virtual ~CommandLineInterface ();
 
+		static uint64 ParseSize (wxString str);	// Size with an optional K, M, G or T suffix
 
+		shared_ptr <FilePath> ArgBenchmarkBaselinePath;
+		shared_ptr <FilePath> ArgBenchmarkExportPath;
+		shared_ptr <CryptoBenchmarkOptions> ArgBenchmarkOptions;
+		shared_ptr <FilePath> ArgBenchmarkSaveBaselinePath;
 		CommandId::Enum ArgCommand;
+		shared_ptr <VolumePath> ArgCloneTargetPath;
+		shared_ptr <FilePath> ArgCopyTargetPath;
 		bool ArgDisplayPassword;
 		shared_ptr <EncryptionAlgorithm> ArgEncryptionAlgorithm;
 		shared_ptr <FilePath> ArgFilePath;
 		VolumeCreationOptions::FilesystemType::Enum ArgFilesystem;
 		bool ArgForce;
 		shared_ptr <Hash> ArgHash;
+		uint64 ArgIoLimit;
+		bool ArgJsonOutput;
 		shared_ptr <KeyfileList> ArgKeyfiles;
+		shared_ptr <FilePath> ArgManifestPath;
 		MountOptions ArgMountOptions;
 		shared_ptr <DirectoryPath> ArgMountPoint;
 		shared_ptr <Hash> ArgNewHash;
@@ -78,6 +96,7 @@ namespace VeraCrypt
 		bool ArgQuick;
 		FilesystemPath ArgRandomSourcePath;
 		uint64 ArgSize;
+		shared_ptr <VolumeBenchmarkOptions> ArgVolumeBenchmarkOptions;
 		shared_ptr <VolumePath> ArgVolumePath;
 		VolumeInfoList ArgVolumes;
 		VolumeType::Enum ArgVolumeType;
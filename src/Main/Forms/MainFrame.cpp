@@ -23,6 +23,7 @@
 #include "Main/Main.h"
 #include "Main/Resources.h"
 #include "Main/Application.h"
+#include "Main/CalibrationStore.h"
 #include "Main/GraphicUserInterface.h"
 #include "Main/VolumeHistory.h"
 #include "Main/Xml.h"
@@ -486,6 +487,7 @@ namespace VeraCrypt
 
 			LoadFavoriteVolumes();
 			VolumeHistory::Load();
+			CalibrationStore::EnsureCalibrated();
 
 			if (VolumePathComboBox->GetValue().empty() && !VolumeHistory::Get().empty())
 				SetVolumePath (VolumeHistory::Get().front());
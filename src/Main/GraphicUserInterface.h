@@ -32,10 +32,13 @@ namespace VeraCrypt
 		virtual bool AskYesNo (const wxString &message, bool defaultYes = false, bool warning = false) const;
 		virtual void AutoDismountVolumes (VolumeInfoList mountedVolumes, bool alwaysForce = true);
 		virtual void BackupVolumeHeaders (shared_ptr <VolumePath> volumePath) const;
+		virtual void Benchmark (const CryptoBenchmarkOptions &options, bool jsonOutput, BenchmarkBaseline &results) const { ThrowTextModeRequired(); }
+		virtual void BenchmarkVolume (const VolumeBenchmarkOptions &options, bool jsonOutput, BenchmarkBaseline &results) const { ThrowTextModeRequired(); }
 		virtual void BeginBusyState () const { wxBeginBusyCursor(); }
 		virtual void BeginInteractiveBusyState (wxWindow *window);
 		virtual void ChangePassword (shared_ptr <VolumePath> volumePath = shared_ptr <VolumePath>(), shared_ptr <VolumePassword> password = shared_ptr <VolumePassword>(), int pim = 0, shared_ptr <Hash> currentHash = shared_ptr <Hash>(), bool truecryptMode = false, shared_ptr <KeyfileList> keyfiles = shared_ptr <KeyfileList>(), shared_ptr <VolumePassword> newPassword = shared_ptr <VolumePassword>(), int newPim = 0, shared_ptr <KeyfileList> newKeyfiles = shared_ptr <KeyfileList>(), shared_ptr <Hash> newHash = shared_ptr <Hash>()) const { ThrowTextModeRequired(); }
 		wxHyperlinkCtrl *CreateHyperlink (wxWindow *parent, const wxString &linkUrl, const wxString &linkText) const;
+		virtual void CloneVolume (shared_ptr <VolumePath> volumePath, shared_ptr <VolumePassword> password, int pim, shared_ptr <Hash> currentHash, shared_ptr <KeyfileList> keyfiles, shared_ptr <VolumeCloneOptions> options) const { ThrowTextModeRequired(); }
 		virtual void CreateKeyfile (shared_ptr <FilePath> keyfilePath = shared_ptr <FilePath>()) const;
 		virtual void CreateVolume (shared_ptr <VolumeCreationOptions> options) const { ThrowTextModeRequired(); }
 		virtual void ClearListCtrlSelection (wxListCtrl *listCtrl) const;
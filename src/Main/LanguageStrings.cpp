@@ -11,13 +11,17 @@
 */
 
 #include "System.h"
+#include "Platform/StartupProfiler.h"
 #include "Resources.h"
 #include "LanguageStrings.h"
+#include "LanguageTable.h"
 #include "Xml.h"
 
 namespace VeraCrypt
 {
-	LanguageStrings::LanguageStrings ()
+#	include "Common/Language.table.h"
+
+	LanguageStrings::LanguageStrings () : Loaded (false)
 	{
 	}
 
@@ -27,39 +31,64 @@ namespace VeraCrypt
 
 	wxString LanguageStrings::operator[] (const string &key) const
 	{
-		if (Map.count (key) > 0)
+		Load();
+
+		if (!Map.empty() && Map.count (key) > 0)
 			return wxString (Map.find (key)->second);
 
+		const LanguageTableEntry *entry = FindDefault (key);
+		if (entry)
+			return wxString::FromUTF8 (LanguageTableText + entry->TextOffset, (size_t) entry->TextLength);
+
 		return wxString (L"?") + StringConverter::ToWide (key) + L"?";
 	}
 
+	bool LanguageStrings::Exists (const string &key) const
+	{
+		Load();
+		return Map.find (key) != Map.end() || FindDefault (key) != nullptr;
+	}
+
+	const LanguageTableEntry *LanguageStrings::FindDefault (const string &key)
+	{
+		const size_t bucketCount = array_capacity (LanguageTableBucketSeeds);
+		const size_t entryCount = array_capacity (LanguageTableEntries);
+
+		uint32 seed = LanguageTableBucketSeeds[LanguageTableHash (key.c_str(), key.size(), 0) % bucketCount];
+		const LanguageTableEntry &entry = LanguageTableEntries[LanguageTableHash (key.c_str(), key.size(), seed) % entryCount];
+
+		if (entry.KeyLength != key.size() || memcmp (LanguageTableKeys + entry.KeyOffset, key.c_str(), key.size()) != 0)
+			return nullptr;
+
+		return &entry;
+	}
+
 	wstring LanguageStrings::Get (const string &key) const
 	{
 		return wstring (LangString[key]);
 	}
 
-	void LanguageStrings::Init ()
+	void LanguageStrings::Load () const
 	{
-#ifdef TC_LINUX
-		static byte LanguageXml[] =
-        {
-#           include "Common/Language.xml.h"
-            , 0
-        };
-		string def = string ((const char*) LanguageXml);
-		foreach (XmlNode node, XmlParser (def).GetNodes (L"entry"))
-		{
-			wxString text = node.InnerText;
-			text.Replace (L"\\n", L"\n");
-			Map[StringConverter::ToSingle (wstring (node.Attributes[L"key"]))] = text;
-		}
-#endif
-		foreach (XmlNode node, XmlParser (Resources::GetLanguageXml()).GetNodes (L"entry"))
+		ScopeLock lock (LoadMutex);
+		if (Loaded)
+			return;
+
+		Loaded = true;
+
+		// English strings are built in; only a translation needs to be parsed
+		string translation = Resources::GetTranslationXml();
+		if (translation.empty())
+			return;
+
+		foreach (XmlNode node, XmlParser (translation).GetNodes (L"entry"))
 		{
 			wxString text = node.InnerText;
 			text.Replace (L"\\n", L"\n");
 			Map[StringConverter::ToSingle (wstring (node.Attributes[L"key"]))] = text;
 		}
+
+		StartupProfiler::Mark ("language strings");
 	}
 
 	LanguageStrings LangString;
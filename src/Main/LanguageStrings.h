@@ -18,6 +18,8 @@
 
 namespace VeraCrypt
 {
+	struct LanguageTableEntry;
+
 	class LanguageStrings
 	{
 	public:
@@ -26,12 +28,19 @@ namespace VeraCrypt
 
 		wxString operator[] (const string &key) const;
 
-		bool Exists (const string &key) const { return Map.find (key) != Map.end(); }
+		bool Exists (const string &key) const;
 		wstring Get (const string &key) const;
-		void Init ();
+		void Init () { Load(); }
 
 	protected:
-		map <string, wstring> Map;
+		// English strings are looked up in a table generated at build time. A translation,
+		// if one is selected, is parsed on first use as most command line operations need no strings.
+		static const LanguageTableEntry *FindDefault (const string &key);
+		void Load () const;
+
+		mutable bool Loaded;
+		mutable Mutex LoadMutex;
+		mutable map <string, wstring> Map;
 
 	private:
 		LanguageStrings (const LanguageStrings &);
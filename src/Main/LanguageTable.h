@@ -0,0 +1,49 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Main_LanguageTable
+#define TC_HEADER_Main_LanguageTable
+
+// Layout of the built-in language string table, which is generated from
+// Common/Language.xml at build time by Build/Tools/MakeLanguageTable.
+// This header is shared with the generator and must not depend on the rest of the source tree.
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace VeraCrypt
+{
+	struct LanguageTableEntry
+	{
+		uint32_t KeyOffset;		// Offset in LanguageTableKeys
+		uint32_t KeyLength;
+		uint32_t TextOffset;	// Offset in LanguageTableText (UTF-8); identical strings share storage
+		uint32_t TextLength;
+	};
+
+	// Keys are placed by a two-level perfect hash: the key selects a bucket using seed 0, and
+	// the seed stored for the bucket selects the entry. A lookup therefore needs a single key comparison.
+	inline uint32_t LanguageTableHash (const char *key, size_t length, uint32_t seed)
+	{
+		uint32_t h = 2166136261U ^ seed;
+		for (size_t i = 0; i < length; ++i)
+		{
+			h ^= (unsigned char) key[i];
+			h *= 16777619U;
+		}
+
+		h ^= h >> 16;
+		h *= 0x85ebca6bU;
+		h ^= h >> 13;
+		h *= 0xc2b2ae35U;
+		h ^= h >> 16;
+		return h;
+	}
+}
+
+#endif // TC_HEADER_Main_LanguageTable
@@ -46,7 +46,7 @@ namespace VeraCrypt
 #endif // TC_WINDOWS
 
 
-	string Resources::GetLanguageXml ()
+	string Resources::GetTranslationXml ()
 	{
 #ifdef TC_WINDOWS
 		ConstBufferPtr res = GetWindowsResource (L"XML", L"IDR_LANGUAGE");
@@ -62,10 +62,10 @@ namespace VeraCrypt
 		string defaultLang("en");
 		string filenamePrefix("/usr/share/veracrypt/languages/Language.");
 		string filenamePost(".xml");
-		string filename = filenamePrefix + defaultLang + filenamePost;
+		string defaultFilename = filenamePrefix + defaultLang + filenamePost;
+		string filename = defaultFilename;
 		if(const char* env_p = getenv("LANG")){
 		    string lang(env_p);
-			std::cout << lang << std::endl;
 			if ( lang.size() > 1 ){
 				int found = lang.find(".");
 				if ( found > 1 ){
@@ -109,6 +109,10 @@ namespace VeraCrypt
 				}
 			}
 		}
+		// English strings are built in
+		if (filename == defaultFilename)
+			return string();
+
 		FilesystemPath xml(filename);
 		if ( xml.IsFile() ){
 			File file;
@@ -120,21 +124,10 @@ namespace VeraCrypt
 			string langxml(keyfileData.begin(), keyfileData.end());
 			return langxml;
 		}
-		static byte LanguageXml[] =
-		{
-#			include "Common/Language.xml.h"
-			, 0
-		};
 
-		return string ((const char*) LanguageXml);
+		return string();
 #else
-		static byte LanguageXml[] =
-		{
-#			include "Common/Language.xml.h"
-			, 0
-		};
-
-		return string ((const char*) LanguageXml);
+		return string();
 #endif
 	}
 
@@ -21,8 +21,8 @@ namespace VeraCrypt
 	class Resources
 	{
 	public:
-		static string GetLanguageXml ();
 		static string GetLegalNotices ();
+		static string GetTranslationXml ();	// Returns an empty string if the default language is selected
 #ifndef TC_NO_GUI
 		static wxBitmap GetDriveIconBitmap ();
 		static wxBitmap GetDriveIconMaskBitmap ();
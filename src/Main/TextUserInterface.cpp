@@ -426,10 +426,127 @@ namespace VeraCrypt
 		ShowInfo ("VOL_HEADER_BACKED_UP");
 	}
 
+	void TextUserInterface::Benchmark (const CryptoBenchmarkOptions &options, bool jsonOutput, BenchmarkBaseline &results) const
+	{
+		struct ResultListener : public CryptoBenchmarkListener
+		{
+			ResultListener (const TextUserInterface *userInterface, bool jsonOutput, BenchmarkBaseline &results) : JsonOutput (jsonOutput), Results (results), UI (userInterface) { }
+
+			virtual void operator() (const CryptoBenchmarkResult &result)
+			{
+				Results.Add (result);
+
+				if (JsonOutput)
+				{
+					UI->ShowString (wxString::FromUTF8 (result.ToJson().ToString().c_str()) + L"\n");
+					return;
+				}
+
+				if (result.Category != LastCategory)
+				{
+					if (result.Category == "encryption")
+						UI->ShowString (L"\nEncryption (bytes per second):\n");
+					else if (result.Category == "hash")
+						UI->ShowString (L"\nHash (bytes per second):\n");
+					else
+						UI->ShowString (L"\nKey derivation (time per derivation):\n");
+
+					LastCategory = result.Category;
+				}
+
+				const BenchmarkStatistics &stats = result.Statistics;
+				wxString line = wxString::Format (L" %-30ls ", result.Algorithm.c_str());
+
+				if (result.Category == "kdf")
+				{
+					line += wxString::Format (L"PIM %-5d %10d iterations  mean %8.3f s  median %8.3f s  min %8.3f s  max %8.3f s",
+						result.Pim, result.Iterations, stats.Mean, stats.Median, stats.Min, stats.Max);
+				}
+				else
+				{
+					line += wxString::Format (L"%-7s %9ls  %2u thread(s)  mean %12ls  median %12ls  min %12ls  max %12ls",
+						wxString::FromUTF8 (result.Operation.c_str()).c_str(),
+						UI->SizeToString (result.BufferSize).c_str(),
+						(unsigned int) result.ThreadCount,
+						UI->SpeedToString ((uint64) stats.Mean).c_str(),
+						UI->SpeedToString ((uint64) stats.Median).c_str(),
+						UI->SpeedToString ((uint64) stats.Min).c_str(),
+						UI->SpeedToString ((uint64) stats.Max).c_str());
+				}
+
+				line += wxString::Format (L"  rsd %5.1f%%", stats.GetRelativeStdDev() * 100);
+
+				if (result.Deprecated)
+					line += L"  (deprecated)";
+
+				UI->ShowString (line + L"\n");
+			}
+
+			bool JsonOutput;
+			string LastCategory;
+			BenchmarkBaseline &Results;
+			const TextUserInterface *UI;
+		};
+
+		if (!jsonOutput)
+			ShowString (wxString::Format (L"Running benchmarks (%u repetitions per measurement)...\n", (unsigned int) options.Repetitions));
+
+		ResultListener listener (this, jsonOutput, results);
+		CryptoBenchmark::Run (options, &listener);
+
+		if (!jsonOutput)
+			ShowString (L"\n");
+	}
+
+	void TextUserInterface::BenchmarkVolume (const VolumeBenchmarkOptions &options, bool jsonOutput, BenchmarkBaseline &results) const
+	{
+		struct ResultListener : public VolumeBenchmarkListener
+		{
+			ResultListener (const TextUserInterface *userInterface, bool jsonOutput, BenchmarkBaseline &results) : JsonOutput (jsonOutput), Results (results), UI (userInterface) { }
+
+			virtual void operator() (const VolumeBenchmarkResult &result)
+			{
+				Results.Add (result);
+
+				if (JsonOutput)
+				{
+					UI->ShowString (wxString::FromUTF8 (result.ToJson().ToString().c_str()) + L"\n");
+					return;
+				}
+
+				UI->ShowString (wxString::Format (L" %-22ls %10.0f IOPS  %12ls  latency (us): mean %9.1f  p50 %9.1f  p90 %9.1f  p99 %9.1f  p99.9 %9.1f  max %9.1f\n",
+					wxString::FromUTF8 (result.Workload.GetName().c_str()).c_str(),
+					result.GetIops(),
+					UI->SpeedToString ((uint64) result.GetThroughput()).c_str(),
+					result.LatencyMean, result.LatencyP50, result.LatencyP90, result.LatencyP99, result.LatencyP999, result.LatencyMax));
+			}
+
+			bool JsonOutput;
+			BenchmarkBaseline &Results;
+			const TextUserInterface *UI;
+		};
+
+		if (!jsonOutput)
+		{
+			ShowString (wxString::Format (L"Creating %ls benchmark container...\n", SizeToString (options.ContainerSize).c_str()));
+			ShowString (L"\nVolume I/O:\n");
+		}
+
+		ResultListener listener (this, jsonOutput, results);
+		VolumeBenchmark benchmark (options);
+		benchmark.Run (&listener);
+
+		if (!jsonOutput)
+			ShowString (L"\n");
+	}
+
 	void TextUserInterface::ChangePassword (shared_ptr <VolumePath> volumePath, shared_ptr <VolumePassword> password, int pim, shared_ptr <Hash> currentHash, bool truecryptMode, shared_ptr <KeyfileList> keyfiles, shared_ptr <VolumePassword> newPassword, int newPim, shared_ptr <KeyfileList> newKeyfiles, shared_ptr <Hash> newHash) const
 	{
 		shared_ptr <Volume> volume;
 
+		// Entropy is gathered in the background while the user is prompted
+		RandomNumberGenerator::Start();
+
 		// Volume path
 		if (!volumePath.get())
 		{
@@ -529,6 +646,182 @@ namespace VeraCrypt
 		ShowInfo ("PASSWORD_CHANGED");
 	}
 
+	void TextUserInterface::CloneVolume (shared_ptr <VolumePath> volumePath, shared_ptr <VolumePassword> password, int pim, shared_ptr <Hash> currentHash, shared_ptr <KeyfileList> keyfiles, shared_ptr <VolumeCloneOptions> options) const
+	{
+		shared_ptr <Volume> volume;
+
+		// Volume path
+		if (!volumePath.get())
+		{
+			if (Preferences.NonInteractive)
+				throw MissingArgument (SRC_POS);
+
+			volumePath = AskVolumePath ();
+		}
+
+		if (volumePath->IsEmpty())
+			throw UserAbort (SRC_POS);
+
+		bool passwordInteractive = !password.get();
+		bool keyfilesInteractive = !keyfiles.get();
+
+		shared_ptr<Pkcs5Kdf> kdf;
+		if (currentHash)
+			kdf = Pkcs5Kdf::GetAlgorithm (*currentHash, false);
+
+		while (true)
+		{
+			// Current password
+			if (passwordInteractive && !Preferences.NonInteractive)
+				password = AskPassword ();
+
+			// Current PIM
+			if (!Preferences.NonInteractive && (pim < 0))
+				pim = AskPim (_("Enter current PIM"));
+
+			// Current keyfiles
+			try
+			{
+				if (keyfilesInteractive)
+				{
+					// Ask for keyfiles only if required
+					try
+					{
+						keyfiles.reset (new KeyfileList);
+						volume = Core->OpenVolume (volumePath, Preferences.DefaultMountOptions.PreserveTimestamps, password, pim, kdf, false, keyfiles, VolumeProtection::ReadOnly);
+					}
+					catch (PasswordException&)
+					{
+						if (!Preferences.NonInteractive)
+							keyfiles = AskKeyfiles ();
+					}
+				}
+
+				if (!volume.get())
+					volume = Core->OpenVolume (volumePath, Preferences.DefaultMountOptions.PreserveTimestamps, password, pim, kdf, false, keyfiles, VolumeProtection::ReadOnly);
+			}
+			catch (PasswordException &e)
+			{
+				if (Preferences.NonInteractive || !passwordInteractive || !keyfilesInteractive)
+					throw;
+
+				ShowInfo (e);
+				continue;
+			}
+
+			break;
+		}
+
+		// Target path
+		if (options->Path.IsEmpty())
+		{
+			if (Preferences.NonInteractive)
+				throw MissingArgument (SRC_POS);
+
+			do
+			{
+				ShowString (L"\n");
+				options->Path = VolumePath (*AskVolumePath (_("Enter target volume path")));
+			} while (options->Path.IsEmpty());
+		}
+
+		if (VolumeCloner::IsSameVolume (*volumePath, options->Path))
+			throw_err (_("The target volume must be different from the source volume."));
+
+		if (options->Path.IsDevice())
+			options->CheckpointPath = Application::GetConfigFilePath (wxString (L"Clone ") + wstring (FilesystemPath (wstring (options->Path)).ToBaseName()) + L".checkpoint", true);
+		else
+			options->CheckpointPath = wstring (options->Path) + L".checkpoint";
+
+		// An interrupted clone leaves a checkpoint behind which allows it to be resumed
+		options->Resume = options->CheckpointPath.IsFile();
+
+		if (options->Resume)
+		{
+			ShowInfo (StringFormatter (_("Resuming interrupted clone to {0}."), wstring (options->Path)));
+		}
+		else if (FilesystemPath (wstring (options->Path)).IsFile())
+		{
+			if (Preferences.NonInteractive || !AskYesNo (StringFormatter (_("File {0} already exists. Overwrite?"), wstring (options->Path)), false, true))
+				throw UserAbort (SRC_POS);
+		}
+
+		// New password, PIM and keyfiles default to the current ones
+		if (!options->Password)
+		{
+			if (Preferences.NonInteractive || AskYesNo (_("Keep current password?"), true))
+				options->Password = password;
+			else
+				options->Password = AskPassword (_("Enter new password"), true);
+		}
+
+		if (options->Pim < 0)
+		{
+			if (Preferences.NonInteractive || AskYesNo (_("Keep current PIM?"), true))
+				options->Pim = pim > 0 ? pim : 0;
+			else
+				options->Pim = AskPim (_("Enter new PIM"));
+		}
+
+		if (!options->Keyfiles)
+		{
+			if (Preferences.NonInteractive || !keyfiles || keyfiles->empty() || AskYesNo (_("Keep current keyfiles?"), true))
+				options->Keyfiles = keyfiles;
+			else
+				options->Keyfiles = AskKeyfiles (_("Enter new keyfile"));
+		}
+
+		if ((!options->Keyfiles || options->Keyfiles->empty())
+			&& (!options->Password || options->Password->IsEmpty()))
+		{
+			throw_err (_("Password cannot be empty when no keyfile is specified"));
+		}
+
+		// Random data
+		RandomNumberGenerator::Start();
+		if (!options->Resume)
+		{
+			/* force the display of the random enriching interface */
+			RandomNumberGenerator::SetEnrichedByUserStatus (false);
+			UserEnrichRandomPool();
+		}
+
+		ShowString (L"\n");
+		wxLongLong startTime = wxGetLocalTimeMillis();
+
+		VolumeCloner cloner;
+		cloner.CloneVolume (volume, options);
+
+		VolumeCloner::ProgressInfo progress = cloner.GetProgressInfo();
+		uint64 startSize = progress.SizeDone;
+
+		bool volumeCloned = false;
+		while (!volumeCloned)
+		{
+			progress = cloner.GetProgressInfo();
+
+			wxLongLong timeDiff = wxGetLocalTimeMillis() - startTime;
+			if (timeDiff.GetValue() > 0)
+			{
+				uint64 speed = (progress.SizeDone - startSize) * 1000 / timeDiff.GetValue();
+
+				volumeCloned = !progress.CloneInProgress;
+
+				ShowString (wxString::Format (L"\rDone: %7.3f%%  Speed: %9s  Left: %s         ",
+					100.0 - double (progress.TotalSize - progress.SizeDone) / (double (progress.TotalSize) / 100.0),
+					speed > 0 ? (const wchar_t*) SpeedToString (speed).c_str() : L" ",
+					speed > 0 ? (const wchar_t*) TimeSpanToString ((progress.TotalSize - progress.SizeDone) / speed).c_str() : L""));
+			}
+
+			Thread::Sleep (100);
+		}
+
+		ShowString (L"\n\n");
+		cloner.CheckResult();
+
+		ShowInfo (_("The volume has been cloned."));
+	}
+
 	void TextUserInterface::CreateKeyfile (shared_ptr <FilePath> keyfilePath) const
 	{
 		FilePath path;
@@ -556,6 +849,9 @@ namespace VeraCrypt
 
 	void TextUserInterface::CreateVolume (shared_ptr <VolumeCreationOptions> options) const
 	{
+		// Entropy is gathered in the background while the user is prompted
+		RandomNumberGenerator::Start();
+
 		// Volume type
 		if (options->Type == VolumeType::Unknown)
 		{
@@ -1486,20 +1782,7 @@ namespace VeraCrypt
 			RandomNumberGenerator::Start();
 			UserEnrichRandomPool();
 
-			// Re-encrypt volume header
-			SecureBuffer newHeaderBuffer (volume->GetLayout()->GetHeaderSize());
-			Core->ReEncryptVolumeHeaderWithNewSalt (newHeaderBuffer, volume->GetHeader(), options.Password, options.Pim,  options.Keyfiles);
-
-			// Write volume header
-			int headerOffset = volume->GetLayout()->GetHeaderOffset();
-			shared_ptr <File> volumeFile = volume->GetFile();
-
-			if (headerOffset >= 0)
-				volumeFile->SeekAt (headerOffset);
-			else
-				volumeFile->SeekEnd (headerOffset);
-
-			volumeFile->Write (newHeaderBuffer);
+			RestoreVolumeHeaderFromBackup (volume, options.Password, options.Pim, options.Keyfiles);
 		}
 		else
 		{
@@ -1519,22 +1802,7 @@ namespace VeraCrypt
 			File backupFile;
 			backupFile.Open (filePath, File::OpenRead);
 
-			bool legacyBackup;
-
-			// Determine the format of the backup file
-			switch (backupFile.Length())
-			{
-			case TC_VOLUME_HEADER_GROUP_SIZE:
-				legacyBackup = false;
-				break;
-
-			case TC_VOLUME_HEADER_SIZE_LEGACY * 2:
-				legacyBackup = true;
-				break;
-
-			default:
-				throw_err (LangString ["HEADER_BACKUP_SIZE_INCORRECT"]);
-			}
+			bool legacyBackup = IsLegacyHeaderBackup (backupFile);
 
 			// Open the volume header stored in the backup file
 			MountOptions options;
@@ -1549,29 +1817,7 @@ namespace VeraCrypt
 
 				try
 				{
-					// Test volume layouts
-					foreach (shared_ptr <VolumeLayout> layout, VolumeLayout::GetAvailableLayouts ())
-					{
-						if (layout->HasDriveHeader())
-							continue;
-
-						if (!legacyBackup && (typeid (*layout) == typeid (VolumeLayoutV1Normal)))
-							continue;
-
-						if (legacyBackup && (typeid (*layout) == typeid (VolumeLayoutV2Normal) || typeid (*layout) == typeid (VolumeLayoutV2Hidden)))
-							continue;
-
-						SecureBuffer headerBuffer (layout->GetHeaderSize());
-						backupFile.ReadAt (headerBuffer, layout->GetType() == VolumeType::Hidden ? layout->GetHeaderSize() : 0);
-
-						// Decrypt header
-						shared_ptr <VolumePassword> passwordKey = Keyfile::ApplyListToPassword (options.Keyfiles, options.Password);
-						if (layout->GetHeader()->Decrypt (headerBuffer, *passwordKey, options.Pim, kdf, false, layout->GetSupportedKeyDerivationFunctions(false), layout->GetSupportedEncryptionAlgorithms(), layout->GetSupportedEncryptionModes()))
-						{
-							decryptedLayout = layout;
-							break;
-						}
-					}
+					decryptedLayout = DecryptHeaderBackup (backupFile, legacyBackup, options.Password, options.Pim, kdf, options.Keyfiles);
 
 					if (!decryptedLayout)
 						throw PasswordIncorrect (SRC_POS);
@@ -1582,39 +1828,10 @@ namespace VeraCrypt
 				}
 			}
 
-			File volumeFile;
-			volumeFile.Open (*volumePath, File::OpenReadWrite, File::ShareNone, File::PreserveTimestamps);
-
 			RandomNumberGenerator::Start();
 			UserEnrichRandomPool();
 
-			// Re-encrypt volume header
-			SecureBuffer newHeaderBuffer (decryptedLayout->GetHeaderSize());
-			Core->ReEncryptVolumeHeaderWithNewSalt (newHeaderBuffer, decryptedLayout->GetHeader(), options.Password, options.Pim, options.Keyfiles);
-
-			// Write volume header
-			int headerOffset = decryptedLayout->GetHeaderOffset();
-			if (headerOffset >= 0)
-				volumeFile.SeekAt (headerOffset);
-			else
-				volumeFile.SeekEnd (headerOffset);
-
-			volumeFile.Write (newHeaderBuffer);
-
-			if (decryptedLayout->HasBackupHeader())
-			{
-				// Re-encrypt backup volume header
-				Core->ReEncryptVolumeHeaderWithNewSalt (newHeaderBuffer, decryptedLayout->GetHeader(), options.Password, options.Pim, options.Keyfiles);
-
-				// Write backup volume header
-				headerOffset = decryptedLayout->GetBackupHeaderOffset();
-				if (headerOffset >= 0)
-					volumeFile.SeekAt (headerOffset);
-				else
-					volumeFile.SeekEnd (headerOffset);
-
-				volumeFile.Write (newHeaderBuffer);
-			}
+			RestoreVolumeHeadersFromBackup (*volumePath, decryptedLayout, options.Password, options.Pim, options.Keyfiles);
 		}
 
 		ShowString (L"\n");
@@ -11,13 +11,17 @@
 */
 
 #include "System.h"
+#include <iomanip>
 #include <sys/mman.h>
 
 #include "Platform/Platform.h"
+#include "Platform/StartupProfiler.h"
 #include "Platform/SystemLog.h"
+#include "Core/RandomNumberGenerator.h"
 #include "Volume/EncryptionThreadPool.h"
 #include "Core/Unix/CoreService.h"
 #include "Main/Application.h"
+#include "Main/CalibrationStore.h"
 #include "Main/Main.h"
 #include "Main/UserInterface.h"
 
@@ -29,6 +33,12 @@ using namespace VeraCrypt;
 
 int main (int argc, char **argv)
 {
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp (argv[i], "--profile-startup") == 0)
+			StartupProfiler::Enable();
+	}
+
 	try
 	{
 		// Make sure all required commands can be executed via default search path
@@ -64,11 +74,15 @@ int main (int argc, char **argv)
 		// Start core service
 		CoreService::Start();
 		finally_do ({ CoreService::Stop(); });
+		StartupProfiler::Mark ("core service");
 
-		// Start encryption thread pool
-		EncryptionThreadPool::Start();
+		// Encryption thread pool is started when first needed
+		EncryptionThreadPool::StartOnDemand();
 		finally_do ({ EncryptionThreadPool::Stop(); });
 
+		// A calibration running in the background uses the encryption thread pool
+		finally_do ({ CalibrationStore::WaitForCalibration(); });
+
 #ifdef TC_NO_GUI
 		bool forceTextUI = true;
 #else
@@ -101,11 +115,14 @@ int main (int argc, char **argv)
 			Application::Initialize (UserInterfaceType::Graphic);
 		}
 
+		StartupProfiler::Mark ("application");
 		Application::SetExitCode (1);
 
 		// Start application
 		if (::wxEntry (argc, argv) == 0)
 			Application::SetExitCode (0);
+
+		StartupProfiler::Mark ("exit");
 	}
 	catch (ErrorMessage &e)
 	{
@@ -127,5 +144,22 @@ int main (int argc, char **argv)
 		cerr << s.str() << endl;
 	}
 
+	if (StartupProfiler::IsEnabled())
+	{
+		cerr << StartupProfiler::GetReport();
+
+		EntropyGatheringStatistics entropy = RandomNumberGenerator::GetEntropyGatheringStatistics();
+		if (entropy.RoundCount > 0)
+		{
+			cerr << fixed << setprecision (2)
+				<< "entropy gathering: " << entropy.RoundCount << " rounds, " << entropy.GatheredBytes << " bytes" << endl
+				<< setw (13) << (double) entropy.JitterInitTime / 1000000.0 << " ms  jitter collector initialization" << endl
+				<< setw (13) << (double) entropy.DevRandomTime / 1000000.0 << " ms  /dev/random" << endl
+				<< setw (13) << (double) entropy.JitterTime / 1000000.0 << " ms  jitter collector" << endl
+				<< setw (13) << (double) entropy.MinimumEntropyTime / 1000000.0 << " ms  until minimum entropy" << endl
+				<< setw (13) << (double) entropy.WaitTime / 1000000.0 << " ms  blocked waiting for entropy" << endl;
+		}
+	}
+
 	return Application::GetExitCode();
 }
@@ -16,7 +16,9 @@
 #include <wx/apptrait.h>
 #include <wx/cmdline.h>
 #include "Crypto/cpu.h"
+#include "Platform/JsonObject.h"
 #include "Platform/PlatformTest.h"
+#include "Platform/StartupProfiler.h"
 #ifdef TC_UNIX
 #include <errno.h>
 #include "Platform/Unix/Process.h"
@@ -24,10 +26,13 @@
 #include "Platform/SystemInfo.h"
 #include "Platform/SystemException.h"
 #include "Common/SecurityToken.h"
+#include "Volume/CryptoDifferentialTest.h"
 #include "Volume/EncryptionTest.h"
 #include "Application.h"
+#include "CalibrationStore.h"
 #include "FavoriteVolume.h"
 #include "UserInterface.h"
+#include "VolumeManifest.h"
 #include "Common/Hexdump.h"
 
 namespace VeraCrypt
@@ -49,6 +54,106 @@ namespace VeraCrypt
 		catch (...) { }
 	}
 
+	void UserInterface::BackupVolumeHeadersBatch (const FilePath &manifestPath) const
+	{
+		struct BackupFunctor : public VolumeManifestFunctor
+		{
+			virtual void operator() (const VolumeManifestEntry &entry)
+			{
+				if (entry.BackupFile.IsEmpty())
+					throw MissingArgument (SRC_POS);
+
+				shared_ptr <Pkcs5Kdf> kdf;
+				if (entry.KdfHash)
+					kdf = Pkcs5Kdf::GetAlgorithm (*entry.KdfHash, false);
+
+				shared_ptr <VolumePath> volumePath = make_shared <VolumePath> (entry.Path);
+
+				shared_ptr <VolumePassword> password = entry.GetPassword();
+				shared_ptr <Volume> normalVolume = OpenVolume (volumePath, password, entry.Pim, kdf, entry.Keyfiles, VolumeType::Normal);
+
+				shared_ptr <VolumePassword> hiddenPassword;
+				shared_ptr <Volume> hiddenVolume;
+
+				if (entry.HasHiddenVolume())
+				{
+					hiddenPassword = entry.GetHiddenPassword();
+					hiddenVolume = OpenVolume (volumePath, hiddenPassword, entry.HiddenPim, kdf, entry.HiddenKeyfiles, VolumeType::Hidden);
+
+					if (typeid (*normalVolume->GetLayout()) == typeid (VolumeLayoutV1Normal))
+						throw ParameterIncorrect (SRC_POS);
+
+					if (typeid (*normalVolume->GetLayout()) == typeid (VolumeLayoutV2Normal) && typeid (*hiddenVolume->GetLayout()) != typeid (VolumeLayoutV2Hidden))
+						throw ParameterIncorrect (SRC_POS);
+				}
+
+				size_t headerSize = normalVolume->GetLayout()->GetHeaderSize();
+				SecureBuffer backupData (headerSize * 2);
+
+				// Re-encrypt volume header
+				Core->ReEncryptVolumeHeaderWithNewSalt (backupData.GetRange (0, headerSize), normalVolume->GetHeader(), password, entry.Pim, entry.Keyfiles);
+
+				if (hiddenVolume)
+				{
+					// Re-encrypt hidden volume header
+					Core->ReEncryptVolumeHeaderWithNewSalt (backupData.GetRange (headerSize, headerSize), hiddenVolume->GetHeader(), hiddenPassword, entry.HiddenPim, entry.HiddenKeyfiles);
+				}
+				else
+				{
+					// Store random data in place of hidden volume header
+					shared_ptr <EncryptionAlgorithm> ea = normalVolume->GetEncryptionAlgorithm();
+					Core->RandomizeEncryptionAlgorithmKey (ea);
+					ea->Encrypt (backupData.GetRange (headerSize, headerSize));
+				}
+
+				// Write the backup to a new temporary file in the target directory first so that an existing
+				// backup is never left incomplete. The file is created exclusively and not accessible to others.
+				string tempPathName = StringConverter::ToSingle (wstring (entry.BackupFile)) + ".XXXXXX";
+				int tempFd = mkstemp (&tempPathName[0]);
+				throw_sys_sub_if (tempFd == -1, wstring (entry.BackupFile));
+
+				FilePath tempPath (StringConverter::ToWide (tempPathName));
+				try
+				{
+					File backupFile;
+					backupFile.AssignSystemHandle (tempFd, false);
+					backupFile.Write (backupData);
+					backupFile.Flush();
+					backupFile.Close();
+
+					tempPath.Rename (entry.BackupFile);
+				}
+				catch (...)
+				{
+					try { tempPath.Delete(); } catch (...) { }
+					throw;
+				}
+			}
+
+			static shared_ptr <Volume> OpenVolume (shared_ptr <VolumePath> volumePath, shared_ptr <VolumePassword> password, int pim, shared_ptr <Pkcs5Kdf> kdf, shared_ptr <KeyfileList> keyfiles, VolumeType::Enum volumeType)
+			{
+				try
+				{
+					return Core->OpenVolume (volumePath, true, password, pim, kdf, false, keyfiles, VolumeProtection::ReadOnly,
+						shared_ptr <VolumePassword> (), 0, shared_ptr <Pkcs5Kdf> (), shared_ptr <KeyfileList> (), true, volumeType, false);
+				}
+				catch (PasswordException&)
+				{
+					// Fall back on the backup header in case the primary header is damaged
+					return Core->OpenVolume (volumePath, true, password, pim, kdf, false, keyfiles, VolumeProtection::ReadOnly,
+						shared_ptr <VolumePassword> (), 0, shared_ptr <Pkcs5Kdf> (), shared_ptr <KeyfileList> (), true, volumeType, true);
+				}
+			}
+		};
+
+		VolumeManifestEntryList entries = VolumeManifestEntry::LoadList (manifestPath);
+
+		RandomNumberGenerator::Start();
+
+		BackupFunctor functor;
+		ShowVolumeManifestResults ("backup-headers", VolumeManifestResult::ProcessList ("backup-headers", entries, wxThread::GetCPUCount(), functor));
+	}
+
 	void UserInterface::CheckRequirementsForMountingVolume () const
 	{
 #ifdef TC_LINUX
@@ -122,6 +227,146 @@ namespace VeraCrypt
 #endif
 	}
 
+	void UserInterface::CreateVolumesBatch (const FilePath &manifestPath, shared_ptr <VolumeCreationOptions> defaults, bool overwrite) const
+	{
+		struct CreateFunctor : public VolumeManifestFunctor
+		{
+			CreateFunctor (shared_ptr <VolumeCreationOptions> defaults, bool overwrite) : Defaults (defaults), Overwrite (overwrite) { }
+
+			virtual void operator() (const VolumeManifestEntry &entry)
+			{
+				make_shared_auto (VolumeCreationOptions, options);
+
+				options->Path = entry.Path;
+				options->Type = VolumeType::Normal;
+				options->Password = entry.GetPassword();
+				options->Pim = entry.Pim;
+				options->Keyfiles = entry.Keyfiles;
+
+				// Each creator sets the key of its own algorithm instance
+				if (entry.EA)
+					options->EA = entry.EA->GetNew();
+				else if (Defaults->EA)
+					options->EA = Defaults->EA->GetNew();
+
+				options->Filesystem = entry.Filesystem != VolumeCreationOptions::FilesystemType::Unknown ? entry.Filesystem : Defaults->Filesystem;
+				options->FilesystemClusterSize = 0;
+				options->IoLimiter = Defaults->IoLimiter;
+				options->Quick = entry.Quick || Defaults->Quick;
+				options->Size = entry.Size != 0 ? entry.Size : Defaults->Size;
+
+				if (entry.KdfHash)
+					options->VolumeHeaderKdf = Pkcs5Kdf::GetAlgorithm (*entry.KdfHash, false);
+				else if (Defaults->VolumeHeaderKdf)
+					options->VolumeHeaderKdf.reset (Defaults->VolumeHeaderKdf->Clone());
+				else
+				{
+					// The PRF selected by default when volumes are created interactively
+					foreach (shared_ptr <Hash> hash, Hash::GetAvailableAlgorithms())
+					{
+						if (!hash->IsDeprecated())
+						{
+							options->VolumeHeaderKdf = Pkcs5Kdf::GetAlgorithm (*hash, false);
+							break;
+						}
+					}
+				}
+
+				if (!options->EA || !options->VolumeHeaderKdf)
+					throw MissingArgument (SRC_POS);
+
+				// Only filesystems which can be created without mounting the volume are supported
+				if (options->Filesystem == VolumeCreationOptions::FilesystemType::Unknown)
+					options->Filesystem = VolumeCreationOptions::FilesystemType::None;
+				else if (options->Filesystem != VolumeCreationOptions::FilesystemType::None && options->Filesystem != VolumeCreationOptions::FilesystemType::FAT)
+					throw ParameterIncorrect (SRC_POS);
+
+				if ((!options->Keyfiles || options->Keyfiles->empty()) && options->Password->IsEmpty())
+					throw_err (_("Password cannot be empty when no keyfile is specified"));
+
+				if (options->Path.IsDevice())
+				{
+					if (entry.Size != 0)
+						throw_err (_("Volume size cannot be changed for device-hosted volumes."));
+
+					options->SectorSize = Core->GetDeviceSectorSize (options->Path);
+					options->Size = Core->GetDeviceSize (options->Path);
+				}
+				else
+				{
+					if (!Overwrite && FilesystemPath (wstring (options->Path)).IsFile())
+						throw_err (StringFormatter (_("File {0} already exists."), wstring (options->Path)));
+
+					options->SectorSize = TC_SECTOR_SIZE_FILE_HOSTED_VOLUME;
+					options->Quick = false;
+
+					uint32 sectorSizeRem = options->Size % options->SectorSize;
+					if (sectorSizeRem != 0)
+						options->Size += options->SectorSize - sectorSizeRem;
+				}
+
+				if (options->Size < TC_MIN_VOLUME_SIZE || options->Size > TC_MAX_VOLUME_SIZE_GENERAL)
+					throw_err (_("Incorrect volume size"));
+
+				uint64 filesystemSize = VolumeLayoutV2Normal().GetMaxDataSize (options->Size);
+				if (options->Filesystem == VolumeCreationOptions::FilesystemType::FAT
+					&& (filesystemSize < TC_MIN_FAT_FS_SIZE || filesystemSize > TC_MAX_FAT_SECTOR_COUNT * options->SectorSize))
+				{
+					throw_err (_("Specified volume size cannot be used with FAT filesystem."));
+				}
+
+				// The algorithms were tested once for the whole batch
+				VolumeCreator creator;
+				creator.CreateVolume (options, false);
+
+				while (creator.GetProgressInfo().CreationInProgress)
+					Thread::Sleep (100);
+
+				creator.CheckResult();
+			}
+
+			shared_ptr <VolumeCreationOptions> Defaults;
+			bool Overwrite;
+		};
+
+		VolumeManifestEntryList entries = VolumeManifestEntry::LoadList (manifestPath);
+		EncryptionTest::TestAll();
+
+		// All volumes draw their keys and salts from the same random pool, and their data
+		// area is encrypted by the shared encryption thread pool
+		RandomNumberGenerator::Start();
+
+		CreateFunctor functor (defaults, overwrite);
+		ShowVolumeManifestResults ("create", VolumeManifestResult::ProcessList ("create", entries, wxThread::GetCPUCount(), functor));
+	}
+
+	shared_ptr <VolumeLayout> UserInterface::DecryptHeaderBackup (File &backupFile, bool legacyBackup, shared_ptr <VolumePassword> password, int pim, shared_ptr <Pkcs5Kdf> kdf, shared_ptr <KeyfileList> keyfiles)
+	{
+		shared_ptr <VolumePassword> passwordKey = Keyfile::ApplyListToPassword (keyfiles, password);
+
+		// Test volume layouts
+		foreach (shared_ptr <VolumeLayout> layout, VolumeLayout::GetAvailableLayouts ())
+		{
+			if (layout->HasDriveHeader())
+				continue;
+
+			if (!legacyBackup && (typeid (*layout) == typeid (VolumeLayoutV1Normal)))
+				continue;
+
+			if (legacyBackup && (typeid (*layout) == typeid (VolumeLayoutV2Normal) || typeid (*layout) == typeid (VolumeLayoutV2Hidden)))
+				continue;
+
+			SecureBuffer headerBuffer (layout->GetHeaderSize());
+			backupFile.ReadAt (headerBuffer, layout->GetType() == VolumeType::Hidden ? layout->GetHeaderSize() : 0);
+
+			// Decrypt header
+			if (layout->GetHeader()->Decrypt (headerBuffer, *passwordKey, pim, kdf, false, layout->GetSupportedKeyDerivationFunctions(false), layout->GetSupportedEncryptionAlgorithms(), layout->GetSupportedEncryptionModes()))
+				return layout;
+		}
+
+		return shared_ptr <VolumeLayout> ();
+	}
+
 	void UserInterface::DismountAllVolumes (bool ignoreOpenFiles, bool interactive) const
 	{
 		try
@@ -292,6 +537,8 @@ namespace VeraCrypt
 #endif
 			prop << LangString["TOTAL_DATA_READ"] << L": " << SizeToString (volume.TotalDataRead) << L'\n';
 			prop << LangString["TOTAL_DATA_WRITTEN"] << L": " << SizeToString (volume.TotalDataWritten) << L'\n';
+			prop << IoStatisticsToString (LangString["IO_STATISTICS_READ"], volume.Statistics.Read, volume.Statistics.ElapsedTime);
+			prop << IoStatisticsToString (LangString["IO_STATISTICS_WRITE"], volume.Statistics.Write, volume.Statistics.ElapsedTime);
 #ifdef TC_LINUX
 			}
 #endif
@@ -512,11 +759,14 @@ namespace VeraCrypt
 #ifdef CRYPTOPP_CPUID_AVAILABLE
 		DetectX86Features ();
 #endif
-		LangString.Init();
 		Core->Init();
+		StartupProfiler::Mark ("core");
 
 		CmdLine.reset (new CommandLineInterface (argc, argv, InterfaceType));
+		StartupProfiler::Mark ("command line");
+
 		SetPreferences (CmdLine->Preferences);
+		StartupProfiler::Mark ("preferences");
 
 		Core->SetApplicationExecutablePath (Application::GetExecutablePath());
 
@@ -557,6 +807,24 @@ namespace VeraCrypt
 
 				ShowError (e);
 			}
+
+			StartupProfiler::Mark ("security token library");
+		}
+	}
+
+	bool UserInterface::IsLegacyHeaderBackup (const File &backupFile)
+	{
+		// Determine the format of the backup file
+		switch (backupFile.Length())
+		{
+		case TC_VOLUME_HEADER_GROUP_SIZE:
+			return false;
+
+		case TC_VOLUME_HEADER_SIZE_LEGACY * 2:
+			return true;
+
+		default:
+			throw_err (LangString ["HEADER_BACKUP_SIZE_INCORRECT"]);
 		}
 	}
 
@@ -981,6 +1249,8 @@ namespace VeraCrypt
 		case CommandId::AutoMountDevicesFavorites:
 		case CommandId::MountVolume:
 			{
+				CalibrationStore::EnsureCalibrated();
+
 				cmdLine.ArgMountOptions.Path = cmdLine.ArgVolumePath;
 				cmdLine.ArgMountOptions.MountPoint = cmdLine.ArgMountPoint;
 				cmdLine.ArgMountOptions.Password = cmdLine.ArgPassword;
@@ -1067,23 +1337,166 @@ namespace VeraCrypt
 					}
 					ShowInfo (message);
 				}
+
+				foreach_ref (const VolumeInfo &volume, mountedVolumes)
+				{
+					// Volumes mounted by an older version report no statistics
+					if (volume.OpenStatistics.TotalTime == 0)
+						continue;
+
+					if (cmdLine.ArgJsonOutput)
+					{
+						JsonObject json;
+						json.Add ("category", "volume_open");
+						json.Add ("path", wstring (volume.Path));
+						json.Append (volume.OpenStatistics.ToJson());
+						ShowString (wxString::FromUTF8 (json.ToString().c_str()) + L"\n");
+					}
+					else if (Preferences.Verbose)
+					{
+						ShowString (OpenStatisticsToString (volume.OpenStatistics));
+					}
+				}
 			}
 			return true;
 
 		case CommandId::BackupHeaders:
-			BackupVolumeHeaders (cmdLine.ArgVolumePath);
+			if (cmdLine.ArgManifestPath)
+				BackupVolumeHeadersBatch (*cmdLine.ArgManifestPath);
+			else
+				BackupVolumeHeaders (cmdLine.ArgVolumePath);
 			return true;
 
+		case CommandId::Benchmark:
+			{
+				shared_ptr <CryptoBenchmarkOptions> options = cmdLine.ArgBenchmarkOptions;
+
+				options->EncryptionAlgorithmFilter = cmdLine.ArgEncryptionAlgorithm;
+				options->HashFilter = cmdLine.ArgHash;
+
+				if (cmdLine.ArgPim > 0)
+					options->Pims.push_back (cmdLine.ArgPim);
+
+				BenchmarkBaseline results;
+
+				if (options->Encryption || options->Hash || options->Kdf)
+					Benchmark (*options, cmdLine.ArgJsonOutput, results);
+
+				shared_ptr <VolumeBenchmarkOptions> volumeOptions = cmdLine.ArgVolumeBenchmarkOptions;
+				if (volumeOptions)
+				{
+					volumeOptions->EA = cmdLine.ArgEncryptionAlgorithm;
+
+					if (cmdLine.ArgSize != 0)
+						volumeOptions->ContainerSize = cmdLine.ArgSize;
+
+					if (cmdLine.ArgFilePath)
+					{
+						if (FilesystemPath (wstring (*cmdLine.ArgFilePath)).IsFile())
+							throw_err (StringFormatter (_("File {0} already exists."), wstring (*cmdLine.ArgFilePath)));
+
+						volumeOptions->ContainerPath = *cmdLine.ArgFilePath;
+					}
+
+					BenchmarkVolume (*volumeOptions, cmdLine.ArgJsonOutput, results);
+				}
+
+				if (cmdLine.ArgBenchmarkExportPath)
+					results.Export (*cmdLine.ArgBenchmarkExportPath);
+
+				if (cmdLine.ArgBenchmarkSaveBaselinePath)
+					results.Save (*cmdLine.ArgBenchmarkSaveBaselinePath);
+
+				if (cmdLine.ArgBenchmarkBaselinePath)
+				{
+					BenchmarkBaseline baseline;
+					baseline.Load (*cmdLine.ArgBenchmarkBaselinePath);
+
+					if (!cmdLine.ArgJsonOutput)
+					{
+						ShowString (StringFormatter (L"Comparison with baseline {0} (default tolerance {1}%):\n",
+							wstring (*cmdLine.ArgBenchmarkBaselinePath), StringConverter::FromNumber (baseline.GetDefaultTolerance())));
+					}
+
+					if (!ShowBenchmarkComparison (results.Compare (baseline), cmdLine.ArgJsonOutput))
+						throw_err (_("Performance regression detected. Benchmark results are below the baseline."));
+				}
+				return true;
+			}
+
+		case CommandId::Calibrate:
+			{
+				CalibrationOptions options;
+				options.Full = true;
+
+				if (cmdLine.ArgFilePath)
+					options.Devices.push_back (*cmdLine.ArgFilePath);
+
+				if (!cmdLine.ArgJsonOutput)
+					ShowString (_("Calibrating...\n"));
+
+				CalibrationData data = Calibration::Measure (options);
+				Calibration::Apply (data);
+				CalibrationStore::Save (data);
+
+				ShowCalibration (data, cmdLine.ArgJsonOutput);
+				return true;
+			}
+
 		case CommandId::ChangePassword:
 			ChangePassword (cmdLine.ArgVolumePath, cmdLine.ArgPassword, cmdLine.ArgPim, cmdLine.ArgHash, cmdLine.ArgTrueCryptMode, cmdLine.ArgKeyfiles, cmdLine.ArgNewPassword, cmdLine.ArgNewPim, cmdLine.ArgNewKeyfiles, cmdLine.ArgNewHash);
 			return true;
 
+		case CommandId::CloneVolume:
+			{
+				make_shared_auto (VolumeCloneOptions, options);
+
+				if (cmdLine.ArgNewHash)
+				{
+					options->VolumeHeaderKdf = Pkcs5Kdf::GetAlgorithm (*cmdLine.ArgNewHash, false);
+					RandomNumberGenerator::SetHash (cmdLine.ArgNewHash);
+				}
+
+				options->EA = cmdLine.ArgEncryptionAlgorithm;
+				options->Keyfiles = cmdLine.ArgNewKeyfiles;
+				options->Password = cmdLine.ArgNewPassword;
+				options->Path = *cmdLine.ArgCloneTargetPath;
+				options->Pim = cmdLine.ArgNewPim;
+
+				CloneVolume (cmdLine.ArgVolumePath, cmdLine.ArgPassword, cmdLine.ArgPim, cmdLine.ArgHash, cmdLine.ArgKeyfiles, options);
+				return true;
+			}
+
+		case CommandId::CompactContainer:
+			{
+				if (!cmdLine.ArgVolumePath)
+					throw MissingArgument (SRC_POS);
+
+				uint64 releasedSize = Core->CompactVolumeContainer (wstring (*cmdLine.ArgVolumePath));
+				ShowInfo (StringFormatter (_("Container compacted. Disk space released: {0}."), SizeToString (releasedSize)));
+			}
+			return true;
+
+		case CommandId::CopyContainer:
+			if (!cmdLine.ArgVolumePath)
+				throw MissingArgument (SRC_POS);
+
+			{
+				FilesystemPath targetPath (wstring (*cmdLine.ArgCopyTargetPath));
+				if (!cmdLine.ArgForce && (targetPath.IsFile() || targetPath.IsDevice()))
+					throw_err (StringFormatter (_("File {0} already exists."), wstring (targetPath)));
+			}
+
+			Core->CopyVolumeContainer (wstring (*cmdLine.ArgVolumePath), *cmdLine.ArgCopyTargetPath);
+			return true;
+
 		case CommandId::CreateKeyfile:
 			CreateKeyfile (cmdLine.ArgFilePath);
 			return true;
 
 		case CommandId::CreateVolume:
 			{
+				CalibrationStore::EnsureCalibrated();
 				make_shared_auto (VolumeCreationOptions, options);
 
 				if (cmdLine.ArgHash)
@@ -1101,6 +1514,15 @@ namespace VeraCrypt
 				options->Size = cmdLine.ArgSize;
 				options->Type = cmdLine.ArgVolumeType;
 
+				if (cmdLine.ArgManifestPath)
+				{
+					if (cmdLine.ArgIoLimit != 0)
+						options->IoLimiter.reset (new RateLimiter (cmdLine.ArgIoLimit));
+
+					CreateVolumesBatch (*cmdLine.ArgManifestPath, options, cmdLine.ArgForce);
+					return true;
+				}
+
 				if (cmdLine.ArgVolumePath)
 					options->Path = VolumePath (*cmdLine.ArgVolumePath);
 
@@ -1140,13 +1562,39 @@ namespace VeraCrypt
 					"\n"
 					"--backup-headers[=VOLUME_PATH]\n"
 					" Backup volume headers to a file. All required options are requested from the\n"
-					" user.\n"
+					" user. See also option --manifest.\n"
+					"\n"
+					"--benchmark[=CONTAINER_PATH]\n"
+					" Measure the speed of all encryption algorithms (encryption and decryption),\n"
+					" hash algorithms and key derivation functions. Each measurement is repeated\n"
+					" and reported with its mean, median, minimum, maximum and relative standard\n"
+					" deviation. Key derivation is measured with the default PIM and the PIM given\n"
+					" with --pim. Options --encryption and --hash restrict the measured algorithms.\n"
+					" The volume benchmark (--benchmark-type=volume) creates a temporary file\n"
+					" container at CONTAINER_PATH (default: in $TMPDIR) of --size bytes (default:\n"
+					" 256M), runs I/O workloads on it without mounting it and reports IOPS,\n"
+					" throughput and latency percentiles. --encryption selects the algorithm of the\n"
+					" container. An existing file is never overwritten. See also options\n"
+					" --benchmark-baseline, --benchmark-depths, --benchmark-export,\n"
+					" --benchmark-huge-pages, --benchmark-repeat, --benchmark-save-baseline,\n"
+					" --benchmark-sizes, --benchmark-threads, --benchmark-time, --benchmark-type,\n"
+					" --benchmark-workloads and --json.\n"
+					"\n"
+					"--calibrate[=DEVICE_PATH]\n"
+					" Measure the speed of encryption algorithms, key derivation functions and the\n"
+					" encryption thread pool of this computer and store the results in the\n"
+					" configuration directory. The results are used to tune the processing of\n"
+					" volume data and the order in which key derivation functions are tried when\n"
+					" mounting a volume. Until the results are stored, default values are used in\n"
+					" text mode. If DEVICE_PATH is specified, the read latency of the host device\n"
+					" or file is measured as well. See also option --json.\n"
 					"\n"
 					"-c, --create[=VOLUME_PATH]\n"
 					" Create a new volume. Most options are requested from the user if not specified\n"
 					" on command line. See also options --encryption, -k, --filesystem, --hash, -p,\n"
 					" --random-source, --quick, --size, --volume-type. Note that passing some of the\n"
 					" options may affect security of the volume (see option -p for more information).\n"
+					" Several normal volumes can be created at once with option --manifest.\n"
 					"\n"
 					" Inexperienced users should use the graphical user interface to create a hidden\n"
 					" volume. When using the text user interface, the following procedure must be\n"
@@ -1159,6 +1607,30 @@ namespace VeraCrypt
 					"  6) Dismount the outer volume.\n"
 					"  If at any step the hidden volume protection is triggered, start again from 1).\n"
 					"\n"
+					"--clone=TARGET_PATH [VOLUME_PATH]\n"
+					" Copy the data of a volume to a new volume encrypted with a newly generated\n"
+					" master key. The data is decrypted and re-encrypted in a single pass, so the\n"
+					" volume does not need to be mounted. The new volume uses the current password,\n"
+					" PIM and keyfiles unless --new-password, --new-pim or --new-keyfiles are\n"
+					" specified. Options --encryption and --new-hash select a different encryption\n"
+					" algorithm and PKCS-5 PRF for the new volume. Progress is saved in the file\n"
+					" TARGET_PATH.checkpoint (in the configuration directory for devices) and an\n"
+					" interrupted clone is resumed when the command is repeated. Hidden volumes\n"
+					" within the source volume are not preserved.\n"
+					"\n"
+					"--compact-container[=VOLUME_PATH]\n"
+					" Deallocate blocks of a file container which contain only zeroes (e.g. after\n"
+					" the container has been copied by a tool which does not preserve unallocated\n"
+					" space). The content of the volume is not changed. The volume must not be\n"
+					" mounted and the filesystem must support sparse files.\n"
+					"\n"
+					"--copy-container=TARGET_PATH [VOLUME_PATH]\n"
+					" Copy a file container to TARGET_PATH. Unallocated space of the container and\n"
+					" blocks containing only zeroes are not written, so the copy of a container\n"
+					" created with --quick remains sparse. The volume must not be mounted. An\n"
+					" existing TARGET_PATH is overwritten only with --force. When TARGET_PATH is a\n"
+					" device, all blocks are written.\n"
+					"\n"
 					"--create-keyfile[=FILE_PATH]\n"
 					" Create a new keyfile containing pseudo-random data.\n"
 					"\n"
@@ -1197,13 +1669,15 @@ namespace VeraCrypt
 					"\n"
 					"--restore-headers[=VOLUME_PATH]\n"
 					" Restore volume headers from the embedded or an external backup. All required\n"
-					" options are requested from the user.\n"
+					" options are requested from the user. See also option --manifest.\n"
 					"\n"
 					"--save-preferences\n"
 					" Save user preferences.\n"
 					"\n"
 					"--test\n"
 					" Test internal algorithms used in the process of encryption and decryption.\n"
+					" Optimized implementations are also compared with the reference ones on\n"
+					" pseudorandom keys and data.\n"
 					"\n"
 					"--version\n"
 					" Display program version.\n"
@@ -1221,6 +1695,58 @@ namespace VeraCrypt
 					"\n"
 					"Options:\n"
 					"\n"
+					"--benchmark-baseline=FILE\n"
+					" Compare the median of each --benchmark measurement with the baseline saved in\n"
+					" FILE by --benchmark-save-baseline and report the changes. The command fails if\n"
+					" any result is worse than the baseline by more than its tolerance. Results\n"
+					" not present in the baseline and vice versa are reported but do not fail.\n"
+					"\n"
+					"--benchmark-depths=DEPTH1[,DEPTH2,...]\n"
+					" Queue depths of the volume benchmark workloads (default: 1). Each job keeps\n"
+					" DEPTH requests in flight.\n"
+					"\n"
+					"--benchmark-export=FILE\n"
+					" Append the results of --benchmark to FILE as JSON objects, one per line, with\n"
+					" the time, host name and version, for tracking of performance over time.\n"
+					"\n"
+					"--benchmark-huge-pages\n"
+					" Measure encryption and hash algorithms with buffers backed by huge pages, as\n"
+					" used by bulk I/O such as volume cloning, instead of ordinary heap buffers.\n"
+					" Buffers of at least one huge page (usually 2M) use explicit huge pages when\n"
+					" reserved (vm.nr_hugepages) and transparent huge pages otherwise. The results\n"
+					" are saved under separate keys by --benchmark-save-baseline.\n"
+					"\n"
+					"--benchmark-repeat=COUNT\n"
+					" Number of repetitions of each --benchmark measurement (default: 5).\n"
+					"\n"
+					"--benchmark-save-baseline=FILE\n"
+					" Save the results of --benchmark to FILE for use with --benchmark-baseline. The\n"
+					" tolerance of each result may be adjusted by editing the file.\n"
+					"\n"
+					"--benchmark-sizes=SIZE1[,SIZE2,...]\n"
+					" Buffer sizes used by --benchmark for encryption and hash algorithms. The\n"
+					" suffix K, M or G multiplies a size by 1024, 1024^2 or 1024^3 (default:\n"
+					" 64K,1M,16M). Also the block sizes of the volume benchmark workloads\n"
+					" (default: 4K).\n"
+					"\n"
+					"--benchmark-threads=COUNT1[,COUNT2,...]\n"
+					" Numbers of encryption threads used by --benchmark (default: 1 and the number\n"
+					" of CPUs). Also the numbers of jobs of the volume benchmark workloads\n"
+					" (default: 1).\n"
+					"\n"
+					"--benchmark-time=SECONDS\n"
+					" Duration of each volume benchmark workload (default: 2).\n"
+					"\n"
+					"--benchmark-type=TYPE1[,TYPE2,...]\n"
+					" Benchmarks to run: encryption, hash, kdf, volume (default: encryption, hash\n"
+					" and kdf).\n"
+					"\n"
+					"--benchmark-workloads=PATTERN1[,PATTERN2,...]\n"
+					" Access patterns of the volume benchmark: seqread, seqwrite, randread,\n"
+					" randwrite, randrw (70% reads). The workloads are all combinations of the given\n"
+					" patterns, block sizes, queue depths and job counts (default: randread and\n"
+					" randwrite). Without any of these options a predefined set of workloads is run.\n"
+					"\n"
 					"--display-password\n"
 					" Display password characters while typing.\n"
 					"\n"
@@ -1247,6 +1773,16 @@ namespace VeraCrypt
 					" and/or keyfiles. This option also specifies the mixing PRF of the random\n"
 					" number generator.\n"
 					"\n"
+					"--io-limit=RATE\n"
+					" Limit the combined write rate of volumes created with --create --manifest to\n"
+					" RATE bytes per second. The suffix K, M or G multiplies RATE by 1024, 1024^2 or\n"
+					" 1024^3.\n"
+					"\n"
+					"--json\n"
+					" Print the results of --benchmark and --calibrate as JSON objects, one per\n"
+					" line. When mounting a volume, print the time spent opening it as a JSON\n"
+					" object (see option --verbose).\n"
+					"\n"
 					"-k, --keyfiles=KEYFILE1[,KEYFILE2,KEYFILE3,...]\n"
 					" Use specified keyfiles when mounting a volume or when changing password\n"
 					" and/or keyfiles. When a directory is specified, all files inside it will be\n"
@@ -1260,6 +1796,21 @@ namespace VeraCrypt
 					"--load-preferences\n"
 					" Load user preferences.\n"
 					"\n"
+					"--manifest=FILE\n"
+					" Process all volumes listed in FILE with --backup-headers, --restore-headers\n"
+					" or --create (text mode only). Volumes are processed concurrently and one JSON\n"
+					" object per volume is printed, followed by a summary. The file uses the\n"
+					" favorite volumes XML format; each <volume> element may have the attributes\n"
+					" backupfile, passwordfile, keyfiles, pim, hash and hiddenpasswordfile,\n"
+					" hiddenkeyfiles, hiddenpim. Without backupfile, restore uses the embedded\n"
+					" backup header. Backup files are written to a temporary file and renamed when\n"
+					" complete.\n"
+					" With --create, each volume may also have the attributes size, encryption,\n"
+					" filesystem (none or fat) and quick; --encryption, --hash, --filesystem,\n"
+					" --size and --quick supply defaults for volumes without them. Without hash and\n"
+					" --hash, the default PRF (SHA-512) is used. Existing files are overwritten\n"
+					" only with --force. See also option --io-limit.\n"
+					"\n"
 					"-m, --mount-options=OPTION1[,OPTION2,OPTION3,...]\n"
 					" Specifies comma-separated mount options for a VeraCrypt volume:\n"
 					"  headerbak: Use backup headers when mounting a volume.\n"
@@ -1293,6 +1844,20 @@ namespace VeraCrypt
 					" command line is potentially insecure as the PIM may be visible in the process \n"
 					" list (see ps(1)) and/or stored in a command history file or system logs.\n"
 					"\n"
+					"--profile-startup\n"
+					" On exit, print to standard error the time taken by each phase of startup\n"
+					" (core service, command line parsing, preferences, and components started on\n"
+					" first use such as language strings, random number generator and encryption\n"
+					" thread pool).\n"
+					"\n"
+					"--progress-fd=FD\n"
+					" Write machine-readable events to the open file descriptor FD, one JSON object\n"
+					" per line. Long-running operations (volume creation, clone, container copy and\n"
+					" compaction, batch header backup and restore) emit \"start\", \"phase\",\n"
+					" \"progress\" and \"end\" events with bytes done, rate and estimated time left.\n"
+					" Each key derivation attempted while opening a volume emits a \"kdf_trial\"\n"
+					" event. Example: veracrypt -t --create ... --progress-fd=3 3>progress.log\n"
+					"\n"
 					"--protect-hidden=yes|no\n"
 					" Write-protect a hidden volume when mounting an outer volume. Before mounting\n"
 					" the outer volume, the user will be prompted for a password to open the hidden\n"
@@ -1347,7 +1912,10 @@ namespace VeraCrypt
 					" or 'hidden'. See option -c for more information on creating hidden volumes.\n"
 					"\n"
 					"-v, --verbose\n"
-					" Enable verbose output.\n"
+					" Enable verbose output. When mounting a volume, the time spent applying\n"
+					" keyfiles, reading headers and deriving header keys is reported per key\n"
+					" derivation function, volume layout and password (cached passwords that failed\n"
+					" and the password of a protected hidden volume are reported separately).\n"
 					"\n"
 					"\n"
 					"IMPORTANT:\n"
@@ -1429,7 +1997,10 @@ namespace VeraCrypt
 			return true;
 
 		case CommandId::RestoreHeaders:
-			RestoreVolumeHeaders (cmdLine.ArgVolumePath);
+			if (cmdLine.ArgManifestPath)
+				RestoreVolumeHeadersBatch (*cmdLine.ArgManifestPath);
+			else
+				RestoreVolumeHeaders (cmdLine.ArgVolumePath);
 			return true;
 
 		case CommandId::SavePreferences:
@@ -1447,6 +2018,125 @@ namespace VeraCrypt
 		return false;
 	}
 
+	void UserInterface::RestoreVolumeHeaderFromBackup (shared_ptr <Volume> volume, shared_ptr <VolumePassword> password, int pim, shared_ptr <KeyfileList> keyfiles)
+	{
+		// Re-encrypt volume header
+		SecureBuffer newHeaderBuffer (volume->GetLayout()->GetHeaderSize());
+		Core->ReEncryptVolumeHeaderWithNewSalt (newHeaderBuffer, volume->GetHeader(), password, pim, keyfiles);
+
+		// Write volume header
+		int headerOffset = volume->GetLayout()->GetHeaderOffset();
+		shared_ptr <File> volumeFile = volume->GetFile();
+
+		if (headerOffset >= 0)
+			volumeFile->SeekAt (headerOffset);
+		else
+			volumeFile->SeekEnd (headerOffset);
+
+		volumeFile->Write (newHeaderBuffer);
+		volumeFile->Flush();
+	}
+
+	void UserInterface::RestoreVolumeHeadersFromBackup (const VolumePath &volumePath, shared_ptr <VolumeLayout> decryptedLayout, shared_ptr <VolumePassword> password, int pim, shared_ptr <KeyfileList> keyfiles)
+	{
+		File volumeFile;
+		volumeFile.Open (volumePath, File::OpenReadWrite, File::ShareNone, File::PreserveTimestamps);
+
+		// Re-encrypt volume header
+		SecureBuffer newHeaderBuffer (decryptedLayout->GetHeaderSize());
+		Core->ReEncryptVolumeHeaderWithNewSalt (newHeaderBuffer, decryptedLayout->GetHeader(), password, pim, keyfiles);
+
+		// Write volume header
+		int headerOffset = decryptedLayout->GetHeaderOffset();
+		if (headerOffset >= 0)
+			volumeFile.SeekAt (headerOffset);
+		else
+			volumeFile.SeekEnd (headerOffset);
+
+		volumeFile.Write (newHeaderBuffer);
+
+		if (decryptedLayout->HasBackupHeader())
+		{
+			// Re-encrypt backup volume header
+			Core->ReEncryptVolumeHeaderWithNewSalt (newHeaderBuffer, decryptedLayout->GetHeader(), password, pim, keyfiles);
+
+			// Write backup volume header
+			headerOffset = decryptedLayout->GetBackupHeaderOffset();
+			if (headerOffset >= 0)
+				volumeFile.SeekAt (headerOffset);
+			else
+				volumeFile.SeekEnd (headerOffset);
+
+			volumeFile.Write (newHeaderBuffer);
+		}
+
+		volumeFile.Flush();
+	}
+
+	void UserInterface::RestoreVolumeHeadersBatch (const FilePath &manifestPath) const
+	{
+		struct RestoreFunctor : public VolumeManifestFunctor
+		{
+			virtual void operator() (const VolumeManifestEntry &entry)
+			{
+				shared_ptr <Pkcs5Kdf> kdf;
+				if (entry.KdfHash)
+					kdf = Pkcs5Kdf::GetAlgorithm (*entry.KdfHash, false);
+
+				if (entry.BackupFile.IsEmpty())
+				{
+					RestoreInternalBackup (entry.Path, entry.GetPassword(), entry.Pim, kdf, entry.Keyfiles, VolumeType::Normal);
+
+					if (entry.HasHiddenVolume())
+						RestoreInternalBackup (entry.Path, entry.GetHiddenPassword(), entry.HiddenPim, kdf, entry.HiddenKeyfiles, VolumeType::Hidden);
+				}
+				else
+				{
+					RestoreExternalBackup (entry.Path, entry.BackupFile, entry.GetPassword(), entry.Pim, kdf, entry.Keyfiles);
+
+					if (entry.HasHiddenVolume())
+						RestoreExternalBackup (entry.Path, entry.BackupFile, entry.GetHiddenPassword(), entry.HiddenPim, kdf, entry.HiddenKeyfiles);
+				}
+			}
+
+			static void RestoreInternalBackup (const VolumePath &path, shared_ptr <VolumePassword> password, int pim, shared_ptr <Pkcs5Kdf> kdf, shared_ptr <KeyfileList> keyfiles, VolumeType::Enum volumeType)
+			{
+				shared_ptr <Volume> volume = Core->OpenVolume (make_shared <VolumePath> (path), true, password, pim, kdf, false, keyfiles, VolumeProtection::None,
+					shared_ptr <VolumePassword> (), 0, shared_ptr <Pkcs5Kdf> (), shared_ptr <KeyfileList> (), false, volumeType, true);
+
+				if (typeid (*volume->GetLayout()) == typeid (VolumeLayoutV1Normal))
+					throw_err (LangString ["VOLUME_HAS_NO_BACKUP_HEADER"]);
+
+				RestoreVolumeHeaderFromBackup (volume, password, pim, keyfiles);
+			}
+
+			static void RestoreExternalBackup (const VolumePath &path, const FilePath &backupFilePath, shared_ptr <VolumePassword> password, int pim, shared_ptr <Pkcs5Kdf> kdf, shared_ptr <KeyfileList> keyfiles)
+			{
+				File backupFile;
+				backupFile.Open (backupFilePath, File::OpenRead);
+
+				bool legacyBackup = IsLegacyHeaderBackup (backupFile);
+
+				shared_ptr <VolumeLayout> decryptedLayout = DecryptHeaderBackup (backupFile, legacyBackup, password, pim, kdf, keyfiles);
+				if (!decryptedLayout)
+				{
+					if (keyfiles && !keyfiles->empty())
+						throw PasswordKeyfilesIncorrect (SRC_POS);
+					throw PasswordIncorrect (SRC_POS);
+				}
+
+				RestoreVolumeHeadersFromBackup (path, decryptedLayout, password, pim, keyfiles);
+			}
+		};
+
+		VolumeManifestEntryList entries = VolumeManifestEntry::LoadList (manifestPath);
+
+		RandomNumberGenerator::Start();
+
+		RestoreFunctor functor;
+		ShowVolumeManifestResults ("restore-headers", VolumeManifestResult::ProcessList ("restore-headers", entries, wxThread::GetCPUCount(), functor));
+	}
+
 	void UserInterface::SetPreferences (const UserPreferences &preferences)
 	{
 		Preferences = preferences;
@@ -1456,12 +2146,345 @@ namespace VeraCrypt
 		PreferencesUpdatedEvent.Raise();
 	}
 
+	void UserInterface::ShowCalibration (const CalibrationData &data, bool jsonOutput) const
+	{
+		if (jsonOutput)
+		{
+			JsonObject pool;
+			pool.Add ("category", "thread_pool");
+			pool.Add ("min_fragment_size", (uint64) data.MinFragmentSize);
+			ShowString (wxString::FromUTF8 (pool.ToString().c_str()) + L"\n");
+		}
+		else
+		{
+			ShowString (L"\nEncryption thread pool:\n");
+
+			if (data.MinFragmentSize != 0)
+				ShowString (StringFormatter (L" Minimum fragment size: {0}\n", SizeToString (data.MinFragmentSize)));
+			else
+				ShowString (L" Not used\n");
+
+			ShowString (L"\nEncryption (bytes per second):\n");
+		}
+
+		foreach (const CalibrationCipherSpeed &speed, data.CipherSpeeds)
+		{
+			if (jsonOutput)
+			{
+				JsonObject json;
+				json.Add ("category", "encryption");
+				json.Add ("algorithm", speed.Algorithm);
+				json.Add ("buffer_size", (uint64) speed.BufferSize);
+				json.Add ("threads", (uint64) speed.ThreadCount);
+				json.Add ("speed", speed.Speed);
+				ShowString (wxString::FromUTF8 (json.ToString().c_str()) + L"\n");
+				continue;
+			}
+
+			ShowString (wxString::Format (L" %-30ls %9ls  %2u thread(s)  %12ls\n", speed.Algorithm.c_str(),
+				SizeToString (speed.BufferSize).c_str(), (unsigned int) speed.ThreadCount, SpeedToString ((uint64) speed.Speed).c_str()));
+		}
+
+		if (!jsonOutput)
+			ShowString (L"\nKey derivation (time per derivation with the default PIM):\n");
+
+		foreach (shared_ptr <Pkcs5Kdf> kdf, Pkcs5Kdf::GetAvailableAlgorithms (false))
+		{
+			map <wstring, double>::const_iterator iterationTime = data.KdfIterationTimes.find (kdf->GetName());
+			if (iterationTime == data.KdfIterationTimes.end())
+				continue;
+
+			double time = iterationTime->second * kdf->GetIterationCount (0) / 1000000000.0;
+
+			if (jsonOutput)
+			{
+				JsonObject json;
+				json.Add ("category", "kdf");
+				json.Add ("algorithm", kdf->GetName());
+				json.Add ("iteration_time_ns", iterationTime->second);
+				json.Add ("time", time);
+				ShowString (wxString::FromUTF8 (json.ToString().c_str()) + L"\n");
+				continue;
+			}
+
+			ShowString (wxString::Format (L" %-30ls %8.3f s\n", kdf->GetName().c_str(), time));
+		}
+
+		if (!data.DeviceLatencies.empty() && !jsonOutput)
+			ShowString (L"\nHost device read latency (4 KB, median):\n");
+
+		typedef pair <wstring, uint64> DeviceLatencyPair;
+		foreach (DeviceLatencyPair device, data.DeviceLatencies)
+		{
+			if (jsonOutput)
+			{
+				JsonObject json;
+				json.Add ("category", "device");
+				json.Add ("path", device.first);
+				json.Add ("latency_ns", device.second);
+				ShowString (wxString::FromUTF8 (json.ToString().c_str()) + L"\n");
+				continue;
+			}
+
+			ShowString (wxString::Format (L" %-30ls %10.1f us\n", device.first.c_str(), (double) device.second / 1000.0));
+		}
+
+		if (!jsonOutput)
+			ShowString (L"\n");
+	}
+
 	void UserInterface::ShowError (const exception &ex) const
 	{
 		if (!dynamic_cast <const UserAbort*> (&ex))
 			DoShowError (ExceptionToMessage (ex));
 	}
 
+	bool UserInterface::ShowBenchmarkComparison (const BenchmarkComparisonList &comparisons, bool jsonOutput) const
+	{
+		struct Formatter
+		{
+			static wxString ValueToString (const UserInterface *ui, double value, const wstring &unit)
+			{
+				if (unit == L"B/s")
+					return ui->SpeedToString ((uint64) value);
+
+				if (unit == L"s")
+					return wxString::Format (L"%.3f s", value);
+
+				return wxString::Format (L"%.0f %ls", value, unit.c_str());
+			}
+		};
+
+		size_t regressionCount = 0;
+		size_t newCount = 0;
+		size_t missingCount = 0;
+
+		foreach (const BenchmarkComparison &comparison, comparisons)
+		{
+			string status = "ok";
+			if (comparison.Missing)
+			{
+				status = "missing";
+				++missingCount;
+			}
+			else if (comparison.New)
+			{
+				status = "new";
+				++newCount;
+			}
+			else if (comparison.Regression)
+			{
+				status = "regression";
+				++regressionCount;
+			}
+
+			if (jsonOutput)
+			{
+				JsonObject json;
+				json.Add ("category", "comparison");
+				json.Add ("key", comparison.Key);
+				json.Add ("status", status);
+
+				if (!comparison.New)
+					json.Add ("baseline", comparison.BaselineValue);
+
+				if (!comparison.Missing)
+					json.Add ("value", comparison.Value);
+
+				if (!comparison.New && !comparison.Missing)
+				{
+					json.Add ("change_pct", comparison.Change);
+					json.Add ("tolerance_pct", comparison.Tolerance);
+				}
+
+				ShowString (wxString::FromUTF8 (json.ToString().c_str()) + L"\n");
+				continue;
+			}
+
+			// Regressions are marked to be easily found in a build log
+			wxString line = wxString::Format (L"%ls %-44ls", comparison.Regression ? L"-" : L" ", comparison.Key.c_str());
+
+			if (comparison.Missing)
+				line += wxString::Format (L" %14ls -> %14ls", Formatter::ValueToString (this, comparison.BaselineValue, comparison.Unit).c_str(), L"?");
+			else if (comparison.New)
+				line += wxString::Format (L" %14ls -> %14ls", L"?", Formatter::ValueToString (this, comparison.Value, comparison.Unit).c_str());
+			else
+			{
+				line += wxString::Format (L" %14ls -> %14ls  %+6.1f%% (tolerance %.0f%%)",
+					Formatter::ValueToString (this, comparison.BaselineValue, comparison.Unit).c_str(),
+					Formatter::ValueToString (this, comparison.Value, comparison.Unit).c_str(),
+					comparison.Change, comparison.Tolerance);
+			}
+
+			ShowString (line + L"  " + wxString::FromUTF8 (status.c_str()) + L"\n");
+		}
+
+		if (jsonOutput)
+		{
+			JsonObject summary;
+			summary.Add ("category", "comparison");
+			summary.Add ("regressions", (uint64) regressionCount);
+			summary.Add ("new", (uint64) newCount);
+			summary.Add ("missing", (uint64) missingCount);
+			ShowString (wxString::FromUTF8 (summary.ToString().c_str()) + L"\n");
+		}
+		else
+		{
+			ShowString (wxString::Format (L"\n%u regression(s), %u new, %u missing\n",
+				(unsigned int) regressionCount, (unsigned int) newCount, (unsigned int) missingCount));
+		}
+
+		return regressionCount == 0;
+	}
+
+	void UserInterface::ShowVolumeManifestResults (const string &operation, const VolumeManifestResultList &results) const
+	{
+		size_t failedCount = 0;
+
+		foreach (const VolumeManifestResult &result, results)
+		{
+			if (!result.Success)
+				++failedCount;
+
+			ShowString (wxString::FromUTF8 (result.ToJson (operation).c_str()) + L"\n");
+		}
+
+		JsonObject summary;
+		summary.Add ("operation", operation);
+		summary.Add ("total", (uint64) results.size());
+		summary.Add ("succeeded", (uint64) (results.size() - failedCount));
+		summary.Add ("failed", (uint64) failedCount);
+		ShowString (wxString::FromUTF8 (summary.ToString().c_str()) + L"\n");
+
+		// The exit code is set by the caller from the outcome of ProcessCommandLine()
+		if (failedCount > 0)
+			throw_err (StringFormatter (_("Operation failed for {0} of {1} volumes."), (uint64) failedCount, (uint64) results.size()));
+	}
+
+	wxString UserInterface::OpenStatisticsToString (const VolumeOpenStatistics &statistics) const
+	{
+		struct Formatter
+		{
+			static wxString TimesToString (const map <wstring, uint64> &times)
+			{
+				wxString str;
+
+				typedef pair <wstring, uint64> TimePair;
+				foreach (TimePair time, times)
+				{
+					if (!str.empty())
+						str << L", ";
+					str << wxString::Format (L"%ls %.3f s", time.first.c_str(), (double) time.second / 1000000000.0);
+				}
+
+				return str;
+			}
+		};
+
+		map <wstring, uint64> kdfTimes;
+		map <wstring, uint64> layoutTimes;
+		map <wstring, uint64> sourceTimes;
+		uint64 kdfTotalTime = 0;
+		KdfTrial successfulTrial;
+
+		foreach (const KdfTrial &trial, statistics.KdfTrials)
+		{
+			kdfTimes[trial.Kdf] += trial.Time;
+			layoutTimes[trial.Layout] += trial.Time;
+			sourceTimes[trial.Source] += trial.Time;
+			kdfTotalTime += trial.Time;
+
+			if (trial.Source == L"password" && trial.Success)
+				successfulTrial = trial;
+		}
+
+		// Option --hash skips only the trials of the layout in which the header was decrypted
+		uint64 successfulTrialNumber = 0;
+
+		foreach (const KdfTrial &trial, statistics.KdfTrials)
+		{
+			if (trial.Source != L"password" || trial.Layout != successfulTrial.Layout)
+				continue;
+
+			++successfulTrialNumber;
+			if (trial.Success)
+				break;
+		}
+
+		if (!successfulTrial.Success)
+			successfulTrialNumber = 0;
+
+		wxString str;
+		str << wxString::Format (L"%ls: %.3f s\n", _("Volume opened in").wc_str(), (double) statistics.TotalTime / 1000000000.0);
+		str << wxString::Format (L" %ls: %.3f s\n", _("Keyfiles").wc_str(), (double) statistics.KeyfileTime / 1000000000.0);
+		str << wxString::Format (L" %ls: %.3f s\n", _("Header reads").wc_str(), (double) statistics.HeaderReadTime / 1000000000.0);
+		str << wxString::Format (L" %ls: %.3f s (%u)\n", _("Key derivation").wc_str(), (double) kdfTotalTime / 1000000000.0, (unsigned int) statistics.KdfTrials.size());
+		str << L"  " << _("By PRF") << L": " << Formatter::TimesToString (kdfTimes) << L"\n";
+		str << L"  " << _("By layout") << L": " << Formatter::TimesToString (layoutTimes) << L"\n";
+		str << L"  " << _("By password") << L": " << Formatter::TimesToString (sourceTimes) << L"\n";
+
+		if (successfulTrialNumber > 1)
+		{
+			shared_ptr <Pkcs5Kdf> kdf = Pkcs5Kdf::GetAlgorithm (successfulTrial.Kdf, false);
+			str << StringFormatter (_("Header decrypted by key derivation trial {0} ({1}, {2}). Option --hash={3} would skip {4} trials.\n"),
+				successfulTrialNumber, successfulTrial.Kdf, successfulTrial.Layout, wstring (kdf->GetHash()->GetName()), successfulTrialNumber - 1);
+		}
+
+		return str;
+	}
+
+	wxString UserInterface::IoStatisticsToString (const wxString &direction, const VolumeIoStatistics &statistics, uint64 elapsedTime) const
+	{
+		wxString str;
+		if (statistics.Operations == 0)
+			return str;
+
+		str << direction << L" " << LangString["IO_STATISTICS_OPERATIONS"] << L": " << statistics.Operations;
+		if (elapsedTime > 0)
+			str << wxString::Format (L" (%.1f IOPS)", (double) statistics.Operations * 1000000000.0 / (double) elapsedTime);
+		str << L'\n';
+
+		str << direction << L" " << LangString["IO_STATISTICS_AVERAGE_SIZE"] << L": " << SizeToString (statistics.Bytes / statistics.Operations) << L'\n';
+
+		wxString sizes;
+		for (size_t i = 0; i < VolumeIoStatistics::SizeBucketCount; ++i)
+		{
+			if (statistics.SizeBuckets[i] == 0)
+				continue;
+
+			if (!sizes.empty())
+				sizes << L", ";
+
+			if (i == VolumeIoStatistics::SizeBucketCount - 1)
+				sizes << L">" << SizeToString (VolumeIoStatistics::GetSizeBucketLimit (i - 1));
+			else
+				sizes << L"<=" << SizeToString (VolumeIoStatistics::GetSizeBucketLimit (i));
+
+			sizes << L": " << statistics.SizeBuckets[i];
+		}
+		str << direction << L" " << LangString["IO_STATISTICS_REQUEST_SIZES"] << L": " << sizes << L'\n';
+
+		struct
+		{
+			wxString Name;
+			const LatencyHistogram *Histogram;
+		} latencies[] =
+		{
+			{ LangString["IO_STATISTICS_HOST_LATENCY"], &statistics.HostLatency },
+			{ LangString["IO_STATISTICS_CRYPTO_LATENCY"], &statistics.CryptoLatency }
+		};
+
+		for (size_t i = 0; i < array_capacity (latencies); ++i)
+		{
+			const LatencyHistogram &histogram = *latencies[i].Histogram;
+			str << direction << L" " << latencies[i].Name << L" (us): " << wxString::Format (L"mean %.1f, p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f",
+				histogram.GetMean() / 1000.0, histogram.GetPercentile (50) / 1000.0, histogram.GetPercentile (90) / 1000.0,
+				histogram.GetPercentile (99) / 1000.0, histogram.GetPercentile (99.9) / 1000.0, histogram.GetMax() / 1000.0) << L'\n';
+		}
+
+		return str;
+	}
+
 	wxString UserInterface::SizeToString (uint64 size) const
 	{
 		wstringstream s;
@@ -1523,6 +2546,7 @@ namespace VeraCrypt
 			throw TestFailed (SRC_POS);
 
 		EncryptionTest::TestAll();
+		CryptoDifferentialTest::TestAll();
 
 		// StringFormatter
 		if (StringFormatter (L"{9} {8} {7} {6} {5} {4} {3} {2} {1} {0} {{0}}", "1", L"2", '3', L'4', 5, 6, 7, 8, 9, 10) != L"10 9 8 7 6 5 4 3 2 1 {0}")
@@ -15,13 +15,16 @@
 
 #include "System.h"
 #include "Core/Core.h"
+#include "Volume/Calibration.h"
 #include "Main.h"
+#include "BenchmarkBaseline.h"
 #include "CommandLineInterface.h"
 #include "FavoriteVolume.h"
 #include "LanguageStrings.h"
 #include "UserPreferences.h"
 #include "UserInterfaceException.h"
 #include "UserInterfaceType.h"
+#include "VolumeManifest.h"
 
 namespace VeraCrypt
 {
@@ -32,12 +35,17 @@ namespace VeraCrypt
 
 		virtual bool AskYesNo (const wxString &message, bool defaultYes = false, bool warning = false) const = 0;
 		virtual void BackupVolumeHeaders (shared_ptr <VolumePath> volumePath) const = 0;
+		virtual void BackupVolumeHeadersBatch (const FilePath &manifestPath) const;
+		virtual void Benchmark (const CryptoBenchmarkOptions &options, bool jsonOutput, BenchmarkBaseline &results) const = 0;
+		virtual void BenchmarkVolume (const VolumeBenchmarkOptions &options, bool jsonOutput, BenchmarkBaseline &results) const = 0;
 		virtual void BeginBusyState () const = 0;
 		virtual void ChangePassword (shared_ptr <VolumePath> volumePath = shared_ptr <VolumePath>(), shared_ptr <VolumePassword> password = shared_ptr <VolumePassword>(), int pim = 0, shared_ptr <Hash> currentHash = shared_ptr <Hash>(), bool truecryptMode = false, shared_ptr <KeyfileList> keyfiles = shared_ptr <KeyfileList>(), shared_ptr <VolumePassword> newPassword = shared_ptr <VolumePassword>(), int newPim = 0, shared_ptr <KeyfileList> newKeyfiles = shared_ptr <KeyfileList>(), shared_ptr <Hash> newHash = shared_ptr <Hash>()) const = 0;
 		virtual void CheckRequirementsForMountingVolume () const;
 		virtual void CloseExplorerWindows (shared_ptr <VolumeInfo> mountedVolume) const;
+		virtual void CloneVolume (shared_ptr <VolumePath> volumePath, shared_ptr <VolumePassword> password, int pim, shared_ptr <Hash> currentHash, shared_ptr <KeyfileList> keyfiles, shared_ptr <VolumeCloneOptions> options) const = 0;
 		virtual void CreateKeyfile (shared_ptr <FilePath> keyfilePath = shared_ptr <FilePath>()) const = 0;
 		virtual void CreateVolume (shared_ptr <VolumeCreationOptions> options) const = 0;
+		virtual void CreateVolumesBatch (const FilePath &manifestPath, shared_ptr <VolumeCreationOptions> defaults, bool overwrite) const;
 		virtual void DeleteSecurityTokenKeyfiles () const = 0;
 		virtual void DismountAllVolumes (bool ignoreOpenFiles = false, bool interactive = true) const;
 		virtual void DismountVolume (shared_ptr <VolumeInfo> volume, bool ignoreOpenFiles = false, bool interactive = true) const;
@@ -55,6 +63,7 @@ namespace VeraCrypt
 		virtual void ImportSecurityTokenKeyfiles () const = 0;
 		virtual void Init ();
 		virtual void InitSecurityTokenLibrary () const = 0;
+		virtual wxString IoStatisticsToString (const wxString &direction, const VolumeIoStatistics &statistics, uint64 elapsedTime) const;
 		virtual void ListMountedVolumes (const VolumeInfoList &volumes) const;
 		virtual void ListSecurityTokenKeyfiles () const = 0;
 		virtual shared_ptr <VolumeInfo> MountVolume (MountOptions &options) const;
@@ -62,7 +71,9 @@ namespace VeraCrypt
 		virtual VolumeInfoList MountAllDeviceHostedVolumes (MountOptions &options) const;
 		virtual VolumeInfoList MountAllFavoriteVolumes (MountOptions &options);
 		virtual void OpenExplorerWindow (const DirectoryPath &path);
+		virtual wxString OpenStatisticsToString (const VolumeOpenStatistics &statistics) const;
 		virtual void RestoreVolumeHeaders (shared_ptr <VolumePath> volumePath) const = 0;
+		virtual void RestoreVolumeHeadersBatch (const FilePath &manifestPath) const;
 		virtual void SetPreferences (const UserPreferences &preferences);
 		virtual void ShowError (const exception &ex) const;
 		virtual void ShowError (const char *langStringId) const { DoShowError (LangString[langStringId]); }
@@ -103,9 +114,16 @@ namespace VeraCrypt
 		virtual void OnVolumeMounted (EventArgs &args);
 		virtual void OnWarning (EventArgs &args);
 		virtual bool ProcessCommandLine ();
+		virtual bool ShowBenchmarkComparison (const BenchmarkComparisonList &comparisons, bool jsonOutput) const;
+		virtual void ShowCalibration (const CalibrationData &data, bool jsonOutput) const;
+		virtual void ShowVolumeManifestResults (const string &operation, const VolumeManifestResultList &results) const;
 
+		static shared_ptr <VolumeLayout> DecryptHeaderBackup (File &backupFile, bool legacyBackup, shared_ptr <VolumePassword> password, int pim, shared_ptr <Pkcs5Kdf> kdf, shared_ptr <KeyfileList> keyfiles);
 		static wxString ExceptionToString (const Exception &ex);
 		static wxString ExceptionTypeToString (const std::type_info &ex);
+		static bool IsLegacyHeaderBackup (const File &backupFile);
+		static void RestoreVolumeHeaderFromBackup (shared_ptr <Volume> volume, shared_ptr <VolumePassword> password, int pim, shared_ptr <KeyfileList> keyfiles);
+		static void RestoreVolumeHeadersFromBackup (const VolumePath &volumePath, shared_ptr <VolumeLayout> decryptedLayout, shared_ptr <VolumePassword> password, int pim, shared_ptr <KeyfileList> keyfiles);
 
 		UserPreferences Preferences;
 		UserInterfaceType::Enum InterfaceType;
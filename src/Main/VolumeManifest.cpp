@@ -0,0 +1,250 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include "System.h"
+#include <wx/tokenzr.h>
+#include "Platform/JsonObject.h"
+#include "Platform/Time.h"
+#include "UserInterface.h"
+#include "VolumeManifest.h"
+#include "Xml.h"
+
+namespace VeraCrypt
+{
+	VolumeManifestEntryList VolumeManifestEntry::LoadList (const FilePath &manifestPath)
+	{
+		VolumeManifestEntryList entries;
+
+		foreach (XmlNode node, XmlParser (manifestPath).GetNodes (L"volume"))
+		{
+			make_shared_auto (VolumeManifestEntry, entry);
+
+			entry->Path = VolumePath (wstring (node.InnerText));
+			if (entry->Path.IsEmpty())
+				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + wstring (manifestPath));
+
+			entry->BackupFile = wstring (node.Attributes[L"backupfile"]);
+			entry->PasswordFile = wstring (node.Attributes[L"passwordfile"]);
+			entry->Keyfiles = ParseKeyfiles (node.Attributes[L"keyfiles"]);
+			entry->HiddenPasswordFile = wstring (node.Attributes[L"hiddenpasswordfile"]);
+			entry->HiddenKeyfiles = ParseKeyfiles (node.Attributes[L"hiddenkeyfiles"]);
+
+			wstring attr = wstring (node.Attributes[L"pim"]);
+			if (!attr.empty())
+				entry->Pim = StringConverter::ToInt32 (attr);
+
+			attr = wstring (node.Attributes[L"hiddenpim"]);
+			if (!attr.empty())
+				entry->HiddenPim = StringConverter::ToInt32 (attr);
+
+			if (entry->Pim < 0 || entry->Pim > MAX_PIM_VALUE || entry->HiddenPim < 0 || entry->HiddenPim > MAX_PIM_VALUE)
+				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + wstring (entry->Path));
+
+			wxString hashName = node.Attributes[L"hash"];
+			if (!hashName.empty())
+			{
+				foreach (shared_ptr <Hash> hash, Hash::GetAvailableAlgorithms())
+				{
+					if (wxString (hash->GetName()).IsSameAs (hashName, false) || wxString (hash->GetAltName()).IsSameAs (hashName, false))
+						entry->KdfHash = hash;
+				}
+
+				if (!entry->KdfHash)
+					throw_err (LangString["UNKNOWN_OPTION"] + L": " + hashName);
+			}
+
+			wxString eaName = node.Attributes[L"encryption"];
+			if (!eaName.empty())
+			{
+				foreach (shared_ptr <EncryptionAlgorithm> ea, EncryptionAlgorithm::GetAvailableAlgorithms())
+				{
+					if (!ea->IsDeprecated() && wxString (ea->GetName()).IsSameAs (eaName, false))
+						entry->EA = ea;
+				}
+
+				if (!entry->EA)
+					throw_err (LangString["UNKNOWN_OPTION"] + L": " + eaName);
+			}
+
+			wxString filesystem = node.Attributes[L"filesystem"];
+			if (!filesystem.empty())
+			{
+				if (filesystem.IsSameAs (L"none", false))
+					entry->Filesystem = VolumeCreationOptions::FilesystemType::None;
+				else if (filesystem.IsSameAs (L"fat", false))
+					entry->Filesystem = VolumeCreationOptions::FilesystemType::FAT;
+				else
+					throw_err (LangString["UNKNOWN_OPTION"] + L": " + filesystem);
+			}
+
+			wxString quick = node.Attributes[L"quick"];
+			entry->Quick = quick.IsSameAs (L"1") || quick.IsSameAs (L"true", false);
+
+			wxString size = node.Attributes[L"size"];
+			if (!size.empty())
+				entry->Size = CommandLineInterface::ParseSize (size);
+
+			entries.push_back (entry);
+		}
+
+		return entries;
+	}
+
+	shared_ptr <KeyfileList> VolumeManifestEntry::ParseKeyfiles (const wxString &attr)
+	{
+		shared_ptr <KeyfileList> keyfiles;
+		if (attr.empty())
+			return keyfiles;
+
+		keyfiles.reset (new KeyfileList);
+
+		wxStringTokenizer tokenizer (attr, L",");
+		while (tokenizer.HasMoreTokens())
+		{
+			wxString token = tokenizer.GetNextToken();
+			if (!token.empty())
+				keyfiles->push_back (make_shared <Keyfile> (wstring (token)));
+		}
+
+		return keyfiles;
+	}
+
+	shared_ptr <VolumePassword> VolumeManifestEntry::ReadPasswordFile (const FilePath &path)
+	{
+		if (path.IsEmpty())
+			return make_shared <VolumePassword> ();
+
+		File file;
+		file.Open (path, File::OpenRead);
+
+		// Read one byte more than allowed to detect passwords that are too long
+		SecureBuffer buffer (VolumePassword::MaxSize + 2);
+		size_t length = 0;
+		uint64 readLength;
+
+		while (length < buffer.Size() && (readLength = file.Read (buffer.GetRange (length, buffer.Size() - length))) > 0)
+			length += (size_t) readLength;
+
+		while (length > 0 && (buffer[length - 1] == '\n' || buffer[length - 1] == '\r'))
+			--length;
+
+		if (length > VolumePassword::MaxSize)
+			throw PasswordUTF8TooLong (SRC_POS);
+
+		return make_shared <VolumePassword> (buffer.Ptr(), length);
+	}
+
+	VolumeManifestResultList VolumeManifestResult::ProcessList (const string &operation, const VolumeManifestEntryList &entries, size_t threadCount, VolumeManifestFunctor &functor)
+	{
+		vector < shared_ptr <VolumeManifestEntry> > pendingEntries (entries.begin(), entries.end());
+		vector <VolumeManifestResult> results (pendingEntries.size());
+
+		struct WorkerFunctor : public Functor
+		{
+			WorkerFunctor (const string &operation, vector < shared_ptr <VolumeManifestEntry> > &entries, vector <VolumeManifestResult> &results, Mutex &queueMutex, size_t &nextEntry, VolumeManifestFunctor &functor)
+				: Operation (operation), Entries (entries), Results (results), QueueMutex (queueMutex), NextEntry (nextEntry), EntryFunctor (functor) { }
+
+			virtual void operator() ()
+			{
+				while (true)
+				{
+					size_t index;
+					{
+						ScopeLock lock (QueueMutex);
+						if (NextEntry >= Entries.size())
+							return;
+						index = NextEntry++;
+					}
+
+					VolumeManifestResult &result = Results[index];
+					result.Entry = Entries[index];
+
+					ProgressReporter progress (Operation, wstring (result.Entry->Path));
+					uint64 startTime = Time::GetMonotonic();
+					try
+					{
+						EntryFunctor (*result.Entry);
+						result.Success = true;
+						progress.Complete();
+					}
+					catch (exception &e)
+					{
+						result.ErrorMessage = UserInterface::ExceptionToMessage (e);
+						progress.Fail (wstring (result.ErrorMessage));
+					}
+					catch (...)
+					{
+						result.ErrorMessage = UserInterface::ExceptionToMessage (UnknownException (SRC_POS));
+						progress.Fail (wstring (result.ErrorMessage));
+					}
+					result.ElapsedTime = Time::GetMonotonic() - startTime;
+				}
+			}
+
+			string Operation;
+			vector < shared_ptr <VolumeManifestEntry> > &Entries;
+			vector <VolumeManifestResult> &Results;
+			Mutex &QueueMutex;
+			size_t &NextEntry;
+			VolumeManifestFunctor &EntryFunctor;
+		};
+
+		Mutex queueMutex;
+		size_t nextEntry = 0;
+
+		if (threadCount < 1)
+			threadCount = 1;
+		if (threadCount > pendingEntries.size())
+			threadCount = pendingEntries.size();
+
+		list < shared_ptr <Thread> > threads;
+		try
+		{
+			for (size_t i = 0; i < threadCount; ++i)
+			{
+				make_shared_auto (Thread, thread);
+				thread->Start (new WorkerFunctor (operation, pendingEntries, results, queueMutex, nextEntry, functor));
+				threads.push_back (thread);
+			}
+		}
+		catch (...)
+		{
+			// Workers already started refer to the local state of this function
+			foreach_ref (const Thread &thread, threads)
+				thread.Join();
+
+			throw;
+		}
+
+		foreach_ref (const Thread &thread, threads)
+			thread.Join();
+
+		return VolumeManifestResultList (results.begin(), results.end());
+	}
+
+	string VolumeManifestResult::ToJson (const string &operation) const
+	{
+		JsonObject json;
+		json.Add ("operation", operation);
+		json.Add ("volume", wstring (Entry->Path));
+
+		if (!Entry->BackupFile.IsEmpty())
+			json.Add ("backupfile", wstring (Entry->BackupFile));
+
+		if (Entry->Size != 0)
+			json.Add ("size", Entry->Size);
+
+		json.Add ("status", Success ? "ok" : "failed");
+		json.Add ("elapsed_ms", (double) ElapsedTime / 1000000.0);
+
+		if (!Success)
+			json.Add ("error", wstring (ErrorMessage));
+
+		return json.ToString();
+	}
+}
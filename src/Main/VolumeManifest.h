@@ -0,0 +1,95 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Main_VolumeManifest
+#define TC_HEADER_Main_VolumeManifest
+
+#include "System.h"
+#include "Main.h"
+
+namespace VeraCrypt
+{
+	struct VolumeManifestEntry;
+	typedef list < shared_ptr <VolumeManifestEntry> > VolumeManifestEntryList;
+
+	// Describes one volume of a batch operation. Manifest files use the same XML
+	// layout as the favorite volumes list:
+	//
+	// <VeraCrypt>
+	//   <volumes>
+	//     <volume passwordfile="/root/sdb1.pwd" backupfile="/backup/sdb1.hdr">/dev/sdb1</volume>
+	//   </volumes>
+	// </VeraCrypt>
+	//
+	// Credentials are never stored in the manifest itself; "passwordfile" refers to a
+	// file whose content (without the trailing newline) is the password.
+	//
+	// Volumes to be created are described by the additional attributes "size" (with an
+	// optional K/M/G/T suffix), "encryption", "filesystem" ("none" or "fat") and "quick".
+	struct VolumeManifestEntry
+	{
+	public:
+		VolumeManifestEntry ()
+			: Filesystem (VolumeCreationOptions::FilesystemType::Unknown),
+			HiddenPim (0),
+			Pim (0),
+			Quick (false),
+			Size (0)
+		{
+		}
+
+		shared_ptr <VolumePassword> GetHiddenPassword () const { return ReadPasswordFile (HiddenPasswordFile); }
+		shared_ptr <VolumePassword> GetPassword () const { return ReadPasswordFile (PasswordFile); }
+		bool HasHiddenVolume () const { return !HiddenPasswordFile.IsEmpty() || (HiddenKeyfiles && !HiddenKeyfiles->empty()); }
+		static VolumeManifestEntryList LoadList (const FilePath &manifestPath);
+
+		FilePath BackupFile;
+		shared_ptr <EncryptionAlgorithm> EA;
+		VolumeCreationOptions::FilesystemType::Enum Filesystem;
+		shared_ptr <KeyfileList> HiddenKeyfiles;
+		FilePath HiddenPasswordFile;
+		int HiddenPim;
+		shared_ptr <Hash> KdfHash;
+		shared_ptr <KeyfileList> Keyfiles;
+		FilePath PasswordFile;
+		VolumePath Path;
+		int Pim;
+		bool Quick;
+		uint64 Size;
+
+	protected:
+		static shared_ptr <KeyfileList> ParseKeyfiles (const wxString &attr);
+		static shared_ptr <VolumePassword> ReadPasswordFile (const FilePath &path);
+	};
+
+	struct VolumeManifestResult;
+	typedef list <VolumeManifestResult> VolumeManifestResultList;
+
+	struct VolumeManifestFunctor
+	{
+		virtual ~VolumeManifestFunctor () { }
+		virtual void operator() (const VolumeManifestEntry &entry) = 0;
+	};
+
+	struct VolumeManifestResult
+	{
+		VolumeManifestResult () : ElapsedTime (0), Success (false) { }
+
+		// Runs the functor for every entry on up to threadCount concurrent threads.
+		// Failures are captured per entry and do not stop processing of other entries.
+		static VolumeManifestResultList ProcessList (const string &operation, const VolumeManifestEntryList &entries, size_t threadCount, VolumeManifestFunctor &functor);
+		string ToJson (const string &operation) const;
+
+		shared_ptr <VolumeManifestEntry> Entry;
+		uint64 ElapsedTime; // Nanoseconds
+		wxString ErrorMessage;
+		bool Success;
+	};
+}
+
+#endif // TC_HEADER_Main_VolumeManifest
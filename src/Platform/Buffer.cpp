@@ -12,6 +12,8 @@
 
 #include "Buffer.h"
 #include "Exception.h"
+#include "HugePageMemory.h"
+#include "SecureMemory.h"
 
 namespace VeraCrypt
 {
@@ -121,7 +123,19 @@ namespace VeraCrypt
 
 	void SecureBuffer::Allocate (size_t size, size_t alignment)
 	{
-		Buffer::Allocate (size, alignment);
+		if (size < 1)
+			throw ParameterIncorrect (SRC_POS);
+
+		if (DataPtr != nullptr)
+		{
+			if ((DataSize == size) && (DataAlignment == alignment))
+				return;
+			Free();
+		}
+
+		DataPtr = static_cast<byte *> (SecureMemory::Allocate (size, alignment));
+		DataSize = size;
+		DataAlignment = alignment;
 	}
 
 	void SecureBuffer::Free ()
@@ -129,8 +143,48 @@ namespace VeraCrypt
 		if (DataPtr == nullptr)
 			throw NotInitialized (SRC_POS);
 
-		Erase ();
-		Buffer::Free ();
+		// The memory is erased by SecureMemory
+		SecureMemory::Free (DataPtr, DataSize, DataAlignment);
+		DataPtr = nullptr;
+		DataSize = 0;
+		DataAlignment = 0;
+	}
+
+	IoBuffer::~IoBuffer ()
+	{
+		if (DataPtr != nullptr && DataSize != 0)
+			Free ();
+	}
+
+	void IoBuffer::Allocate (size_t size, size_t alignment)
+	{
+		if (size < 1)
+			throw ParameterIncorrect (SRC_POS);
+
+		if (alignment > HugePageMemory::GetPageSize())
+			throw ParameterIncorrect (SRC_POS);
+
+		if (DataPtr != nullptr)
+		{
+			if (DataSize == size)
+				return;
+			Free();
+		}
+
+		DataPtr = static_cast<byte *> (HugePageMemory::Allocate (size));
+		DataSize = size;
+		DataAlignment = HugePageMemory::GetPageSize();
+	}
+
+	void IoBuffer::Free ()
+	{
+		if (DataPtr == nullptr)
+			throw NotInitialized (SRC_POS);
+
+		HugePageMemory::Free (DataPtr, DataSize);
+		DataPtr = nullptr;
+		DataSize = 0;
+		DataAlignment = 0;
 	}
 
 	void BufferPtr::CopyFrom (const ConstBufferPtr &bufferPtr) const
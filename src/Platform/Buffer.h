@@ -116,6 +116,22 @@ namespace VeraCrypt
 		SecureBuffer &operator= (const SecureBuffer &);
 	};
 
+	// Buffer for bulk I/O, aligned to at least a page and backed by huge pages when large enough (see HugePageMemory)
+	class IoBuffer : public Buffer
+	{
+	public:
+		IoBuffer () { }
+		IoBuffer (size_t size) { Allocate (size); }
+		virtual ~IoBuffer ();
+
+		virtual void Allocate (size_t size, size_t alignment = 0);
+		virtual void Free ();
+
+	private:
+		IoBuffer (const IoBuffer &);
+		IoBuffer &operator= (const IoBuffer &);
+	};
+
 }
 
 #endif // TC_HEADER_Platform_Buffer
@@ -0,0 +1,36 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Platform_EventStream
+#define TC_HEADER_Platform_EventStream
+
+#include "PlatformBase.h"
+#include "JsonObject.h"
+#include "Mutex.h"
+
+namespace VeraCrypt
+{
+	// Writes machine-readable events, one JSON object per line, to a file descriptor.
+	// Events are discarded unless a file descriptor has been set.
+	class EventStream
+	{
+	public:
+		static void Emit (const string &eventName, const JsonObject &fields = JsonObject());
+		static bool IsEnabled () { return FileDescriptor != -1; }
+		static void SetFileDescriptor (int fd);
+
+	protected:
+		static volatile int FileDescriptor;
+		static Mutex WriteMutex;
+
+	private:
+		EventStream ();
+	};
+}
+
+#endif // TC_HEADER_Platform_EventStream
@@ -74,19 +74,26 @@ namespace VeraCrypt
 		static void Copy (const FilePath &sourcePath, const FilePath &destinationPath, bool preserveTimestamps = true);
 		void Delete ();
 		void Flush () const;
+		uint64 GetAllocatedSize () const;
 		uint32 GetDeviceSectorSize () const;
 		static size_t GetOptimalReadSize () { return OptimalReadSize; }
 		static size_t GetOptimalWriteSize ()  { return OptimalWriteSize; }
+		static size_t GetSparseBlockSize () { return SparseBlockSize; }
 		uint64 GetPartitionDeviceStartOffset () const;
 		bool IsOpen () const { return FileIsOpen; }
 		FilePath GetPath () const;
 		uint64 Length () const;
+		static bool IsZero (const ConstBufferPtr &buffer);
 		void Open (const FilePath &path, FileOpenMode mode = OpenRead, FileShareMode shareMode = ShareReadWrite, FileOpenFlags flags = FlagsNone);
 		uint64 Read (const BufferPtr &buffer) const;
+		void PunchHole (uint64 position, uint64 length) const;
 		void ReadCompleteBuffer (const BufferPtr &buffer) const;
 		uint64 ReadAt (const BufferPtr &buffer, uint64 position) const;
 		void SeekAt (uint64 position) const;
+		uint64 SeekData (uint64 position) const; // Returns start of the next region containing data or file length if there is none
 		void SeekEnd (int ofset) const;
+		uint64 SeekHole (uint64 position) const; // Returns start of the next hole or file length if there is none
+		void SetLength (uint64 length) const;
 		void Write (const ConstBufferPtr &buffer) const;
 		void Write (const ConstBufferPtr &buffer, size_t length) const { Write (buffer.GetRange (0, length)); }
 		void WriteAt (const ConstBufferPtr &buffer, uint64 position) const;
@@ -96,6 +103,7 @@ namespace VeraCrypt
 
 		static const size_t OptimalReadSize = 256 * 1024;
 		static const size_t OptimalWriteSize = 256 * 1024;
+		static const size_t SparseBlockSize = 4096;
 
 		bool FileIsOpen;
 		FileOpenFlags mFileOpenFlags;
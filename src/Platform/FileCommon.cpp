@@ -10,6 +10,7 @@
  code distribution packages.
 */
 
+#include "ProgressReporter.h"
 #include "File.h"
 #ifdef TC_UNIX
 #include <sys/types.h>
@@ -35,18 +36,62 @@ namespace VeraCrypt
 		File source;
 		source.Open (sourcePath);
 
+		// Only a regular file is empty after it is opened for writing. Devices may contain stale data.
+		bool sparseDestination = true;
+#ifdef TC_UNIX
+		struct stat sourceStat;
+		struct stat destinationStat;
+		throw_sys_sub_if (stat (string (sourcePath).c_str(), &sourceStat) == -1, wstring (sourcePath));
+
+		if (stat (string (destinationPath).c_str(), &destinationStat) == 0)
+		{
+			// Opening the destination would truncate the source
+			if (destinationStat.st_dev == sourceStat.st_dev && destinationStat.st_ino == sourceStat.st_ino)
+				throw ParameterIncorrect (SRC_POS);
+
+			sparseDestination = S_ISREG (destinationStat.st_mode);
+		}
+#endif
+
 		File destination;
 		destination.Open (destinationPath, CreateWrite);
 
 		SecureBuffer buffer (OptimalReadSize);
-		uint64 len;
+		uint64 sourceLength = source.Length();
+		uint64 position = sparseDestination ? source.SeekData (0) : 0;
 
-		while ((len = source.Read (buffer)) > 0)
+		ProgressReporter progress ("copy", wstring (sourcePath), sourceLength);
+
+		// Holes and blocks of zeroes are not written to keep sparse files sparse
+		while (position < sourceLength)
 		{
-			destination.Write (buffer, static_cast <size_t> (len));
+			uint64 dataEnd = sparseDestination ? source.SeekHole (position) : sourceLength;
+
+			while (position < dataEnd)
+			{
+				size_t len = static_cast <size_t> (source.ReadAt (buffer.GetRange (0, static_cast <size_t> (VC_MIN (dataEnd - position, (uint64) buffer.Size()))), position));
+				if (len == 0)
+					break;
+
+				for (size_t offset = 0; offset < len; offset += SparseBlockSize)
+				{
+					ConstBufferPtr block = buffer.GetRange (offset, VC_MIN (len - offset, SparseBlockSize));
+					if (!sparseDestination || !IsZero (block))
+						destination.WriteAt (block, position + offset);
+				}
+
+				position += len;
+				progress.Update (position);
+			}
+
+			position = sparseDestination ? source.SeekData (dataEnd) : dataEnd;
 		}
 
-		if (preserveTimestamps)
+		if (sparseDestination)
+			destination.SetLength (sourceLength);
+		progress.Complete();
+
+		if (preserveTimestamps && sparseDestination)
 		{
 			destination.Flush();
 #ifndef TC_WINDOWS
@@ -61,6 +106,14 @@ namespace VeraCrypt
 		}
 	}
 
+	bool File::IsZero (const ConstBufferPtr &buffer)
+	{
+		const byte *data = buffer.Get();
+		size_t size = buffer.Size();
+
+		return size == 0 || (data[0] == 0 && memcmp (data, data + 1, size - 1) == 0);
+	}
+
 	FilePath File::GetPath () const
 	{
 		if_debug (ValidateState());
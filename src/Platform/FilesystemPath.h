@@ -57,6 +57,7 @@ namespace VeraCrypt
 		bool IsDirectory () const throw () { try { return GetType() == FilesystemPathType::Directory; } catch (...) { return false; } }
 		bool IsEmpty () const throw () { try { return Path.empty(); } catch (...) { return false; } }
 		bool IsFile () const throw () { try { return GetType() == FilesystemPathType::File; } catch (...) { return false; } }
+		void Rename (const FilesystemPath &newPath) const;
 		FilesystemPath ToBaseName () const;
 		FilesystemPath ToHostDriveOfPartition () const;
 
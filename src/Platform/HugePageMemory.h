@@ -0,0 +1,35 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Platform_HugePageMemory
+#define TC_HEADER_Platform_HugePageMemory
+
+#include "PlatformBase.h"
+
+namespace VeraCrypt
+{
+	// Page-aligned memory mapped directly from the system, suitable for unbuffered (O_DIRECT) I/O.
+	// Allocations of at least one huge page are backed by huge pages when possible: explicit huge
+	// pages reserved by the administrator are used first, then transparent huge pages. Smaller
+	// allocations, and systems without huge page support, use ordinary pages. Explicit huge pages
+	// do not support all memory advice (e.g., MADV_FREE) and can be excluded.
+	class HugePageMemory
+	{
+	public:
+		static void *Allocate (size_t size, bool explicitHugePages = true);
+		static void Free (void *memory, size_t size);
+		static size_t GetHugePageSize ();				// 0 if huge pages are not supported
+		static size_t GetMappedSize (size_t size);		// Size of the mapping made by Allocate()
+		static size_t GetPageSize ();
+
+	private:
+		HugePageMemory ();
+	};
+}
+
+#endif // TC_HEADER_Platform_HugePageMemory
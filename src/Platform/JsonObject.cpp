@@ -0,0 +1,147 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include "JsonObject.h"
+
+namespace VeraCrypt
+{
+	JsonObject &JsonObject::Add (const string &name, bool value)
+	{
+		return AddMember (name, value ? "true" : "false");
+	}
+
+	JsonObject &JsonObject::Add (const string &name, double value)
+	{
+		if (isnan (value) || isinf (value))
+			return AddMember (name, "null");
+
+		char buf[64];
+		snprintf (buf, sizeof (buf), "%.6g", value);
+		return AddMember (name, buf);
+	}
+
+	JsonObject &JsonObject::Add (const string &name, int64 value)
+	{
+		stringstream s;
+		s << value;
+		return AddMember (name, s.str());
+	}
+
+	JsonObject &JsonObject::Add (const string &name, uint64 value)
+	{
+		stringstream s;
+		s << value;
+		return AddMember (name, s.str());
+	}
+
+	JsonObject &JsonObject::Add (const string &name, const string &value)
+	{
+		return AddMember (name, "\"" + Escape (value) + "\"");
+	}
+
+	JsonObject &JsonObject::Add (const string &name, const wstring &value)
+	{
+		return AddMember (name, "\"" + Escape (value) + "\"");
+	}
+
+	JsonObject &JsonObject::Add (const string &name, const JsonObject &value)
+	{
+		return AddMember (name, value.ToString());
+	}
+
+	JsonObject &JsonObject::Append (const JsonObject &other)
+	{
+		if (!other.Members.empty())
+		{
+			if (!Members.empty())
+				Members += ",";
+
+			Members += other.Members;
+		}
+
+		return *this;
+	}
+
+	JsonObject &JsonObject::AddMember (const string &name, const string &jsonValue)
+	{
+		if (!Members.empty())
+			Members += ",";
+
+		Members += "\"" + Escape (name) + "\":" + jsonValue;
+		return *this;
+	}
+
+	string JsonObject::Escape (const string &str)
+	{
+		string escaped;
+		escaped.reserve (str.size());
+
+		for (size_t i = 0; i < str.size(); ++i)
+		{
+			unsigned char c = (unsigned char) str[i];
+			switch (c)
+			{
+			case '"':	escaped += "\\\""; break;
+			case '\\':	escaped += "\\\\"; break;
+			case '\b':	escaped += "\\b"; break;
+			case '\f':	escaped += "\\f"; break;
+			case '\n':	escaped += "\\n"; break;
+			case '\r':	escaped += "\\r"; break;
+			case '\t':	escaped += "\\t"; break;
+			default:
+				if (c < 0x20)
+				{
+					char buf[8];
+					snprintf (buf, sizeof (buf), "\\u%04x", c);
+					escaped += buf;
+				}
+				else
+					escaped += (char) c;
+			}
+		}
+
+		return escaped;
+	}
+
+	string JsonObject::Escape (const wstring &str)
+	{
+		// JSON text is always UTF-8 regardless of the current locale
+		string utf8;
+		utf8.reserve (str.size());
+
+		for (size_t i = 0; i < str.size(); ++i)
+		{
+			uint32 c = (uint32) str[i];
+
+			if (c < 0x80)
+				utf8 += (char) c;
+			else if (c < 0x800)
+			{
+				utf8 += (char) (0xC0 | (c >> 6));
+				utf8 += (char) (0x80 | (c & 0x3F));
+			}
+			else if (c < 0x10000)
+			{
+				utf8 += (char) (0xE0 | (c >> 12));
+				utf8 += (char) (0x80 | ((c >> 6) & 0x3F));
+				utf8 += (char) (0x80 | (c & 0x3F));
+			}
+			else
+			{
+				utf8 += (char) (0xF0 | ((c >> 18) & 0x07));
+				utf8 += (char) (0x80 | ((c >> 12) & 0x3F));
+				utf8 += (char) (0x80 | ((c >> 6) & 0x3F));
+				utf8 += (char) (0x80 | (c & 0x3F));
+			}
+		}
+
+		return Escape (utf8);
+	}
+}
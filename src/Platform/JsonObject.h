@@ -0,0 +1,47 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Platform_JsonObject
+#define TC_HEADER_Platform_JsonObject
+
+#include "PlatformBase.h"
+
+namespace VeraCrypt
+{
+	// Builds a single-line JSON object, suitable for machine-readable output (one object per line)
+	class JsonObject
+	{
+	public:
+		JsonObject () { }
+		virtual ~JsonObject () { }
+
+		JsonObject &Add (const string &name, bool value);
+		JsonObject &Add (const string &name, double value);
+		JsonObject &Add (const string &name, int32 value) { return Add (name, (int64) value); }
+		JsonObject &Add (const string &name, uint32 value) { return Add (name, (uint64) value); }
+		JsonObject &Add (const string &name, int64 value);
+		JsonObject &Add (const string &name, uint64 value);
+		JsonObject &Add (const string &name, const char *value) { return Add (name, string (value)); }
+		JsonObject &Add (const string &name, const string &value);
+		JsonObject &Add (const string &name, const wstring &value);
+		JsonObject &Add (const string &name, const JsonObject &value);
+		JsonObject &Append (const JsonObject &other);
+		bool IsEmpty () const { return Members.empty(); }
+		string ToString () const { return "{" + Members + "}"; }
+
+		static string Escape (const string &str);
+		static string Escape (const wstring &str);
+
+	protected:
+		JsonObject &AddMember (const string &name, const string &jsonValue);
+
+		string Members;
+	};
+}
+
+#endif // TC_HEADER_Platform_JsonObject
@@ -45,7 +45,28 @@ namespace VeraCrypt
 
 	void MemoryStream::Write (const ConstBufferPtr &data)
 	{
-		for (uint64 i = 0; i < data.Size(); i++)
-			Data.push_back (data[i]);
+		Data.insert (Data.end(), data.Get(), data.Get() + data.Size());
+	}
+
+	uint64 MemoryReadStream::Read (const BufferPtr &buffer)
+	{
+		size_t len = buffer.Size();
+		if (Data.Size() - ReadPosition < len)
+			len = Data.Size() - ReadPosition;
+
+		BufferPtr(buffer).CopyFrom (Data.GetRange (ReadPosition, len));
+		ReadPosition += len;
+		return len;
+	}
+
+	void MemoryReadStream::ReadCompleteBuffer (const BufferPtr &buffer)
+	{
+		if (Read (buffer) != buffer.Size())
+			throw InsufficientData (SRC_POS);
+	}
+
+	void MemoryReadStream::Write (const ConstBufferPtr &data)
+	{
+		throw NotApplicable (SRC_POS);
 	}
 }
@@ -29,12 +29,30 @@ namespace VeraCrypt
 
 		virtual uint64 Read (const BufferPtr &buffer);
 		virtual void ReadCompleteBuffer (const BufferPtr &buffer);
+		void Reserve (size_t size) { Data.reserve (size); }
 		virtual void Write (const ConstBufferPtr &data);
 
 	protected:
 		vector <byte> Data;
 		size_t ReadPosition;
 	};
+
+	// Reads data owned by the caller without copying it into the stream. The data must remain
+	// valid and unchanged while the stream is in use.
+	class MemoryReadStream : public Stream
+	{
+	public:
+		MemoryReadStream (const ConstBufferPtr &data) : Data (data), ReadPosition (0) { }
+		virtual ~MemoryReadStream () { }
+
+		virtual uint64 Read (const BufferPtr &buffer);
+		virtual void ReadCompleteBuffer (const BufferPtr &buffer);
+		virtual void Write (const ConstBufferPtr &data);
+
+	protected:
+		ConstBufferPtr Data;
+		size_t ReadPosition;
+	};
 }
 
 #endif // TC_HEADER_Platform_MemoryStream
@@ -18,6 +18,7 @@
 #include "Exception.h"
 #include "Directory.h"
 #include "Event.h"
+#include "EventStream.h"
 #include "File.h"
 #include "FilesystemPath.h"
 #include "Finally.h"
@@ -25,6 +26,8 @@
 #include "Functor.h"
 #include "Memory.h"
 #include "Mutex.h"
+#include "ProgressReporter.h"
+#include "RateLimiter.h"
 #include "SharedPtr.h"
 #include "SystemException.h"
 #include "Thread.h"
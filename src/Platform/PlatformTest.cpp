@@ -13,10 +13,12 @@
 #include "PlatformTest.h"
 #include "Exception.h"
 #include "FileStream.h"
+#include "HugePageMemory.h"
 #include "Finally.h"
 #include "ForEach.h"
 #include "MemoryStream.h"
 #include "Mutex.h"
+#include "SecureMemory.h"
 #include "Serializable.h"
 #include "SharedPtr.h"
 #include "StringConverter.h"
@@ -24,6 +26,11 @@
 #include "Thread.h"
 #include "Common/Tcdefs.h"
 
+#ifdef TC_UNIX
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 namespace VeraCrypt
 {
 	// make_shared_auto, File, Stream, MemoryStream, Endian, Serializer, Serializable
@@ -163,6 +170,95 @@ namespace VeraCrypt
 		}
 	}
 
+	// IoBuffer, HugePageMemory
+	void PlatformTest::IoBufferTest ()
+	{
+		const size_t sizes[] = { 1, 5000, 64 * 1024, 4 * 1024 * 1024 + 1 };
+
+		for (size_t i = 0; i < array_capacity (sizes); ++i)
+		{
+			IoBuffer buffer (sizes[i]);
+
+			if ((reinterpret_cast <uintptr_t> (buffer.Ptr()) % HugePageMemory::GetPageSize()) != 0 || buffer.Alignment() != HugePageMemory::GetPageSize())
+				throw TestFailed (SRC_POS);
+
+			size_t hugePageSize = HugePageMemory::GetHugePageSize();
+			if (hugePageSize != 0 && sizes[i] >= hugePageSize && HugePageMemory::GetMappedSize (sizes[i]) % hugePageSize != 0)
+				throw TestFailed (SRC_POS);
+
+			// The mapping must be writable in full
+			memset (buffer.Ptr(), 0xff, buffer.Size());
+
+			buffer.Allocate (sizes[i] + 1);
+			if (buffer.Size() != sizes[i] + 1)
+				throw TestFailed (SRC_POS);
+		}
+	}
+
+	// SecureBuffer, SecureMemory
+	void PlatformTest::SecureMemoryTest ()
+	{
+		const size_t sizes[] = { 1, 16, 17, 100, 4096, 5000, SecureMemory::MaxBlockSize, SecureMemory::MaxBlockSize + 1, 300 * 1024, 4 * 1024 * 1024 + 1 };
+		const size_t alignments[] = { 0, 16, 4096 };
+
+		// Memory must be zeroed when freed, which is verified when the blocks are reused
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			list < shared_ptr <SecureBuffer> > buffers;
+
+			for (size_t i = 0; i < array_capacity (sizes); ++i)
+			{
+				for (size_t j = 0; j < array_capacity (alignments); ++j)
+				{
+					shared_ptr <SecureBuffer> buffer (new SecureBuffer (sizes[i], alignments[j]));
+
+					if (alignments[j] != 0 && (reinterpret_cast <uintptr_t> (buffer->Ptr()) % alignments[j]) != 0)
+						throw TestFailed (SRC_POS);
+
+					for (size_t k = 0; k < buffer->Size(); ++k)
+					{
+						if ((*buffer)[k] != 0)
+							throw TestFailed (SRC_POS);
+					}
+
+					memset (buffer->Ptr(), 0xff, buffer->Size());
+					buffers.push_back (buffer);
+				}
+			}
+		}
+
+		SecureMemoryStatistics statistics = SecureMemory::GetStatistics();
+		if (statistics.SlabCount == 0 || statistics.LockedBytes + statistics.UnlockedBytes == 0)
+			throw TestFailed (SRC_POS);
+
+#ifdef TC_UNIX
+		// Child processes, such as the FUSE service, use keys inherited from the parent
+		for (size_t i = 0; i < array_capacity (sizes); ++i)
+		{
+			SecureBuffer buffer (sizes[i]);
+			memset (buffer.Ptr(), 0x5a, buffer.Size());
+
+			pid_t pid = fork();
+			if (pid == -1)
+				throw TestFailed (SRC_POS);
+
+			if (pid == 0)
+			{
+				for (size_t j = 0; j < buffer.Size(); ++j)
+				{
+					if (buffer[j] != 0x5a)
+						_exit (1);
+				}
+				_exit (0);
+			}
+
+			int status;
+			if (waitpid (pid, &status, 0) == -1 || !WIFEXITED (status) || WEXITSTATUS (status) != 0)
+				throw TestFailed (SRC_POS);
+		}
+#endif
+	}
+
 	// shared_ptr, Mutex, ScopeLock, SyncEvent, Thread
 	static struct
 	{
@@ -344,6 +440,8 @@ namespace VeraCrypt
 			testList.pop_front();
 		}
 
+		IoBufferTest();
+		SecureMemoryTest();
 		SerializerTest();
 		ThreadTest();
 
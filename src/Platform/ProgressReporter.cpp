@@ -0,0 +1,132 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include <exception>
+#include "ProgressReporter.h"
+#include "Time.h"
+
+namespace VeraCrypt
+{
+	ProgressReporter::ProgressReporter (const string &operation, const wstring &subject, uint64 totalSize)
+		: Finished (false),
+		LastUpdateTime (0),
+		Operation (operation),
+		SizeDone (0),
+		StartTime (Time::GetMonotonic()),
+		Subject (subject),
+		TotalSize (totalSize),
+		UncaughtExceptionCount (GetUncaughtExceptionCount())
+	{
+		if (EventStream::IsEnabled())
+			EventStream::Emit ("start", GetFields());
+	}
+
+	ProgressReporter::~ProgressReporter ()
+	{
+		if (!Finished && EventStream::IsEnabled())
+		{
+			try
+			{
+				JsonObject fields = GetFields();
+				fields.Add ("status", GetUncaughtExceptionCount() > UncaughtExceptionCount ? "failed" : "aborted");
+				EventStream::Emit ("end", fields);
+			}
+			catch (...) { }
+		}
+	}
+
+	void ProgressReporter::Complete ()
+	{
+		Finished = true;
+
+		if (TotalSize > SizeDone)
+			SizeDone = TotalSize;
+
+		if (EventStream::IsEnabled())
+		{
+			JsonObject fields = GetFields();
+			fields.Add ("status", "ok");
+			EventStream::Emit ("end", fields);
+		}
+	}
+
+	void ProgressReporter::EmitProgress ()
+	{
+		LastUpdateTime = Time::GetMonotonic();
+		EventStream::Emit ("progress", GetFields());
+	}
+
+	void ProgressReporter::Fail (const wstring &message)
+	{
+		Finished = true;
+
+		if (EventStream::IsEnabled())
+		{
+			JsonObject fields = GetFields();
+			fields.Add ("status", "failed");
+			fields.Add ("error", message);
+			EventStream::Emit ("end", fields);
+		}
+	}
+
+	int ProgressReporter::GetUncaughtExceptionCount ()
+	{
+#if defined (__cpp_lib_uncaught_exceptions) && __cpp_lib_uncaught_exceptions >= 201411L
+		return std::uncaught_exceptions();
+#else
+		return std::uncaught_exception() ? 1 : 0;
+#endif
+	}
+
+	JsonObject ProgressReporter::GetFields () const
+	{
+		JsonObject fields;
+		fields.Add ("operation", Operation);
+
+		if (!Subject.empty())
+			fields.Add ("path", Subject);
+
+		if (!Phase.empty())
+			fields.Add ("phase", Phase);
+
+		double elapsed = (double) (Time::GetMonotonic() - StartTime) / 1000000000.0;
+
+		fields.Add ("bytes_done", SizeDone);
+		if (TotalSize != 0)
+			fields.Add ("bytes_total", TotalSize);
+
+		fields.Add ("elapsed_s", elapsed);
+
+		if (elapsed > 0 && SizeDone > 0)
+		{
+			double rate = (double) SizeDone / elapsed;
+			fields.Add ("rate_bps", rate);
+
+			if (TotalSize > SizeDone)
+				fields.Add ("eta_s", (double) (TotalSize - SizeDone) / rate);
+		}
+
+		return fields;
+	}
+
+	void ProgressReporter::SetPhase (const string &phase)
+	{
+		Phase = phase;
+
+		if (EventStream::IsEnabled())
+			EventStream::Emit ("phase", GetFields());
+	}
+
+	void ProgressReporter::Update (uint64 sizeDone)
+	{
+		SizeDone = sizeDone;
+
+		if (EventStream::IsEnabled() && Time::GetMonotonic() - LastUpdateTime >= UpdateInterval)
+			EmitProgress();
+	}
+}
@@ -0,0 +1,53 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Platform_ProgressReporter
+#define TC_HEADER_Platform_ProgressReporter
+
+#include "PlatformBase.h"
+#include "EventStream.h"
+
+namespace VeraCrypt
+{
+	// Reports the progress of a long-running operation to the event stream
+	class ProgressReporter
+	{
+	public:
+		ProgressReporter (const string &operation, const wstring &subject = wstring(), uint64 totalSize = 0);
+		virtual ~ProgressReporter ();
+
+		void Complete ();
+		void Fail (const wstring &message);
+		void SetPhase (const string &phase);
+		void SetTotalSize (uint64 totalSize) { TotalSize = totalSize; }
+		void Update (uint64 sizeDone);
+
+		static const uint64 UpdateInterval = 250ULL * 1000 * 1000; // Nanoseconds
+
+	protected:
+		void EmitProgress ();
+		JsonObject GetFields () const;
+		static int GetUncaughtExceptionCount ();
+
+		bool Finished;
+		uint64 LastUpdateTime;
+		string Operation;
+		string Phase;
+		uint64 SizeDone;
+		uint64 StartTime;
+		wstring Subject;
+		uint64 TotalSize;
+		int UncaughtExceptionCount;	// Exceptions in flight when the operation started
+
+	private:
+		ProgressReporter (const ProgressReporter &);
+		ProgressReporter &operator= (const ProgressReporter &);
+	};
+}
+
+#endif // TC_HEADER_Platform_ProgressReporter
@@ -0,0 +1,49 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include "RateLimiter.h"
+#include "Exception.h"
+#include "Thread.h"
+#include "Time.h"
+
+namespace VeraCrypt
+{
+	RateLimiter::RateLimiter (uint64 ratePerSecond)
+		: NextFreeTime (0), Rate (ratePerSecond)
+	{
+		if (ratePerSecond == 0)
+			throw ParameterIncorrect (SRC_POS);
+	}
+
+	void RateLimiter::Acquire (uint64 amount)
+	{
+		uint64 now = Time::GetMonotonic();
+		uint64 startTime;
+		{
+			ScopeLock lock (ReservationMutex);
+
+			// Unused time is not accumulated, which would otherwise allow bursts above the rate
+			if (NextFreeTime < now)
+				NextFreeTime = now;
+
+			startTime = NextFreeTime;
+			NextFreeTime += (uint64) ((double) amount * 1000000000.0 / (double) Rate);
+		}
+
+		if (startTime > now)
+		{
+			uint64 delay = (startTime - now) / 1000000;
+			while (delay > 0)
+			{
+				uint32 sleepTime = (uint32) (delay > 0xffffffffULL ? 0xffffffffULL : delay);
+				Thread::Sleep (sleepTime);
+				delay -= sleepTime;
+			}
+		}
+	}
+}
@@ -0,0 +1,39 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Platform_RateLimiter
+#define TC_HEADER_Platform_RateLimiter
+
+#include "PlatformBase.h"
+#include "Mutex.h"
+
+namespace VeraCrypt
+{
+	// Limits the combined rate of an activity shared by several threads. Each caller
+	// reserves the next free time slot for its amount and sleeps until the slot begins.
+	class RateLimiter
+	{
+	public:
+		RateLimiter (uint64 ratePerSecond);
+		virtual ~RateLimiter () { }
+
+		void Acquire (uint64 amount);
+		uint64 GetRate () const { return Rate; }
+
+	protected:
+		uint64 NextFreeTime;
+		uint64 Rate;
+		Mutex ReservationMutex;
+
+	private:
+		RateLimiter (const RateLimiter &);
+		RateLimiter &operator= (const RateLimiter &);
+	};
+}
+
+#endif // TC_HEADER_Platform_RateLimiter
@@ -0,0 +1,50 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Platform_SecureMemory
+#define TC_HEADER_Platform_SecureMemory
+
+#include "PlatformBase.h"
+
+namespace VeraCrypt
+{
+	struct SecureMemoryStatistics
+	{
+		SecureMemoryStatistics () : FallbackAllocationCount (0), FreeBlockCount (0), LargeAllocationCount (0), LockedBytes (0), LockFailureCount (0), SlabCount (0), UnlockedBytes (0) { }
+
+		uint64 FallbackAllocationCount;	// Allocations with an alignment larger than a page, served by the heap
+		uint64 FreeBlockCount;			// Blocks in the shared free lists, excluding thread caches
+		uint64 LargeAllocationCount;	// Allocations currently mapped individually
+		uint64 LockedBytes;
+		uint64 LockFailureCount;		// Mappings left unlocked because the RLIMIT_MEMLOCK budget ran out or mlock() failed
+		uint64 SlabCount;
+		uint64 UnlockedBytes;
+	};
+
+	// Process-wide arena for memory holding keys, passwords and other secrets. Small blocks are
+	// carved from slabs of power-of-two size classes, which are mapped, locked and excluded from
+	// core dumps once and reused through thread-local free lists. Blocks are zeroed when freed.
+	// The pages remain accessible to child processes, as the FUSE service forked by the core
+	// service uses the keys of the volume. When the locked memory budget is exhausted, memory
+	// is still provided but is not locked.
+	class SecureMemory
+	{
+	public:
+		static void *Allocate (size_t size, size_t alignment = 0);
+		static void Free (void *memory, size_t size, size_t alignment = 0);
+		static SecureMemoryStatistics GetStatistics ();
+
+		static const size_t MinBlockSize = 16;
+		static const size_t MaxBlockSize = 64 * 1024;
+
+	private:
+		SecureMemory ();
+	};
+}
+
+#endif // TC_HEADER_Platform_SecureMemory
@@ -126,10 +126,15 @@ namespace VeraCrypt
 	{
 		uint64 size = Deserialize <uint64> ();
 
-		vector <char> data ((size_t) size);
+		if (size == 0)
+			return string();
+
+		// Read directly into the string, which is truncated at the terminating null character
+		string data ((size_t) size, '\0');
 		DataStream->ReadCompleteBuffer (BufferPtr ((byte *) &data[0], (size_t) size));
+		data.resize (strlen (data.c_str()));
 
-		return string (&data[0]);
+		return data;
 	}
 
 	string Serializer::DeserializeString (const string &name)
@@ -154,10 +159,14 @@ namespace VeraCrypt
 	{
 		uint64 size = Deserialize <uint64> ();
 
-		vector <wchar_t> data ((size_t) size / sizeof (wchar_t));
+		if (size < sizeof (wchar_t) || size % sizeof (wchar_t) != 0)
+			throw ParameterIncorrect (SRC_POS);
+
+		wstring data ((size_t) size / sizeof (wchar_t), L'\0');
 		DataStream->ReadCompleteBuffer (BufferPtr ((byte *) &data[0], (size_t) size));
+		data.resize (wcslen (data.c_str()));
 
-		return wstring (&data[0]);
+		return data;
 	}
 
 	list <wstring> Serializer::DeserializeWStringList (const string &name)
@@ -181,11 +190,16 @@ namespace VeraCrypt
 	template <typename T>
 	void Serializer::Serialize (T data)
 	{
+		// The size and the value are written at once
+		byte encoded[sizeof (uint64) + sizeof (T)];
+
 		uint64 size = Endian::Big (uint64 (sizeof (data)));
-		DataStream->Write (ConstBufferPtr ((byte *) &size, sizeof (size)));
+		memcpy (encoded, &size, sizeof (size));
 
 		data = Endian::Big (data);
-		DataStream->Write (ConstBufferPtr ((byte *) &data, sizeof (data)));
+		memcpy (encoded + sizeof (size), &data, sizeof (data));
+
+		DataStream->Write (ConstBufferPtr (encoded, sizeof (encoded)));
 	}
 
 	void Serializer::Serialize (const string &name, bool data)
@@ -294,10 +308,19 @@ namespace VeraCrypt
 
 	void Serializer::ValidateName (const string &name)
 	{
-		string dName = DeserializeString();
-		if (dName != name)
-		{
+		uint64 size = Deserialize <uint64> ();
+		if (size != name.size() + 1)
 			throw ParameterIncorrect (SRC_POS);
+
+		// The name is compared in place, including its terminating null character, without allocating a string
+		byte chunk[64];
+		for (size_t pos = 0; pos < size; pos += sizeof (chunk))
+		{
+			size_t length = (size_t) size - pos < sizeof (chunk) ? (size_t) size - pos : sizeof (chunk);
+			DataStream->ReadCompleteBuffer (BufferPtr (chunk, length));
+
+			if (memcmp (chunk, name.c_str() + pos, length) != 0)
+				throw ParameterIncorrect (SRC_POS);
 		}
 	}
 }
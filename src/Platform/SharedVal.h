@@ -13,58 +13,54 @@
 #ifndef TC_HEADER_Platform_SharedVal
 #define TC_HEADER_Platform_SharedVal
 
+#include <atomic>
+#include <type_traits>
 #include "PlatformBase.h"
-#include "Mutex.h"
 
 namespace VeraCrypt
 {
+	// Value shared between threads, which is accessed without locking. A value stored by Set()
+	// is published together with all writes made by the storing thread before the call (release),
+	// which become visible to a thread reading the value by Get() (acquire). Increment() and
+	// Decrement() are available for integral types only. T must be trivially copyable.
 	template <class T>
 	class SharedVal
 	{
+#if !defined (__GNUC__) || defined (__clang__) || __GNUC__ >= 5
+		static_assert (std::is_trivially_copyable <T>::value, "SharedVal requires a trivially copyable type");
+#endif
 	public:
 		SharedVal () { }
 		explicit SharedVal (T value) : Value (value) { }
 		virtual ~SharedVal () { }
 
-		operator T ()
+		operator T () const
 		{
 			return Get ();
 		}
 
 		T Decrement ()
 		{
-			ValMutex.Lock();
-			T r = --Value;
-			ValMutex.Unlock();
-			return r;
+			return Value.fetch_sub (1, std::memory_order_acq_rel) - 1;
 		}
 
-		T Get ()
+		T Get () const
 		{
-			ValMutex.Lock();
-			T r = Value;
-			ValMutex.Unlock();
-			return r;
+			return Value.load (std::memory_order_acquire);
 		}
 
 		T Increment ()
 		{
-			ValMutex.Lock();
-			T r = ++Value;
-			ValMutex.Unlock();
-			return r;
+			return Value.fetch_add (1, std::memory_order_acq_rel) + 1;
 		}
 
 		void Set (T value)
 		{
-			ValMutex.Lock();
-			Value = value;
-			ValMutex.Unlock();
+			Value.store (value, std::memory_order_release);
 		}
 
 	protected:
-		volatile T Value;
-		Mutex ValMutex;
+		std::atomic <T> Value;
 
 	private:
 		SharedVal (const SharedVal &);
@@ -0,0 +1,62 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include <iomanip>
+#include "ForEach.h"
+#include "StartupProfiler.h"
+#include "Time.h"
+
+namespace VeraCrypt
+{
+	void StartupProfiler::Enable ()
+	{
+		ScopeLock lock (PhasesMutex);
+		Phases.clear();
+		StartTime = Time::GetMonotonic();
+		Enabled = true;
+	}
+
+	string StartupProfiler::GetReport ()
+	{
+		ScopeLock lock (PhasesMutex);
+
+		stringstream report;
+		report << fixed << setprecision (2);
+		report << "   phase (ms)    total (ms)  phase" << endl;
+
+		uint64 previousTime = StartTime;
+		foreach (const Phase &phase, Phases)
+		{
+			report << setw (13) << (double) (phase.Time - previousTime) / 1000000.0
+				<< " " << setw (13) << (double) (phase.Time - StartTime) / 1000000.0
+				<< "  " << phase.Name << endl;
+
+			previousTime = phase.Time;
+		}
+
+		return report.str();
+	}
+
+	void StartupProfiler::Mark (const string &phase)
+	{
+		if (!Enabled)
+			return;
+
+		Phase p;
+		p.Name = phase;
+		p.Time = Time::GetMonotonic();
+
+		ScopeLock lock (PhasesMutex);
+		Phases.push_back (p);
+	}
+
+	volatile bool StartupProfiler::Enabled = false;
+	list <StartupProfiler::Phase> StartupProfiler::Phases;
+	Mutex StartupProfiler::PhasesMutex;
+	uint64 StartupProfiler::StartTime = 0;
+}
@@ -0,0 +1,44 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Platform_StartupProfiler
+#define TC_HEADER_Platform_StartupProfiler
+
+#include "PlatformBase.h"
+#include "Mutex.h"
+
+namespace VeraCrypt
+{
+	// Records the time at which the phases of application startup complete.
+	// Marks are ignored unless profiling has been enabled.
+	class StartupProfiler
+	{
+	public:
+		static void Enable ();
+		static string GetReport ();
+		static bool IsEnabled () { return Enabled; }
+		static void Mark (const string &phase);
+
+	protected:
+		struct Phase
+		{
+			string Name;
+			uint64 Time;
+		};
+
+		static volatile bool Enabled;
+		static list <Phase> Phases;
+		static Mutex PhasesMutex;
+		static uint64 StartTime;
+
+	private:
+		StartupProfiler ();
+	};
+}
+
+#endif // TC_HEADER_Platform_StartupProfiler
@@ -0,0 +1,37 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Platform_Tracepoint
+#define TC_HEADER_Platform_Tracepoint
+
+// Static tracepoints for dynamic tracing tools (bpftrace, perf, SystemTap). They are
+// compiled in only when TC_USDT is defined (make USDT=1), in which case each probe is
+// a single nop instruction until a tracer attaches to it. Arguments of a disabled
+// probe are not evaluated. Example scripts are located in Build/Tracing.
+
+#ifdef TC_USDT
+
+#include <sys/sdt.h>
+
+#define TC_TRACE(probe) DTRACE_PROBE (veracrypt, probe)
+#define TC_TRACE1(probe, arg1) DTRACE_PROBE1 (veracrypt, probe, arg1)
+#define TC_TRACE2(probe, arg1, arg2) DTRACE_PROBE2 (veracrypt, probe, arg1, arg2)
+#define TC_TRACE3(probe, arg1, arg2, arg3) DTRACE_PROBE3 (veracrypt, probe, arg1, arg2, arg3)
+#define TC_TRACE4(probe, arg1, arg2, arg3, arg4) DTRACE_PROBE4 (veracrypt, probe, arg1, arg2, arg3, arg4)
+
+#else
+
+#define TC_TRACE(probe)
+#define TC_TRACE1(probe, arg1)
+#define TC_TRACE2(probe, arg1, arg2)
+#define TC_TRACE3(probe, arg1, arg2, arg3)
+#define TC_TRACE4(probe, arg1, arg2, arg3, arg4)
+
+#endif
+
+#endif // TC_HEADER_Platform_Tracepoint
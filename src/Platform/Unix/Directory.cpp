@@ -17,6 +17,7 @@
 #include "System.h"
 #include "Platform/Directory.h"
 #include "Platform/Finally.h"
+#include "Platform/Mutex.h"
 #include "Platform/SystemException.h"
 
 namespace VeraCrypt
@@ -0,0 +1,61 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include <errno.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "Platform/EventStream.h"
+
+namespace VeraCrypt
+{
+	void EventStream::Emit (const string &eventName, const JsonObject &fields)
+	{
+		if (!IsEnabled())
+			return;
+
+		struct timeval tv;
+		gettimeofday (&tv, nullptr);
+
+		JsonObject event;
+		event.Add ("event", eventName);
+		event.Add ("time_ms", (uint64) tv.tv_sec * 1000 + (uint64) tv.tv_usec / 1000);
+		event.Append (fields);
+
+		string line = event.ToString() + "\n";
+
+		ScopeLock lock (WriteMutex);
+		if (FileDescriptor == -1)
+			return;
+
+		size_t written = 0;
+		while (written < line.size())
+		{
+			ssize_t len = write (FileDescriptor, line.c_str() + written, line.size() - written);
+			if (len == -1)
+			{
+				if (errno == EINTR)
+					continue;
+
+				// The reader has gone away; events are not essential
+				FileDescriptor = -1;
+				return;
+			}
+
+			written += len;
+		}
+	}
+
+	void EventStream::SetFileDescriptor (int fd)
+	{
+		ScopeLock lock (WriteMutex);
+		FileDescriptor = fd;
+	}
+
+	volatile int EventStream::FileDescriptor = -1;
+	Mutex EventStream::WriteMutex;
+}
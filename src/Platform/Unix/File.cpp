@@ -94,6 +94,16 @@ namespace VeraCrypt
 		throw_sys_sub_if (fsync (FileHandle) != 0, wstring (Path));
 	}
 
+	uint64 File::GetAllocatedSize () const
+	{
+		if_debug (ValidateState());
+
+		struct stat statData;
+		throw_sys_sub_if (fstat (FileHandle, &statData) == -1, wstring (Path));
+
+		return (uint64) statData.st_blocks * 512;
+	}
+
 	uint32 File::GetDeviceSectorSize () const
 	{
 		if (Path.IsDevice())
@@ -282,6 +292,24 @@ namespace VeraCrypt
 		FileIsOpen = true;
 	}
 
+	void File::PunchHole (uint64 position, uint64 length) const
+	{
+		if_debug (ValidateState());
+
+#if defined (TC_LINUX) && defined (FALLOC_FL_PUNCH_HOLE)
+		throw_sys_sub_if (fallocate (FileHandle, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, position, length) == -1, wstring (Path));
+#elif defined (TC_MACOSX) && defined (F_PUNCHHOLE)
+		struct fpunchhole punchHole;
+		Memory::Zero (&punchHole, sizeof (punchHole));
+		punchHole.fp_offset = position;
+		punchHole.fp_length = length;
+
+		throw_sys_sub_if (fcntl (FileHandle, F_PUNCHHOLE, &punchHole) == -1, wstring (Path));
+#else
+		throw NotImplemented (SRC_POS);
+#endif
+	}
+
 	uint64 File::Read (const BufferPtr &buffer) const
 	{
 		if_debug (ValidateState());
@@ -314,6 +342,25 @@ namespace VeraCrypt
 		throw_sys_sub_if (lseek (FileHandle, position, SEEK_SET) == -1, wstring (Path));
 	}
 
+	uint64 File::SeekData (uint64 position) const
+	{
+		if_debug (ValidateState());
+
+#ifdef SEEK_DATA
+		off_t offset = lseek (FileHandle, position, SEEK_DATA);
+		if (offset != -1)
+			return offset;
+
+		// No data follows the position
+		if (errno == ENXIO)
+			return Length();
+
+		// Filesystem does not support sparse file queries
+		throw_sys_sub_if (errno != EINVAL, wstring (Path));
+#endif
+		return position;
+	}
+
 	void File::SeekEnd (int offset) const
 	{
 		if_debug (ValidateState());
@@ -330,6 +377,26 @@ namespace VeraCrypt
 		throw_sys_sub_if (lseek (FileHandle, offset, SEEK_END) == -1, wstring (Path));
 	}
 
+	uint64 File::SeekHole (uint64 position) const
+	{
+		if_debug (ValidateState());
+
+#ifdef SEEK_HOLE
+		off_t offset = lseek (FileHandle, position, SEEK_HOLE);
+		if (offset != -1)
+			return offset;
+
+		throw_sys_sub_if (errno != EINVAL && errno != ENXIO, wstring (Path));
+#endif
+		return Length();
+	}
+
+	void File::SetLength (uint64 length) const
+	{
+		if_debug (ValidateState());
+		throw_sys_sub_if (ftruncate (FileHandle, length) == -1, wstring (Path));
+	}
+
 	void File::Write (const ConstBufferPtr &buffer) const
 	{
 		if_debug (ValidateState());
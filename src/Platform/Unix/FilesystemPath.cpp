@@ -56,6 +56,11 @@ namespace VeraCrypt
 		return FilesystemPathType::Unknown;
 	}
 
+	void FilesystemPath::Rename (const FilesystemPath &newPath) const
+	{
+		throw_sys_sub_if (rename (string (*this).c_str(), string (newPath).c_str()) == -1, Path);
+	}
+
 	FilesystemPath FilesystemPath::ToBaseName () const
 	{
 		wstring path = Path;
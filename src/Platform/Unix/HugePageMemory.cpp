@@ -0,0 +1,115 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "Platform/Exception.h"
+#include "Platform/HugePageMemory.h"
+
+namespace VeraCrypt
+{
+	static size_t ReadHugePageSize ()
+	{
+#ifdef TC_LINUX
+		FILE *meminfo = fopen ("/proc/meminfo", "r");
+		if (!meminfo)
+			return 0;
+
+		size_t hugePageSize = 0;
+		char line[128];
+		unsigned long sizeKiB;
+
+		while (fgets (line, sizeof (line), meminfo))
+		{
+			if (sscanf (line, "Hugepagesize: %lu kB", &sizeKiB) == 1)
+			{
+				hugePageSize = (size_t) sizeKiB * 1024;
+				break;
+			}
+		}
+
+		fclose (meminfo);
+		return hugePageSize;
+#else
+		return 0;
+#endif
+	}
+
+	void *HugePageMemory::Allocate (size_t size, bool explicitHugePages)
+	{
+		if (size < 1)
+			throw ParameterIncorrect (SRC_POS);
+
+		size_t mapSize = GetMappedSize (size);
+		size_t hugePageSize = GetHugePageSize();
+
+		if (hugePageSize == 0 || size < hugePageSize)
+		{
+			void *memory = mmap (nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+			if (memory == MAP_FAILED)
+				throw bad_alloc();
+
+			return memory;
+		}
+
+#ifdef MAP_HUGETLB
+		// Fails unless huge pages have been reserved (vm.nr_hugepages)
+		if (explicitHugePages)
+		{
+			void *memory = mmap (nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON | MAP_HUGETLB, -1, 0);
+			if (memory != MAP_FAILED)
+				return memory;
+		}
+#endif
+
+		// Transparent huge pages can only back regions aligned to the huge page size
+		byte *region = static_cast <byte *> (mmap (nullptr, mapSize + hugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0));
+		if (region == MAP_FAILED)
+			throw bad_alloc();
+
+		byte *aligned = region + (hugePageSize - (size_t) region % hugePageSize) % hugePageSize;
+
+		if (aligned > region)
+			munmap (region, aligned - region);
+
+		if (aligned + mapSize < region + mapSize + hugePageSize)
+			munmap (aligned + mapSize, region + mapSize + hugePageSize - (aligned + mapSize));
+
+#ifdef MADV_HUGEPAGE
+		madvise (aligned, mapSize, MADV_HUGEPAGE);
+#endif
+		return aligned;
+	}
+
+	void HugePageMemory::Free (void *memory, size_t size)
+	{
+		assert (memory != nullptr);
+		munmap (memory, GetMappedSize (size));
+	}
+
+	size_t HugePageMemory::GetHugePageSize ()
+	{
+		static const size_t hugePageSize = ReadHugePageSize();
+		return hugePageSize;
+	}
+
+	size_t HugePageMemory::GetMappedSize (size_t size)
+	{
+		size_t hugePageSize = GetHugePageSize();
+		size_t granularity = (hugePageSize != 0 && size >= hugePageSize) ? hugePageSize : GetPageSize();
+
+		return (size + granularity - 1) / granularity * granularity;
+	}
+
+	size_t HugePageMemory::GetPageSize ()
+	{
+		long pageSize = sysconf (_SC_PAGESIZE);
+		return pageSize > 0 ? (size_t) pageSize : 4096;
+	}
+}
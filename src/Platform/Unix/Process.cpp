@@ -12,11 +12,13 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <spawn.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include "Process.h"
 #include "Platform/Exception.h"
+#include "Platform/Finally.h"
 #include "Platform/FileStream.h"
 #include "Platform/ForEach.h"
 #include "Platform/MemoryStream.h"
@@ -25,6 +27,13 @@
 #include "Platform/Unix/Pipe.h"
 #include "Platform/Unix/Poller.h"
 
+#ifdef TC_MACOSX
+#	include <crt_externs.h>
+#	define environ (*_NSGetEnviron())
+#else
+extern char **environ;
+#endif
+
 namespace VeraCrypt
 {
 	string Process::Execute (const string &processName, const list <string> &arguments, int timeOut, ProcessExecFunctor *execFunctor, const Buffer *inputData)
@@ -41,77 +50,116 @@ namespace VeraCrypt
 		trace_msg (dbg.str());
 #endif
 
-		Pipe inPipe, outPipe, errPipe, exceptionPipe;
+		int argIndex = 0;
+		if (!execFunctor)
+			args[argIndex++] = const_cast <char*> (processName.c_str());
+
+		for (list<string>::const_iterator it = arguments.begin(); it != arguments.end(); it++)
+		{
+			args[argIndex++] = const_cast <char*> (it->c_str());
+		}
+		args[argIndex] = nullptr;
 
-		int forkedPid = fork();
-		throw_sys_if (forkedPid == -1);
+		Pipe inPipe, outPipe, errPipe, exceptionPipe;
+		int forkedPid;
 
-		if (forkedPid == 0)
+		if (execFunctor)
 		{
-			try
+			// The functor runs in a copy of this process
+			forkedPid = fork();
+			throw_sys_if (forkedPid == -1);
+
+			if (forkedPid == 0)
 			{
 				try
 				{
-					int argIndex = 0;
-					if (!execFunctor)
-						args[argIndex++] = const_cast <char*> (processName.c_str());
-
-					for (list<string>::const_iterator it = arguments.begin(); it != arguments.end(); it++)
+					try
 					{
-						args[argIndex++] = const_cast <char*> (it->c_str());
-					}
-					args[argIndex] = nullptr;
+						if (inputData)
+						{
+							throw_sys_if (dup2 (inPipe.GetReadFD(), STDIN_FILENO) == -1);
+						}
+						else
+						{
+							inPipe.Close();
+							int nullDev = open ("/dev/null", 0);
+							throw_sys_sub_if (nullDev == -1, "/dev/null");
+							throw_sys_if (dup2 (nullDev, STDIN_FILENO) == -1);
+						}
+
+						throw_sys_if (dup2 (outPipe.GetWriteFD(), STDOUT_FILENO) == -1);
+						throw_sys_if (dup2 (errPipe.GetWriteFD(), STDERR_FILENO) == -1);
+						exceptionPipe.GetWriteFD();
 
-					if (inputData)
-					{
-						throw_sys_if (dup2 (inPipe.GetReadFD(), STDIN_FILENO) == -1);
+						(*execFunctor)(argIndex, args);
 					}
-					else
+					catch (Exception &)
 					{
-						inPipe.Close();
-						int nullDev = open ("/dev/null", 0);
-						throw_sys_sub_if (nullDev == -1, "/dev/null");
-						throw_sys_if (dup2 (nullDev, STDIN_FILENO) == -1);
+						throw;
 					}
-
-					throw_sys_if (dup2 (outPipe.GetWriteFD(), STDOUT_FILENO) == -1);
-					throw_sys_if (dup2 (errPipe.GetWriteFD(), STDERR_FILENO) == -1);
-					exceptionPipe.GetWriteFD();
-
-					if (execFunctor)
+					catch (exception &e)
 					{
-						(*execFunctor)(argIndex, args);
+						throw ExternalException (SRC_POS, StringConverter::ToExceptionString (e));
 					}
-					else
+					catch (...)
 					{
-						execvp (args[0], args);
-						throw SystemException (SRC_POS, args[0]);
+						throw UnknownException (SRC_POS);
 					}
 				}
-				catch (Exception &)
+				catch (Exception &e)
 				{
-					throw;
-				}
-				catch (exception &e)
-				{
-					throw ExternalException (SRC_POS, StringConverter::ToExceptionString (e));
-				}
-				catch (...)
-				{
-					throw UnknownException (SRC_POS);
+					try
+					{
+						shared_ptr <Stream> outputStream (new FileStream (exceptionPipe.GetWriteFD()));
+						e.Serialize (outputStream);
+					}
+					catch (...) { }
 				}
+
+				_exit (1);
 			}
-			catch (Exception &e)
+		}
+		else
+		{
+			// Unlike fork(), posix_spawn() does not copy the page tables of this process, which may be large
+			// and are copied while other threads keep running. Failures to execute the program are returned
+			// by posix_spawnp() where supported, or otherwise reported by the exit code 127.
+			posix_spawn_file_actions_t fileActions;
+			throw_sys_if ((errno = posix_spawn_file_actions_init (&fileActions)) != 0);
+			finally_do_arg (posix_spawn_file_actions_t *, &fileActions, { posix_spawn_file_actions_destroy (finally_arg); });
+
+			int inReadFD = inPipe.PeekReadFD();
+			int inWriteFD = inPipe.PeekWriteFD();
+			int outWriteFD = outPipe.PeekWriteFD();
+			int errWriteFD = errPipe.PeekWriteFD();
+
+			if (inputData)
+				throw_sys_if ((errno = posix_spawn_file_actions_adddup2 (&fileActions, inReadFD, STDIN_FILENO)) != 0);
+			else
+				throw_sys_if ((errno = posix_spawn_file_actions_addopen (&fileActions, STDIN_FILENO, "/dev/null", O_RDONLY, 0)) != 0);
+
+			throw_sys_if ((errno = posix_spawn_file_actions_adddup2 (&fileActions, outWriteFD, STDOUT_FILENO)) != 0);
+			throw_sys_if ((errno = posix_spawn_file_actions_adddup2 (&fileActions, errWriteFD, STDERR_FILENO)) != 0);
+
+			int pipeFDs[] = { inReadFD, inWriteFD, outWriteFD, errWriteFD };
+			for (size_t i = 0; i < array_capacity (pipeFDs); ++i)
 			{
-				try
-				{
-					shared_ptr <Stream> outputStream (new FileStream (exceptionPipe.GetWriteFD()));
-					e.Serialize (outputStream);
-				}
-				catch (...) { }
+				if (pipeFDs[i] > STDERR_FILENO)
+					throw_sys_if ((errno = posix_spawn_file_actions_addclose (&fileActions, pipeFDs[i])) != 0);
+			}
+
+			int spawnResult = posix_spawnp (&forkedPid, args[0], &fileActions, nullptr, args, environ);
+			if (spawnResult != 0)
+			{
+				errno = spawnResult;
+				throw SystemException (SRC_POS, args[0]);
 			}
 
-			_exit (1);
+			// The ends used by the child are closed, which also ends the exception pipe that is not used
+			inPipe.GetWriteFD();
+			outPipe.GetReadFD();
+			errPipe.GetReadFD();
+			exceptionPipe.GetReadFD();
 		}
 
 		throw_sys_if (fcntl (outPipe.GetReadFD(), F_SETFL, O_NONBLOCK) == -1);
@@ -175,7 +223,7 @@ namespace VeraCrypt
 
 			try
 			{
-				shared_ptr <Stream> stream (new MemoryStream (ConstBufferPtr ((byte *) &exOutput[0], exOutput.size())));
+				shared_ptr <Stream> stream (new MemoryReadStream (ConstBufferPtr ((byte *) &exOutput[0], exOutput.size())));
 				deserializedObject.reset (Serializable::DeserializeNew (stream));
 				deserializedException = dynamic_cast <Exception*> (deserializedObject.get());
 			}
@@ -0,0 +1,289 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include "Platform/Exception.h"
+#include "Platform/HugePageMemory.h"
+#include "Platform/Memory.h"
+#include "Platform/Mutex.h"
+#include "Platform/SecureMemory.h"
+
+namespace VeraCrypt
+{
+	static const size_t SecureMemorySizeClassCount = 13;	// MinBlockSize to MaxBlockSize
+	static const size_t SecureMemoryThreadCacheCapacity = 16;
+
+	struct SecureMemoryThreadCache
+	{
+		SecureMemoryThreadCache () { Memory::Zero (BlockCount, sizeof (BlockCount)); }
+
+		void *Blocks[SecureMemorySizeClassCount][SecureMemoryThreadCacheCapacity];
+		size_t BlockCount[SecureMemorySizeClassCount];
+	};
+
+	// Never destroyed, as blocks may be freed by destructors of static objects at exit
+	struct SecureMemoryArena
+	{
+		SecureMemoryArena ();
+
+		void *Map (size_t size, bool hugePages = false);
+		void Refill (SecureMemoryThreadCache &cache, size_t sizeClass);
+		void Release (SecureMemoryThreadCache &cache, size_t sizeClass, size_t blockCount);
+
+		Mutex ArenaMutex;
+		vector <void *> FreeBlocks[SecureMemorySizeClassCount];
+		map <void *, bool> LargeAllocations;	// Locked state, by address
+		uint64 LockLimit;
+		size_t PageSize;
+		SecureMemoryStatistics Statistics;
+		pthread_key_t ThreadCacheKey;
+	};
+
+	static SecureMemoryArena &GetArena ();
+
+	static __thread SecureMemoryThreadCache *ThreadCache = nullptr;
+
+	static void FreeThreadCache (void *cachePtr)
+	{
+		SecureMemoryThreadCache *cache = static_cast <SecureMemoryThreadCache *> (cachePtr);
+
+		for (size_t i = 0; i < SecureMemorySizeClassCount; ++i)
+			GetArena().Release (*cache, i, cache->BlockCount[i]);
+
+		ThreadCache = nullptr;
+		delete cache;
+	}
+
+	static void LockArena () { GetArena().ArenaMutex.Lock(); }
+	static void UnlockArena () { GetArena().ArenaMutex.Unlock(); }
+
+	// The mutex is owned by a thread of the parent process and cannot be unlocked by the child
+	static void ResetArenaLock () { new (&GetArena().ArenaMutex) Mutex; }
+
+	SecureMemoryArena::SecureMemoryArena () : LockLimit (0)
+	{
+		long pageSize = sysconf (_SC_PAGESIZE);
+		PageSize = pageSize > 0 ? (size_t) pageSize : 4096;
+
+		struct rlimit limit;
+		if (geteuid() == 0 || (getrlimit (RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur == RLIM_INFINITY))
+			LockLimit = 0xffffFFFFffffFFFFULL;
+		else if (getrlimit (RLIMIT_MEMLOCK, &limit) == 0)
+			LockLimit = limit.rlim_cur;
+
+		if (pthread_key_create (&ThreadCacheKey, FreeThreadCache) != 0)
+			throw bad_alloc();
+	}
+
+	void *SecureMemoryArena::Map (size_t size, bool hugePages)
+	{
+		void *memory;
+
+		if (hugePages)
+		{
+			memory = HugePageMemory::Allocate (size, false);
+			size = HugePageMemory::GetMappedSize (size);
+		}
+		else
+		{
+			memory = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+			if (memory == MAP_FAILED)
+				throw bad_alloc();
+		}
+
+		// Failures are ignored, as the advice is not supported by all kernels
+#if defined (MADV_DONTDUMP)
+		madvise (memory, size, MADV_DONTDUMP);
+#elif defined (MADV_NOCORE)
+		madvise (memory, size, MADV_NOCORE);
+#endif
+
+		if (Statistics.LockedBytes + size <= LockLimit && mlock (memory, size) == 0)
+		{
+			Statistics.LockedBytes += size;
+		}
+		else
+		{
+			Statistics.UnlockedBytes += size;
+			++Statistics.LockFailureCount;
+		}
+
+		return memory;
+	}
+
+	void SecureMemoryArena::Refill (SecureMemoryThreadCache &cache, size_t sizeClass)
+	{
+		ScopeLock lock (ArenaMutex);
+		vector <void *> &freeBlocks = FreeBlocks[sizeClass];
+
+		if (freeBlocks.empty())
+		{
+			size_t blockSize = SecureMemory::MinBlockSize << sizeClass;
+			size_t slabSize = blockSize * 4 > PageSize ? blockSize * 4 : PageSize;
+
+			byte *slab = static_cast <byte *> (Map (slabSize));
+			++Statistics.SlabCount;
+
+			for (size_t offset = slabSize; offset > 0; offset -= blockSize)
+				freeBlocks.push_back (slab + offset - blockSize);
+		}
+
+		while (!freeBlocks.empty() && cache.BlockCount[sizeClass] < SecureMemoryThreadCacheCapacity / 2)
+		{
+			cache.Blocks[sizeClass][cache.BlockCount[sizeClass]++] = freeBlocks.back();
+			freeBlocks.pop_back();
+		}
+	}
+
+	void SecureMemoryArena::Release (SecureMemoryThreadCache &cache, size_t sizeClass, size_t blockCount)
+	{
+		ScopeLock lock (ArenaMutex);
+
+		while (blockCount-- > 0 && cache.BlockCount[sizeClass] > 0)
+			FreeBlocks[sizeClass].push_back (cache.Blocks[sizeClass][--cache.BlockCount[sizeClass]]);
+	}
+
+	static SecureMemoryArena &GetArena ()
+	{
+		static SecureMemoryArena *arena = nullptr;
+		static pthread_once_t arenaInitialized = PTHREAD_ONCE_INIT;
+
+		struct Initializer
+		{
+			static void Initialize ()
+			{
+				arena = new SecureMemoryArena;
+
+				// The arena must not remain locked in a child process forked while another thread held the lock
+				pthread_atfork (LockArena, UnlockArena, ResetArenaLock);
+			}
+		};
+
+		pthread_once (&arenaInitialized, Initializer::Initialize);
+		return *arena;
+	}
+
+	static size_t GetSizeClass (size_t size)
+	{
+		size_t sizeClass = 0;
+		for (size_t blockSize = SecureMemory::MinBlockSize; blockSize < size; blockSize <<= 1)
+			++sizeClass;
+
+		return sizeClass;
+	}
+
+	static SecureMemoryThreadCache &GetThreadCache (SecureMemoryArena &arena)
+	{
+		if (!ThreadCache)
+		{
+			ThreadCache = new SecureMemoryThreadCache;
+			pthread_setspecific (arena.ThreadCacheKey, ThreadCache);
+		}
+
+		return *ThreadCache;
+	}
+
+	void *SecureMemory::Allocate (size_t size, size_t alignment)
+	{
+		if (size < 1)
+			throw ParameterIncorrect (SRC_POS);
+
+		SecureMemoryArena &arena = GetArena();
+
+		if (alignment > arena.PageSize)
+		{
+			ScopeLock lock (arena.ArenaMutex);
+			++arena.Statistics.FallbackAllocationCount;
+			return Memory::AllocateAligned (size, alignment);
+		}
+
+		size_t blockSize = size > alignment ? size : alignment;
+
+		if (blockSize > MaxBlockSize)
+		{
+			ScopeLock lock (arena.ArenaMutex);
+			uint64 lockedBytes = arena.Statistics.LockedBytes;
+
+			// Multi-megabyte buffers of the bulk I/O paths are backed by transparent huge pages
+			void *memory = arena.Map (size, true);
+			arena.LargeAllocations[memory] = arena.Statistics.LockedBytes != lockedBytes;
+			arena.Statistics.LargeAllocationCount = arena.LargeAllocations.size();
+
+			return memory;
+		}
+
+		// Blocks are aligned to their size up to the page size, which satisfies any smaller alignment
+		size_t sizeClass = GetSizeClass (blockSize);
+		SecureMemoryThreadCache &cache = GetThreadCache (arena);
+
+		if (cache.BlockCount[sizeClass] == 0)
+			arena.Refill (cache, sizeClass);
+
+		return cache.Blocks[sizeClass][--cache.BlockCount[sizeClass]];
+	}
+
+	void SecureMemory::Free (void *memory, size_t size, size_t alignment)
+	{
+		assert (memory != nullptr);
+		burn (memory, size);
+
+		SecureMemoryArena &arena = GetArena();
+
+		if (alignment > arena.PageSize)
+		{
+			Memory::FreeAligned (memory);
+			return;
+		}
+
+		size_t blockSize = size > alignment ? size : alignment;
+
+		if (blockSize > MaxBlockSize)
+		{
+			size_t mapSize = HugePageMemory::GetMappedSize (size);
+
+			ScopeLock lock (arena.ArenaMutex);
+			map <void *, bool>::iterator allocation = arena.LargeAllocations.find (memory);
+			if (allocation == arena.LargeAllocations.end())
+				throw ParameterIncorrect (SRC_POS);
+
+			if (allocation->second)
+				arena.Statistics.LockedBytes -= mapSize;
+			else
+				arena.Statistics.UnlockedBytes -= mapSize;
+
+			arena.LargeAllocations.erase (allocation);
+			arena.Statistics.LargeAllocationCount = arena.LargeAllocations.size();
+
+			HugePageMemory::Free (memory, size);
+			return;
+		}
+
+		size_t sizeClass = GetSizeClass (blockSize);
+		SecureMemoryThreadCache &cache = GetThreadCache (arena);
+
+		if (cache.BlockCount[sizeClass] == SecureMemoryThreadCacheCapacity)
+			arena.Release (cache, sizeClass, SecureMemoryThreadCacheCapacity / 2);
+
+		cache.Blocks[sizeClass][cache.BlockCount[sizeClass]++] = memory;
+	}
+
+	SecureMemoryStatistics SecureMemory::GetStatistics ()
+	{
+		SecureMemoryArena &arena = GetArena();
+		ScopeLock lock (arena.ArenaMutex);
+
+		SecureMemoryStatistics statistics = arena.Statistics;
+		for (size_t i = 0; i < SecureMemorySizeClassCount; ++i)
+			statistics.FreeBlockCount += arena.FreeBlocks[i].size();
+
+		return statistics;
+	}
+}
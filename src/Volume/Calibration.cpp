@@ -0,0 +1,317 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include <algorithm>
+#include <math.h>
+#include <time.h>
+#include "Platform/Time.h"
+#include "Common/Crypto.h"
+#include "Calibration.h"
+#include "CryptoBenchmark.h"
+#include "EncryptionThreadPool.h"
+#include "VolumePassword.h"
+
+namespace VeraCrypt
+{
+	void Calibration::Apply (const CalibrationData &data)
+	{
+		ScopeLock lock (DataMutex);
+		Data = data;
+		Calibrated = true;
+
+		EncryptionThreadPool::SetMinFragmentSize (data.MinFragmentSize);
+	}
+
+	void CalibrationData::Deserialize (Serializer &sr, const string &name)
+	{
+		CipherSpeeds.clear();
+		DeviceLatencies.clear();
+		KdfIterationTimes.clear();
+
+		sr.Deserialize (name + "CpuCount", CpuCount);
+		MinFragmentSize = (size_t) sr.DeserializeUInt64 (name + "MinFragmentSize");
+		sr.Deserialize (name + "Time", Time);
+
+		// Speeds and times are transferred as integers in bytes per second and picoseconds
+		uint64 count = sr.DeserializeUInt64 (name + "CipherSpeedCount");
+		for (uint64 i = 0; i < count; ++i)
+		{
+			CalibrationCipherSpeed speed;
+			speed.Algorithm = sr.DeserializeWString (name + "CipherAlgorithm");
+			speed.BufferSize = (size_t) sr.DeserializeUInt64 (name + "CipherBufferSize");
+			speed.Speed = (double) sr.DeserializeUInt64 (name + "CipherSpeed");
+			speed.ThreadCount = (size_t) sr.DeserializeUInt64 (name + "CipherThreadCount");
+			CipherSpeeds.push_back (speed);
+		}
+
+		count = sr.DeserializeUInt64 (name + "DeviceLatencyCount");
+		for (uint64 i = 0; i < count; ++i)
+		{
+			wstring path = sr.DeserializeWString (name + "DevicePath");
+			DeviceLatencies[path] = sr.DeserializeUInt64 (name + "DeviceLatency");
+		}
+
+		count = sr.DeserializeUInt64 (name + "KdfCount");
+		for (uint64 i = 0; i < count; ++i)
+		{
+			wstring kdf = sr.DeserializeWString (name + "KdfName");
+			KdfIterationTimes[kdf] = sr.DeserializeUInt64 (name + "KdfIterationTime") / 1000.0;
+		}
+	}
+
+	void CalibrationData::Serialize (Serializer &sr, const string &name) const
+	{
+		sr.Serialize (name + "CpuCount", CpuCount);
+		sr.Serialize (name + "MinFragmentSize", (uint64) MinFragmentSize);
+		sr.Serialize (name + "Time", Time);
+
+		sr.Serialize (name + "CipherSpeedCount", (uint64) CipherSpeeds.size());
+		foreach (const CalibrationCipherSpeed &speed, CipherSpeeds)
+		{
+			sr.Serialize (name + "CipherAlgorithm", speed.Algorithm);
+			sr.Serialize (name + "CipherBufferSize", (uint64) speed.BufferSize);
+			sr.Serialize (name + "CipherSpeed", (uint64) speed.Speed);
+			sr.Serialize (name + "CipherThreadCount", (uint64) speed.ThreadCount);
+		}
+
+		sr.Serialize (name + "DeviceLatencyCount", (uint64) DeviceLatencies.size());
+		for (map <wstring, uint64>::const_iterator i = DeviceLatencies.begin(); i != DeviceLatencies.end(); ++i)
+		{
+			sr.Serialize (name + "DevicePath", i->first);
+			sr.Serialize (name + "DeviceLatency", i->second);
+		}
+
+		sr.Serialize (name + "KdfCount", (uint64) KdfIterationTimes.size());
+		for (map <wstring, double>::const_iterator i = KdfIterationTimes.begin(); i != KdfIterationTimes.end(); ++i)
+		{
+			sr.Serialize (name + "KdfName", i->first);
+			sr.Serialize (name + "KdfIterationTime", (uint64) (i->second * 1000));
+		}
+	}
+
+	CalibrationData Calibration::Get ()
+	{
+		ScopeLock lock (DataMutex);
+		return Data;
+	}
+
+	double Calibration::GetCipherSpeed (const wstring &algorithm, size_t bufferSize)
+	{
+		ScopeLock lock (DataMutex);
+
+		// The result measured with the closest buffer size is returned
+		double speed = 0;
+		double distance = 0;
+
+		foreach (const CalibrationCipherSpeed &result, Data.CipherSpeeds)
+		{
+			if (result.Algorithm != algorithm || result.BufferSize == 0 || bufferSize == 0)
+				continue;
+
+			double d = fabs (log ((double) result.BufferSize / bufferSize));
+			if (speed == 0 || d < distance)
+			{
+				speed = result.Speed;
+				distance = d;
+			}
+		}
+
+		return speed;
+	}
+
+	uint64 Calibration::GetDeviceLatency (const wstring &path)
+	{
+		ScopeLock lock (DataMutex);
+
+		map <wstring, uint64>::const_iterator i = Data.DeviceLatencies.find (path);
+		return i != Data.DeviceLatencies.end() ? i->second : 0;
+	}
+
+	double Calibration::GetKdfTime (const Pkcs5Kdf &kdf, int pim)
+	{
+		ScopeLock lock (DataMutex);
+
+		map <wstring, double>::const_iterator i = Data.KdfIterationTimes.find (kdf.GetName());
+		if (i == Data.KdfIterationTimes.end())
+			return 0;
+
+		return i->second * kdf.GetIterationCount (pim) / 1000000000.0;
+	}
+
+	bool Calibration::IsCalibrated ()
+	{
+		ScopeLock lock (DataMutex);
+		return Calibrated;
+	}
+
+	bool Calibration::IsCurrent (const CalibrationData &data)
+	{
+		return data.CpuCount == CryptoBenchmark::GetCpuCount();
+	}
+
+	CalibrationData Calibration::Measure (const CalibrationOptions &options)
+	{
+		CalibrationData data;
+		data.CpuCount = CryptoBenchmark::GetCpuCount();
+		data.Time = (uint64) time (nullptr);
+
+		CryptoBenchmarkOptions benchmarkOptions;
+		benchmarkOptions.Repetitions = 3;
+		benchmarkOptions.SampleTime = 10;
+
+		size_t minFragmentSize = EncryptionThreadPool::GetMinFragmentSize();
+		finally_do_arg (size_t, minFragmentSize, { EncryptionThreadPool::SetMinFragmentSize (finally_arg); });
+
+		data.MinFragmentSize = MeasureMinFragmentSize();
+
+		// Encryption speed is measured with the thread pool tuned
+		EncryptionThreadPool::SetMinFragmentSize (data.MinFragmentSize);
+
+		EncryptionAlgorithmList algorithms;
+		if (options.Full)
+			algorithms = EncryptionAlgorithm::GetAvailableAlgorithms();
+		else
+			algorithms.push_back (shared_ptr <EncryptionAlgorithm> (new AES));
+
+		size_t bufferSizes[] = { 4 * BYTES_PER_KB, 64 * BYTES_PER_KB, 1 * BYTES_PER_MB };
+
+		foreach (shared_ptr <EncryptionAlgorithm> ea, algorithms)
+		{
+			for (size_t i = 0; i < array_capacity (bufferSizes); ++i)
+			{
+				CryptoBenchmarkResult result = CryptoBenchmark::BenchmarkEncryption (ea, false, bufferSizes[i], benchmarkOptions);
+
+				CalibrationCipherSpeed speed;
+				speed.Algorithm = ea->GetName();
+				speed.BufferSize = bufferSizes[i];
+				speed.Speed = result.Statistics.Median;
+				speed.ThreadCount = result.ThreadCount;
+				data.CipherSpeeds.push_back (speed);
+			}
+		}
+
+		// Key derivation functions are measured with a reduced iteration count, as the time is linear in it
+		const int kdfIterationCount = 10000;
+
+		SecureBuffer key (MASTER_KEYDATA_SIZE);
+		Buffer salt (PKCS5_SALT_SIZE);
+		salt.Zero();
+		VolumePassword password ((const byte *) "passphrase-1234567890", 21);
+
+		foreach (shared_ptr <Pkcs5Kdf> kdf, Pkcs5Kdf::GetAvailableAlgorithms (false))
+		{
+			uint64 startTime = Time::GetMonotonic();
+			kdf->DeriveKey (key, password, salt, kdfIterationCount);
+			data.KdfIterationTimes[kdf->GetName()] = (double) (Time::GetMonotonic() - startTime) / kdfIterationCount;
+		}
+
+		foreach (const FilePath &device, options.Devices)
+			data.DeviceLatencies[wstring (device)] = MeasureDeviceLatency (device);
+
+		return data;
+	}
+
+	uint64 Calibration::MeasureDeviceLatency (const FilePath &path)
+	{
+		const size_t readSize = 4096;
+		const size_t readCount = 16;
+
+		File file;
+		file.Open (path, File::OpenRead, File::ShareReadWrite, File::PreserveTimestamps);
+
+		uint64 blockCount = file.Length() / readSize;
+		if (blockCount == 0)
+			throw ParameterIncorrect (SRC_POS);
+
+		Buffer buffer (readSize);
+		vector <uint64> samples;
+
+		// Random blocks are read to reduce the chance of hitting the read-ahead or the page cache
+		uint64 state = Time::GetMonotonic() | 1;
+
+		for (size_t i = 0; i < readCount; ++i)
+		{
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+
+			uint64 startTime = Time::GetMonotonic();
+			file.ReadAt (buffer, (state % blockCount) * readSize);
+			samples.push_back (Time::GetMonotonic() - startTime);
+		}
+
+		std::sort (samples.begin(), samples.end());
+		return samples[samples.size() / 2];
+	}
+
+	size_t Calibration::MeasureMinFragmentSize ()
+	{
+		EncryptionThreadPool::StartIfPending();
+
+		if (!EncryptionThreadPool::IsRunning() || EncryptionThreadPool::GetThreadCount() < 2)
+			return 0;
+
+		CryptoBenchmarkOptions options;
+		options.Repetitions = 3;
+		options.SampleTime = 10;
+
+		shared_ptr <EncryptionAlgorithm> ea (new AES);
+		size_t threadCount = EncryptionThreadPool::GetThreadCount();
+
+		// AES is the fastest algorithm and therefore gains the least from parallel processing
+		const size_t maxFragmentSize = 64 * BYTES_PER_KB;
+		size_t fragmentSize;
+
+		// The maximum is returned if the pool is not faster with any smaller fragment
+		for (fragmentSize = ENCRYPTION_DATA_UNIT_SIZE; fragmentSize < maxFragmentSize; fragmentSize *= 2)
+		{
+			size_t bufferSize = fragmentSize * threadCount;
+
+			EncryptionThreadPool::SetMinFragmentSize (bufferSize);
+			double singleThreadSpeed = CryptoBenchmark::BenchmarkEncryption (ea, false, bufferSize, options).Statistics.Median;
+
+			EncryptionThreadPool::SetMinFragmentSize (0);
+			double poolSpeed = CryptoBenchmark::BenchmarkEncryption (ea, false, bufferSize, options).Statistics.Median;
+
+			if (poolSpeed > singleThreadSpeed * 1.1)
+				break;
+		}
+
+		return fragmentSize;
+	}
+
+	struct KdfCostLess
+	{
+		KdfCostLess (int pim) : Pim (pim) { }
+		bool operator() (shared_ptr <Pkcs5Kdf> a, shared_ptr <Pkcs5Kdf> b) const { return Calibration::GetKdfTime (*a, Pim) < Calibration::GetKdfTime (*b, Pim); }
+		int Pim;
+	};
+
+	Pkcs5KdfList Calibration::SortKeyDerivationFunctions (const Pkcs5KdfList &kdfs, int pim)
+	{
+		if (kdfs.size() < 3)
+			return kdfs;
+
+		foreach (shared_ptr <Pkcs5Kdf> kdf, kdfs)
+		{
+			if (GetKdfTime (*kdf, pim) == 0)
+				return kdfs;
+		}
+
+		// The first function is the default one used to create volumes and remains the first to be tried
+		Pkcs5KdfList sorted (++kdfs.begin(), kdfs.end());
+		sorted.sort (KdfCostLess (pim));
+		sorted.push_front (kdfs.front());
+
+		return sorted;
+	}
+
+	bool Calibration::Calibrated = false;
+	CalibrationData Calibration::Data;
+	Mutex Calibration::DataMutex;
+}
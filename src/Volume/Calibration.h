@@ -0,0 +1,84 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Volume_Calibration
+#define TC_HEADER_Volume_Calibration
+
+#include "Platform/Platform.h"
+#include "Platform/Serializer.h"
+#include "EncryptionAlgorithm.h"
+#include "Pkcs5Kdf.h"
+
+namespace VeraCrypt
+{
+	struct CalibrationCipherSpeed
+	{
+		CalibrationCipherSpeed () : BufferSize (0), Speed (0), ThreadCount (0) { }
+
+		wstring Algorithm;
+		size_t BufferSize;
+		double Speed;			// Bytes per second
+		size_t ThreadCount;
+	};
+
+	// Measured properties of the host. The data is stored in the configuration directory
+	// by the user interface and is discarded when the number of CPUs changes. It is sent
+	// to the core service with each mount request, as volumes are opened there.
+	struct CalibrationData
+	{
+		CalibrationData () : CpuCount (0), MinFragmentSize (0), Time (0) { }
+
+		void Deserialize (Serializer &sr, const string &name);
+		void Serialize (Serializer &sr, const string &name) const;
+
+		list <CalibrationCipherSpeed> CipherSpeeds;
+		uint64 CpuCount;
+		map <wstring, uint64> DeviceLatencies;		// Nanoseconds per random 4 KB read, by path of the host device or file
+		map <wstring, double> KdfIterationTimes;	// Nanoseconds per iteration, by name of the key derivation function
+		size_t MinFragmentSize;						// Smallest fragment processed faster by the encryption thread pool; 0 = unknown
+		uint64 Time;								// Seconds since the Epoch
+	};
+
+	struct CalibrationOptions
+	{
+		CalibrationOptions () : Full (false) { }
+
+		list <FilePath> Devices;	// Host devices or files whose read latency is measured
+		bool Full;					// Measure all encryption algorithms instead of AES only
+	};
+
+	// Measures the speed of this host and answers queries about it, so that runtime
+	// decisions can be based on measurements instead of fixed assumptions. All queries
+	// return 0 if the requested value has not been measured.
+	class Calibration
+	{
+	public:
+		static void Apply (const CalibrationData &data);
+		static CalibrationData Get ();
+		static double GetCipherSpeed (const wstring &algorithm, size_t bufferSize);
+		static uint64 GetDeviceLatency (const wstring &path);
+		static double GetKdfTime (const Pkcs5Kdf &kdf, int pim);
+		static bool IsCalibrated ();
+		static bool IsCurrent (const CalibrationData &data);
+		static CalibrationData Measure (const CalibrationOptions &options);
+		static uint64 MeasureDeviceLatency (const FilePath &path);
+		static Pkcs5KdfList SortKeyDerivationFunctions (const Pkcs5KdfList &kdfs, int pim);
+
+	protected:
+		static size_t MeasureMinFragmentSize ();
+
+		static bool Calibrated;
+		static CalibrationData Data;
+		static Mutex DataMutex;
+
+	private:
+		Calibration ();
+	};
+}
+
+#endif // TC_HEADER_Volume_Calibration
@@ -0,0 +1,358 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include <algorithm>
+#include <math.h>
+#ifdef TC_UNIX
+#include <unistd.h>
+#endif
+#include "Platform/Time.h"
+#include "Common/Crypto.h"
+#include "CryptoBenchmark.h"
+#include "EncryptionModeXTS.h"
+#include "EncryptionThreadPool.h"
+#include "VolumePassword.h"
+
+namespace VeraCrypt
+{
+	void BenchmarkStatistics::AddToJson (JsonObject &json) const
+	{
+		json.Add ("samples", (uint64) Samples);
+		json.Add ("mean", Mean);
+		json.Add ("median", Median);
+		json.Add ("min", Min);
+		json.Add ("max", Max);
+		json.Add ("stddev", StdDev);
+		json.Add ("rsd", GetRelativeStdDev());
+	}
+
+	BenchmarkStatistics BenchmarkStatistics::Compute (vector <double> samples)
+	{
+		BenchmarkStatistics stats;
+		if (samples.empty())
+			return stats;
+
+		std::sort (samples.begin(), samples.end());
+
+		stats.Samples = samples.size();
+		stats.Min = samples.front();
+		stats.Max = samples.back();
+
+		size_t middle = samples.size() / 2;
+		stats.Median = (samples.size() % 2 != 0) ? samples[middle] : (samples[middle - 1] + samples[middle]) / 2;
+
+		double sum = 0;
+		foreach (double sample, samples)
+			sum += sample;
+
+		stats.Mean = sum / samples.size();
+
+		if (samples.size() > 1)
+		{
+			double squares = 0;
+			foreach (double sample, samples)
+				squares += (sample - stats.Mean) * (sample - stats.Mean);
+
+			// Sample standard deviation
+			stats.StdDev = sqrt (squares / (samples.size() - 1));
+		}
+
+		return stats;
+	}
+
+	JsonObject CryptoBenchmarkResult::ToJson () const
+	{
+		JsonObject json;
+		json.Add ("category", Category);
+		json.Add ("algorithm", Algorithm);
+		json.Add ("operation", Operation);
+
+		if (Deprecated)
+			json.Add ("deprecated", true);
+
+		if (Category == "kdf")
+		{
+			json.Add ("pim", (int32) Pim);
+			json.Add ("iterations", (int32) Iterations);
+			json.Add ("unit", "s");
+		}
+		else
+		{
+			json.Add ("buffer_size", (uint64) BufferSize);
+			json.Add ("threads", (uint64) ThreadCount);
+			json.Add ("unit", "B/s");
+
+			if (HugePages)
+				json.Add ("huge_pages", true);
+		}
+
+		Statistics.AddToJson (json);
+		return json;
+	}
+
+	CryptoBenchmarkResult CryptoBenchmark::BenchmarkEncryption (shared_ptr <EncryptionAlgorithm> ea, bool decrypt, size_t bufferSize, const CryptoBenchmarkOptions &options)
+	{
+		CryptoBenchmarkResult result;
+		result.Category = "encryption";
+		result.Algorithm = ea->GetName (true);
+		result.Operation = decrypt ? "decrypt" : "encrypt";
+		result.BufferSize = bufferSize;
+		result.Deprecated = ea->IsDeprecated();
+		result.HugePages = options.HugePages;
+		result.ThreadCount = EncryptionThreadPool::IsRunning() ? EncryptionThreadPool::GetThreadCount() : 1;
+
+		if (bufferSize < ENCRYPTION_DATA_UNIT_SIZE || bufferSize % ENCRYPTION_DATA_UNIT_SIZE != 0)
+			throw ParameterIncorrect (SRC_POS);
+
+		Buffer key (ea->GetKeySize());
+		key.Zero();
+		ea->SetKey (key);
+
+		shared_ptr <EncryptionMode> xts (new EncryptionModeXTS);
+		xts->SetKey (key);
+		ea->SetMode (xts);
+
+		Buffer heapBuffer;
+		IoBuffer ioBuffer;
+		Buffer &buffer = options.HugePages ? ioBuffer : heapBuffer;
+		buffer.Allocate (bufferSize);
+		buffer.Zero();
+
+		uint64 unitCount = bufferSize / ENCRYPTION_DATA_UNIT_SIZE;
+		vector <double> samples;
+
+		// CPU "warm up" (an attempt to prevent skewed results on systems where CPU frequency gradually changes depending on CPU load)
+		uint64 startTime = Time::GetMonotonic();
+		do
+		{
+			ea->EncryptSectors (buffer, 0, unitCount, ENCRYPTION_DATA_UNIT_SIZE);
+		}
+		while (Time::GetMonotonic() - startTime < WarmUpTime * 1000000ULL);
+
+		for (size_t i = 0; i < options.Repetitions; ++i)
+		{
+			uint64 size = 0;
+			uint64 elapsed;
+
+			startTime = Time::GetMonotonic();
+			do
+			{
+				if (decrypt)
+					ea->DecryptSectors (buffer, 0, unitCount, ENCRYPTION_DATA_UNIT_SIZE);
+				else
+					ea->EncryptSectors (buffer, 0, unitCount, ENCRYPTION_DATA_UNIT_SIZE);
+
+				size += bufferSize;
+				elapsed = Time::GetMonotonic() - startTime;
+			}
+			while (elapsed < options.SampleTime * 1000000ULL);
+
+			samples.push_back ((double) size * 1000000000.0 / (double) elapsed);
+		}
+
+		result.Statistics = BenchmarkStatistics::Compute (samples);
+		return result;
+	}
+
+	CryptoBenchmarkResult CryptoBenchmark::BenchmarkHash (shared_ptr <Hash> hash, size_t bufferSize, const CryptoBenchmarkOptions &options)
+	{
+		CryptoBenchmarkResult result;
+		result.Category = "hash";
+		result.Algorithm = hash->GetName();
+		result.Operation = "hash";
+		result.BufferSize = bufferSize;
+		result.Deprecated = hash->IsDeprecated();
+		result.HugePages = options.HugePages;
+		result.ThreadCount = 1;
+
+		Buffer heapBuffer;
+		IoBuffer ioBuffer;
+		Buffer &buffer = options.HugePages ? ioBuffer : heapBuffer;
+		buffer.Allocate (bufferSize);
+		buffer.Zero();
+
+		Buffer digest (hash->GetDigestSize());
+		vector <double> samples;
+
+		uint64 startTime = Time::GetMonotonic();
+		do
+		{
+			hash->Init();
+			hash->ProcessData (buffer);
+			hash->GetDigest (digest);
+		}
+		while (Time::GetMonotonic() - startTime < WarmUpTime * 1000000ULL);
+
+		for (size_t i = 0; i < options.Repetitions; ++i)
+		{
+			uint64 size = 0;
+			uint64 elapsed;
+
+			startTime = Time::GetMonotonic();
+			do
+			{
+				hash->Init();
+				hash->ProcessData (buffer);
+				hash->GetDigest (digest);
+
+				size += bufferSize;
+				elapsed = Time::GetMonotonic() - startTime;
+			}
+			while (elapsed < options.SampleTime * 1000000ULL);
+
+			samples.push_back ((double) size * 1000000000.0 / (double) elapsed);
+		}
+
+		result.Statistics = BenchmarkStatistics::Compute (samples);
+		return result;
+	}
+
+	CryptoBenchmarkResult CryptoBenchmark::BenchmarkKdf (shared_ptr <Pkcs5Kdf> kdf, int pim, const CryptoBenchmarkOptions &options)
+	{
+		CryptoBenchmarkResult result;
+		result.Category = "kdf";
+		result.Algorithm = kdf->GetName();
+		result.Operation = "derive";
+		result.Deprecated = kdf->IsDeprecated();
+		result.Iterations = kdf->GetIterationCount (pim);
+		result.Pim = pim;
+
+		Buffer key (MASTER_KEYDATA_SIZE);
+		Buffer salt (PKCS5_SALT_SIZE);
+		for (size_t i = 0; i < salt.Size(); ++i)
+			salt[i] = (byte) (i * 0x11);
+
+		VolumePassword password ((const byte*) "passphrase-1234567890", 21);
+		vector <double> samples;
+
+		for (size_t i = 0; i < options.Repetitions; ++i)
+		{
+			uint64 startTime = Time::GetMonotonic();
+			kdf->DeriveKey (key, password, pim, salt);
+			samples.push_back ((double) (Time::GetMonotonic() - startTime) / 1000000000.0);
+		}
+
+		result.Statistics = BenchmarkStatistics::Compute (samples);
+		return result;
+	}
+
+	uint64 CryptoBenchmark::GetCpuCount ()
+	{
+#ifdef _SC_NPROCESSORS_ONLN
+		long cpuCount = sysconf (_SC_NPROCESSORS_ONLN);
+		if (cpuCount > 0)
+			return (uint64) cpuCount;
+#endif
+		return EncryptionThreadPool::IsRunning() ? EncryptionThreadPool::GetThreadCount() : 1;
+	}
+
+	list <CryptoBenchmarkResult> CryptoBenchmark::Run (const CryptoBenchmarkOptions &options, CryptoBenchmarkListener *listener)
+	{
+		list <CryptoBenchmarkResult> results;
+
+		if (options.Repetitions < 1)
+			throw ParameterIncorrect (SRC_POS);
+
+		list <size_t> bufferSizes = options.BufferSizes;
+		if (bufferSizes.empty())
+		{
+			bufferSizes.push_back (64 * BYTES_PER_KB);
+			bufferSizes.push_back (1 * BYTES_PER_MB);
+			bufferSizes.push_back (16 * BYTES_PER_MB);
+		}
+
+		list <size_t> threadCounts = options.ThreadCounts;
+		if (threadCounts.empty())
+		{
+			threadCounts.push_back (1);
+
+			size_t cpuCount = (size_t) GetCpuCount();
+			if (cpuCount > 1)
+				threadCounts.push_back (cpuCount);
+		}
+
+		if (options.Encryption)
+		{
+			bool poolRunning = EncryptionThreadPool::IsRunning() || EncryptionThreadPool::IsStartPending();
+			size_t poolThreadCount = EncryptionThreadPool::IsRunning() ? EncryptionThreadPool::GetThreadCount() : 0;
+
+			finally_do_arg2 (bool, poolRunning, size_t, poolThreadCount,
+			{
+				EncryptionThreadPool::Stop();
+				if (finally_arg)
+					EncryptionThreadPool::StartOnDemand (finally_arg2);
+			});
+
+			foreach (size_t threadCount, threadCounts)
+			{
+				EncryptionThreadPool::Stop();
+				if (threadCount > 1)
+					EncryptionThreadPool::Start (threadCount);
+
+				foreach (shared_ptr <EncryptionAlgorithm> ea, EncryptionAlgorithm::GetAvailableAlgorithms())
+				{
+					if (options.EncryptionAlgorithmFilter && ea->GetName() != options.EncryptionAlgorithmFilter->GetName())
+						continue;
+
+					foreach (size_t bufferSize, bufferSizes)
+					{
+						for (int decrypt = 0; decrypt <= 1; ++decrypt)
+						{
+							results.push_back (BenchmarkEncryption (ea, decrypt != 0, bufferSize, options));
+							if (listener)
+								(*listener) (results.back());
+						}
+					}
+				}
+			}
+		}
+
+		if (options.Hash)
+		{
+			foreach (shared_ptr <Hash> hash, Hash::GetAvailableAlgorithms())
+			{
+				if (options.HashFilter && hash->GetName() != options.HashFilter->GetName())
+					continue;
+
+				foreach (size_t bufferSize, bufferSizes)
+				{
+					results.push_back (BenchmarkHash (hash, bufferSize, options));
+					if (listener)
+						(*listener) (results.back());
+				}
+			}
+		}
+
+		if (options.Kdf)
+		{
+			list <int> pims;
+			pims.push_back (0);
+
+			foreach (int pim, options.Pims)
+			{
+				if (pim > 0 && find (pims.begin(), pims.end(), pim) == pims.end())
+					pims.push_back (pim);
+			}
+
+			foreach (shared_ptr <Pkcs5Kdf> kdf, Pkcs5Kdf::GetAvailableAlgorithms (false))
+			{
+				if (options.HashFilter && kdf->GetHash()->GetName() != options.HashFilter->GetName())
+					continue;
+
+				foreach (int pim, pims)
+				{
+					results.push_back (BenchmarkKdf (kdf, pim, options));
+					if (listener)
+						(*listener) (results.back());
+				}
+			}
+		}
+
+		return results;
+	}
+}
@@ -0,0 +1,99 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Volume_CryptoBenchmark
+#define TC_HEADER_Volume_CryptoBenchmark
+
+#include "Platform/Platform.h"
+#include "Platform/JsonObject.h"
+#include "EncryptionAlgorithm.h"
+#include "Hash.h"
+#include "Pkcs5Kdf.h"
+
+namespace VeraCrypt
+{
+	struct BenchmarkStatistics
+	{
+		BenchmarkStatistics () : Max (0), Mean (0), Median (0), Min (0), StdDev (0), Samples (0) { }
+
+		void AddToJson (JsonObject &json) const;
+		static BenchmarkStatistics Compute (vector <double> samples);
+		double GetRelativeStdDev () const { return Mean != 0 ? StdDev / Mean : 0; }
+
+		double Max;
+		double Mean;
+		double Median;
+		double Min;
+		double StdDev;
+		size_t Samples;
+	};
+
+	struct CryptoBenchmarkOptions
+	{
+		CryptoBenchmarkOptions () : Encryption (true), Hash (true), HugePages (false), Kdf (true), Repetitions (5), SampleTime (100) { }
+
+		list <size_t> BufferSizes;				// Defaults to 64 KB, 1 MB and 16 MB
+		bool Encryption;
+		shared_ptr <EncryptionAlgorithm> EncryptionAlgorithmFilter;
+		bool Hash;
+		shared_ptr <VeraCrypt::Hash> HashFilter;
+		bool HugePages;							// Use I/O buffers backed by huge pages (see IoBuffer)
+		bool Kdf;
+		list <int> Pims;						// The default PIM (0) is always measured
+		size_t Repetitions;
+		uint32 SampleTime;						// Milliseconds per sample of encryption and hash benchmarks
+		list <size_t> ThreadCounts;				// Defaults to 1 and the number of CPUs
+	};
+
+	struct CryptoBenchmarkResult
+	{
+		CryptoBenchmarkResult () : BufferSize (0), Deprecated (false), HugePages (false), Iterations (0), Pim (0), ThreadCount (0) { }
+
+		JsonObject ToJson () const;
+
+		wstring Algorithm;
+		size_t BufferSize;
+		string Category;		// "encryption", "hash" or "kdf"
+		bool Deprecated;
+		bool HugePages;
+		int Iterations;
+		string Operation;		// "encrypt", "decrypt", "hash" or "derive"
+		int Pim;
+		BenchmarkStatistics Statistics;	// Bytes per second, or seconds per derivation for KDFs
+		size_t ThreadCount;
+	};
+
+	struct CryptoBenchmarkListener
+	{
+		virtual ~CryptoBenchmarkListener () { }
+		virtual void operator() (const CryptoBenchmarkResult &result) = 0;
+	};
+
+	// Measures the performance of all encryption algorithms, hash algorithms and key
+	// derivation functions without requiring a graphical user interface. Encryption
+	// is measured with the encryption thread pool resized to each requested thread
+	// count; the original pool configuration is restored afterwards.
+	class CryptoBenchmark
+	{
+	public:
+		static list <CryptoBenchmarkResult> Run (const CryptoBenchmarkOptions &options, CryptoBenchmarkListener *listener = nullptr);
+
+		static CryptoBenchmarkResult BenchmarkEncryption (shared_ptr <EncryptionAlgorithm> ea, bool decrypt, size_t bufferSize, const CryptoBenchmarkOptions &options);
+		static CryptoBenchmarkResult BenchmarkHash (shared_ptr <Hash> hash, size_t bufferSize, const CryptoBenchmarkOptions &options);
+		static CryptoBenchmarkResult BenchmarkKdf (shared_ptr <Pkcs5Kdf> kdf, int pim, const CryptoBenchmarkOptions &options);
+
+		static uint64 GetCpuCount ();
+
+		static const uint32 WarmUpTime = 20; // Milliseconds
+
+	private:
+		CryptoBenchmark ();
+	};
+}
+
+#endif // TC_HEADER_Volume_CryptoBenchmark
@@ -0,0 +1,327 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include "Common/Crypto.h"
+#include "CryptoDifferentialTest.h"
+#include "EncryptionAlgorithm.h"
+#include "EncryptionModeXTS.h"
+#include "Hash.h"
+
+namespace VeraCrypt
+{
+	void CryptoDifferentialTest::InputReader::Read (const BufferPtr &buffer)
+	{
+		for (size_t i = 0; i < buffer.Size(); ++i)
+			buffer[i] = ReadByte();
+	}
+
+	byte CryptoDifferentialTest::InputReader::ReadByte ()
+	{
+		// Bytes of the input are consumed first and determine the pseudorandom bytes that follow
+		if (Position < Input.Size())
+		{
+			byte b = Input[Position++];
+			State = (State ^ b) * 0x100000001b3ULL;
+			return b;
+		}
+
+		if (State == 0)
+			State = 1;
+
+		State ^= State << 13;
+		State ^= State >> 7;
+		State ^= State << 17;
+		return (byte) (State >> 24);
+	}
+
+	uint64 CryptoDifferentialTest::InputReader::ReadUInt64 ()
+	{
+		uint64 value = 0;
+		for (size_t i = 0; i < sizeof (value); ++i)
+			value = (value << 8) | ReadByte();
+
+		return value;
+	}
+
+	void CryptoDifferentialTest::ProcessXtsReference (const CipherList &ciphers, const CipherList &secondaryCiphers, byte *data, uint64 length, uint64 dataUnitNo, bool encrypt)
+	{
+		// Ciphers of a cascade encrypt the whole buffer in turn, and decrypt it in reverse order
+		for (size_t n = 0; n < ciphers.size(); ++n)
+		{
+			size_t c = encrypt ? n : ciphers.size() - 1 - n;
+			const Cipher &cipher = *ciphers[c];
+			uint64 unitNo = dataUnitNo;
+
+			for (uint64 offset = 0; offset < length; ++unitNo)
+			{
+				byte tweak[BYTES_PER_XTS_BLOCK];
+				for (size_t i = 0; i < sizeof (tweak); ++i)
+					tweak[i] = i < sizeof (unitNo) ? (byte) (unitNo >> (i * 8)) : 0;
+
+				secondaryCiphers[c]->EncryptBlock (tweak);
+
+				for (size_t block = 0; block < BLOCKS_PER_XTS_DATA_UNIT && offset < length; ++block, offset += BYTES_PER_XTS_BLOCK)
+				{
+					byte *p = data + offset;
+
+					for (size_t i = 0; i < sizeof (tweak); ++i)
+						p[i] ^= tweak[i];
+
+					if (encrypt)
+						cipher.EncryptBlock (p);
+					else
+						cipher.DecryptBlock (p);
+
+					for (size_t i = 0; i < sizeof (tweak); ++i)
+						p[i] ^= tweak[i];
+
+					// Multiply the tweak by the primitive element of GF(2^128)
+					byte carry = 0;
+					for (size_t i = 0; i < sizeof (tweak); ++i)
+					{
+						byte nextCarry = tweak[i] >> 7;
+						tweak[i] = (byte) ((tweak[i] << 1) | carry);
+						carry = nextCarry;
+					}
+
+					if (carry)
+						tweak[0] ^= 135;
+				}
+			}
+		}
+	}
+
+	void CryptoDifferentialTest::TestAll ()
+	{
+		TestAll (DefaultSeed, DefaultIterationCount);
+	}
+
+	void CryptoDifferentialTest::TestAll (uint64 seed, size_t iterationCount)
+	{
+		Buffer input (64);
+
+		for (size_t iteration = 0; iteration < iterationCount; ++iteration)
+		{
+			uint64 state = seed + iteration;
+			for (size_t i = 0; i < input.Size(); ++i)
+			{
+				state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+				input[i] = (byte) (state >> 56);
+			}
+
+			try
+			{
+				TestInput (input);
+			}
+			catch (TestFailed &e)
+			{
+				// The seed reproduces the failure with a single iteration
+				wstringstream subject;
+				subject << e.GetSubject() << L" (seed " << seed + iteration << L")";
+				throw TestFailed (SRC_POS, subject.str());
+			}
+		}
+	}
+
+	void CryptoDifferentialTest::TestInput (const ConstBufferPtr &input)
+	{
+		bool hwSupportEnabled = Cipher::IsHwSupportEnabled();
+		finally_do_arg (bool, hwSupportEnabled, { Cipher::EnableHwSupport (finally_arg); });
+
+		InputReader reader (input);
+
+		switch (reader.ReadByte() % 3)
+		{
+		case 0:
+			TestCipher (reader);
+			break;
+
+		case 1:
+			TestXts (reader);
+			break;
+
+		default:
+			TestHash (reader);
+			break;
+		}
+	}
+
+	void CryptoDifferentialTest::TestCipher (InputReader &input)
+	{
+		CipherList ciphers = Cipher::GetAvailableCiphers();
+		shared_ptr <Cipher> reference = ciphers[input.ReadByte() % ciphers.size()];
+		shared_ptr <Cipher> cipher = reference->GetNew();
+		size_t blockSize = cipher->GetBlockSize();
+
+		// Hardware implementations may process only multiples of a fixed number of blocks, which are therefore preferred
+		size_t blockCount = (input.ReadByte() & 3) == 0 ? 32 * (1 + input.ReadByte() % 4) : 1 + input.ReadByte() % 80;
+		size_t offset = input.ReadByte() % 16;
+
+		SecureBuffer key (cipher->GetKeySize());
+		input.Read (key);
+
+		Buffer plaintext (blockCount * blockSize);
+		input.Read (plaintext);
+
+		Cipher::EnableHwSupport (false);
+		reference->SetKey (key);
+
+		Buffer expected (plaintext.Size());
+		expected.CopyFrom (plaintext);
+
+		for (size_t i = 0; i < blockCount; ++i)
+			reference->EncryptBlock (expected.Ptr() + i * blockSize);
+
+		Buffer buffer (plaintext.Size() + 16);
+		BufferPtr data = buffer.GetRange (offset, plaintext.Size());
+		data.CopyFrom (expected);
+
+		for (size_t i = 0; i < blockCount; ++i)
+			reference->DecryptBlock (data.Get() + i * blockSize);
+
+		if (memcmp (data, plaintext, plaintext.Size()) != 0)
+			throw TestFailed (SRC_POS, cipher->GetName());
+
+		Cipher::EnableHwSupport (true);
+		cipher->SetKey (key);
+
+		cipher->EncryptBlocks (data, blockCount);
+		if (memcmp (data, expected, expected.Size()) != 0)
+			throw TestFailed (SRC_POS, cipher->GetName());
+
+		cipher->DecryptBlocks (data, blockCount);
+		if (memcmp (data, plaintext, plaintext.Size()) != 0)
+			throw TestFailed (SRC_POS, cipher->GetName());
+
+		for (size_t i = 0; i < blockCount; ++i)
+			cipher->EncryptBlock (data.Get() + i * blockSize);
+
+		if (memcmp (data, expected, expected.Size()) != 0)
+			throw TestFailed (SRC_POS, cipher->GetName());
+	}
+
+	void CryptoDifferentialTest::TestHash (InputReader &input)
+	{
+		HashList hashes = Hash::GetAvailableAlgorithms();
+		HashList::const_iterator h = hashes.begin();
+		for (size_t i = input.ReadByte() % hashes.size(); i > 0; --i)
+			++h;
+
+		shared_ptr <Hash> hash = (*h)->GetNew();
+
+		size_t length = (input.ReadByte() & 3) == 0 ? input.ReadByte() : ((size_t) input.ReadByte() << 5) | input.ReadByte() % 32;
+		size_t offset = input.ReadByte() % 16;
+
+		Buffer buffer (length + 16);
+		BufferPtr data = buffer.GetRange (offset, length);
+		input.Read (data);
+
+		Buffer expected (hash->GetDigestSize());
+		hash->Init();
+		hash->ProcessData (data);
+		hash->GetDigest (expected);
+
+		// Chunks of random sizes are processed partly by the single-block and partly by the multi-block implementation
+		Buffer digest (hash->GetDigestSize());
+		hash->Init();
+
+		for (size_t pos = 0; pos < length; )
+		{
+			size_t chunkSize = (input.ReadByte() & 1) ? input.ReadByte() % 8 : 1 + input.ReadByte() % 300;
+			if (chunkSize > length - pos)
+				chunkSize = length - pos;
+
+			hash->ProcessData (data.GetRange (pos, chunkSize));
+			pos += chunkSize;
+		}
+
+		hash->GetDigest (digest);
+
+		if (memcmp (digest, expected, expected.Size()) != 0)
+			throw TestFailed (SRC_POS, hash->GetName());
+	}
+
+	void CryptoDifferentialTest::TestXts (InputReader &input)
+	{
+		EncryptionAlgorithmList algorithms = EncryptionAlgorithm::GetAvailableAlgorithms();
+		EncryptionAlgorithmList::const_iterator a = algorithms.begin();
+		for (size_t i = input.ReadByte() % algorithms.size(); i > 0; --i)
+			++a;
+
+		shared_ptr <EncryptionAlgorithm> ea = (*a)->GetNew();
+
+		SecureBuffer key (ea->GetKeySize());
+		input.Read (key);
+		SecureBuffer secondaryKey (ea->GetKeySize());
+		input.Read (secondaryKey);
+
+		// Sectors are processed by EncryptSectors, other lengths by Encrypt starting at the first data unit
+		bool sectors = (input.ReadByte() & 1) != 0;
+		size_t sectorSize = ENCRYPTION_DATA_UNIT_SIZE << (input.ReadByte() % 4);
+		uint64 sectorIndex = input.ReadUInt64() >> 16;
+		uint64 sectorCount = 1 + input.ReadByte() % 8;
+		uint64 length = sectors ? sectorCount * sectorSize : BYTES_PER_XTS_BLOCK * (1 + input.ReadByte() % 100);
+		uint64 dataUnitNo = sectors ? sectorIndex * sectorSize / ENCRYPTION_DATA_UNIT_SIZE : 0;
+		size_t offset = input.ReadByte() % 16;
+
+		Buffer plaintext ((size_t) length);
+		input.Read (plaintext);
+
+		CipherList ciphers;
+		CipherList secondaryCiphers;
+		size_t keyOffset = 0;
+
+		Cipher::EnableHwSupport (false);
+
+		foreach_ref (const Cipher &c, ea->GetCiphers())
+		{
+			ciphers.push_back (c.GetNew());
+			ciphers.back()->SetKey (key.GetRange (keyOffset, c.GetKeySize()));
+
+			secondaryCiphers.push_back (c.GetNew());
+			secondaryCiphers.back()->SetKey (secondaryKey.GetRange (keyOffset, c.GetKeySize()));
+
+			keyOffset += c.GetKeySize();
+		}
+
+		Buffer expected (plaintext.Size());
+		expected.CopyFrom (plaintext);
+		ProcessXtsReference (ciphers, secondaryCiphers, expected, length, dataUnitNo, true);
+
+		Buffer buffer (plaintext.Size() + 16);
+		BufferPtr data = buffer.GetRange (offset, plaintext.Size());
+		data.CopyFrom (expected);
+		ProcessXtsReference (ciphers, secondaryCiphers, data, length, dataUnitNo, false);
+
+		if (memcmp (data, plaintext, plaintext.Size()) != 0)
+			throw TestFailed (SRC_POS, ea->GetName());
+
+		Cipher::EnableHwSupport (true);
+
+		ea->SetKey (key);
+		shared_ptr <EncryptionMode> mode (new EncryptionModeXTS);
+		mode->SetKey (secondaryKey);
+		ea->SetMode (mode);
+
+		if (sectors)
+			ea->EncryptSectors (data, sectorIndex, sectorCount, sectorSize);
+		else
+			ea->Encrypt (data);
+
+		if (memcmp (data, expected, expected.Size()) != 0)
+			throw TestFailed (SRC_POS, ea->GetName());
+
+		if (sectors)
+			ea->DecryptSectors (data, sectorIndex, sectorCount, sectorSize);
+		else
+			ea->Decrypt (data);
+
+		if (memcmp (data, plaintext, plaintext.Size()) != 0)
+			throw TestFailed (SRC_POS, ea->GetName());
+	}
+}
@@ -0,0 +1,58 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Volume_CryptoDifferentialTest
+#define TC_HEADER_Volume_CryptoDifferentialTest
+
+#include "Platform/Platform.h"
+#include "Cipher.h"
+
+namespace VeraCrypt
+{
+	// Compares the optimized implementations of the ciphers, XTS and hash algorithms with
+	// their reference implementations on inputs derived from a seed or from fuzzer data.
+	// Ciphers and XTS are compared with single-block processing with hardware acceleration
+	// disabled, and hash algorithms with the same data processed in chunks of random sizes.
+	// A mismatch throws TestFailed with the name of the algorithm as subject.
+	class CryptoDifferentialTest
+	{
+	public:
+		static void TestAll ();
+		static void TestAll (uint64 seed, size_t iterationCount);
+		static void TestInput (const ConstBufferPtr &input);
+
+		static const uint64 DefaultSeed = 0x5645524143525950ULL;
+		static const size_t DefaultIterationCount = 300;
+
+	protected:
+		class InputReader
+		{
+		public:
+			InputReader (const ConstBufferPtr &input) : Input (input), Position (0), State (0x9e3779b97f4a7c15ULL) { }
+
+			void Read (const BufferPtr &buffer);
+			byte ReadByte ();
+			uint64 ReadUInt64 ();
+
+		protected:
+			ConstBufferPtr Input;
+			size_t Position;
+			uint64 State;
+		};
+
+		static void ProcessXtsReference (const CipherList &ciphers, const CipherList &secondaryCiphers, byte *data, uint64 length, uint64 dataUnitNo, bool encrypt);
+		static void TestCipher (InputReader &input);
+		static void TestHash (InputReader &input);
+		static void TestXts (InputReader &input);
+
+	private:
+		CryptoDifferentialTest ();
+	};
+}
+
+#endif // TC_HEADER_Volume_CryptoDifferentialTest
@@ -19,8 +19,10 @@
 #	include <sys/sysctl.h>
 #endif
 
+#include "Platform/StartupProfiler.h"
 #include "Platform/SyncEvent.h"
 #include "Platform/SystemLog.h"
+#include "Platform/Tracepoint.h"
 #include "Common/Crypto.h"
 #include "EncryptionThreadPool.h"
 
@@ -41,7 +43,14 @@ namespace VeraCrypt
 		if (unitCount == 0)
 			return;
 
-		if (!ThreadPoolRunning || unitCount == 1)
+		if (StartPending && unitCount > 1)
+			StartIfPending();
+
+		// Fragments smaller than MinFragmentSize cost more to dispatch than they gain from parallel processing
+		size_t minFragmentUnitCount = MinFragmentSize / sectorSize;
+		uint64 maxFragmentCount = minFragmentUnitCount > 1 ? unitCount / minFragmentUnitCount : unitCount;
+
+		if (!ThreadPoolRunning || maxFragmentCount < 2)
 		{
 			switch (type)
 			{
@@ -60,21 +69,12 @@ namespace VeraCrypt
 			return;
 		}
 
-		if (unitCount <= ThreadCount)
-		{
-			fragmentCount = (size_t) unitCount;
-			unitsPerFragment = 1;
-			remainder = 0;
-		}
-		else
-		{
-			fragmentCount = ThreadCount;
-			unitsPerFragment = (size_t) unitCount / ThreadCount;
-			remainder = (size_t) unitCount % ThreadCount;
+		fragmentCount = maxFragmentCount < ThreadCount ? (size_t) maxFragmentCount : ThreadCount;
+		unitsPerFragment = (size_t) unitCount / fragmentCount;
+		remainder = (size_t) unitCount % fragmentCount;
 
-			if (remainder > 0)
-				++unitsPerFragment;
-		}
+		if (remainder > 0)
+			++unitsPerFragment;
 
 		fragmentData = data;
 		fragmentStartUnitNo = startUnitNo;
@@ -118,6 +118,7 @@ namespace VeraCrypt
 				if (remainder > 0 && --remainder == 0)
 					--unitsPerFragment;
 
+				TC_TRACE4 (pool_enqueue, workItem, (int) type, workItem->Encryption.StartUnitNo, workItem->Encryption.UnitCount);
 				workItem->State.Set (WorkItem::State::Ready);
 				WorkItemReadyEvent.Signal();
 			}
@@ -136,39 +137,44 @@ namespace VeraCrypt
 			itemException->Throw();
 	}
 
-	void EncryptionThreadPool::Start ()
+	void EncryptionThreadPool::Start (size_t threadCount)
 	{
+		StartPending = false;
+
 		if (ThreadPoolRunning)
 			return;
 
-		size_t cpuCount;
+		size_t cpuCount = threadCount;
 
+		if (cpuCount == 0)
+		{
 #ifdef TC_WINDOWS
 
-		SYSTEM_INFO sysInfo;
-		GetSystemInfo (&sysInfo);
-		cpuCount = sysInfo.dwNumberOfProcessors;
+			SYSTEM_INFO sysInfo;
+			GetSystemInfo (&sysInfo);
+			cpuCount = sysInfo.dwNumberOfProcessors;
 
 #elif defined (_SC_NPROCESSORS_ONLN)
 
-		cpuCount = (size_t) sysconf (_SC_NPROCESSORS_ONLN);
-		if (cpuCount == (size_t) -1)
-			cpuCount = 1;
+			cpuCount = (size_t) sysconf (_SC_NPROCESSORS_ONLN);
+			if (cpuCount == (size_t) -1)
+				cpuCount = 1;
 
 #elif defined (TC_MACOSX)
 
-		int cpuCountSys;
-		int mib[2] = { CTL_HW, HW_NCPU };
+			int cpuCountSys;
+			int mib[2] = { CTL_HW, HW_NCPU };
 
-		size_t len = sizeof (cpuCountSys);
-		if (sysctl (mib, 2, &cpuCountSys, &len, nullptr, 0) == -1)
-			cpuCountSys = 1;
+			size_t len = sizeof (cpuCountSys);
+			if (sysctl (mib, 2, &cpuCountSys, &len, nullptr, 0) == -1)
+				cpuCountSys = 1;
 
-		cpuCount = (size_t) cpuCountSys;
+			cpuCount = (size_t) cpuCountSys;
 
 #else
 #	error Cannot determine CPU count
 #endif
+		}
 
 		if (cpuCount < 2)
 			return;
@@ -214,10 +220,37 @@ namespace VeraCrypt
 		}
 
 		ThreadPoolRunning = true;
+		StartupProfiler::Mark ("encryption thread pool");
+	}
+
+	void EncryptionThreadPool::StartIfPending ()
+	{
+		ScopeLock lock (StartMutex);
+		if (StartPending)
+		{
+			// Work is processed in the current thread if the pool cannot be started
+			try
+			{
+				Start (StartPendingThreadCount);
+			}
+			catch (...) { }
+		}
+	}
+
+	void EncryptionThreadPool::StartOnDemand (size_t threadCount)
+	{
+		if (ThreadPoolRunning)
+			return;
+
+		ScopeLock lock (StartMutex);
+		StartPendingThreadCount = threadCount;
+		StartPending = true;
 	}
 
 	void EncryptionThreadPool::Stop ()
 	{
+		StartPending = false;
+
 		if (!ThreadPoolRunning)
 			return;
 
@@ -229,6 +262,7 @@ namespace VeraCrypt
 			thread.Join();
 		}
 
+		RunningThreads.clear();
 		ThreadCount = 0;
 		ThreadPoolRunning = false;
 	}
@@ -260,6 +294,8 @@ namespace VeraCrypt
 				if (StopPending)
 					break;
 
+				TC_TRACE3 (pool_dispatch, workItem, (int) workItem->Type, workItem->Encryption.UnitCount);
+
 				try
 				{
 					switch (workItem->Type)
@@ -289,6 +325,8 @@ namespace VeraCrypt
 					workItem->FirstFragment->ItemException.reset (new UnknownException (SRC_POS));
 				}
 
+				TC_TRACE3 (pool_complete, workItem, (int) workItem->Type, workItem->Encryption.UnitCount);
+
 				if (workItem != workItem->FirstFragment)
 				{
 					workItem->State.Set (WorkItem::State::Free);
@@ -309,8 +347,11 @@ namespace VeraCrypt
 		}
 	}
 
+	volatile size_t EncryptionThreadPool::MinFragmentSize = 0;
 	volatile bool EncryptionThreadPool::ThreadPoolRunning = false;
 	volatile bool EncryptionThreadPool::StopPending = false;
+	volatile bool EncryptionThreadPool::StartPending = false;
+	size_t EncryptionThreadPool::StartPendingThreadCount;
 
 	size_t EncryptionThreadPool::ThreadCount;
 
@@ -321,6 +362,7 @@ namespace VeraCrypt
 
 	Mutex EncryptionThreadPool::EnqueueMutex;
 	Mutex EncryptionThreadPool::DequeueMutex;
+	Mutex EncryptionThreadPool::StartMutex;
 
 	SyncEvent EncryptionThreadPool::WorkItemReadyEvent;
 	SyncEvent EncryptionThreadPool::WorkItemCompletedEvent;
@@ -64,8 +64,14 @@ namespace VeraCrypt
 		};
 
 		static void DoWork (WorkType::Enum type, const EncryptionMode *mode, byte *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize);
+		static size_t GetMinFragmentSize () { return MinFragmentSize; }
+		static size_t GetThreadCount () { return ThreadCount; }
 		static bool IsRunning () { return ThreadPoolRunning; }
-		static void Start ();
+		static bool IsStartPending () { return StartPending; }
+		static void SetMinFragmentSize (size_t size) { MinFragmentSize = size; }	// Requests are not split into fragments smaller than size bytes
+		static void Start (size_t threadCount = 0);	// 0 = one thread per CPU
+		static void StartIfPending ();
+		static void StartOnDemand (size_t threadCount = 0);	// Defers start until work that can be split across threads is submitted
 		static void Stop ();
 
 	protected:
@@ -78,7 +84,11 @@ namespace VeraCrypt
 		static volatile size_t DequeuePosition;
 		static volatile size_t EnqueuePosition;
 		static Mutex EnqueueMutex;
+		static volatile size_t MinFragmentSize;
 		static list < shared_ptr <Thread> > RunningThreads;
+		static Mutex StartMutex;
+		static volatile bool StartPending;
+		static size_t StartPendingThreadCount;
 		static volatile bool StopPending;
 		static size_t ThreadCount;
 		static volatile bool ThreadPoolRunning;
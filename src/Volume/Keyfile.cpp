@@ -10,15 +10,121 @@
  code distribution packages.
 */
 
+#ifdef TC_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined (TC_LINUX)
+#include <sys/vfs.h>
+#elif defined (TC_BSD)
+#include <sys/param.h>
+#include <sys/mount.h>
+#endif
+#endif
+
+#include "Platform/Finally.h"
 #include "Platform/Serializer.h"
 #include "Common/SecurityToken.h"
 #include "Crc32.h"
 #include "Keyfile.h"
+#include "KeyfileCache.h"
 #include "VolumeException.h"
 
 namespace VeraCrypt
 {
-	void Keyfile::Apply (const BufferPtr &pool) const
+	// Returns false when the maximum processed length has been reached
+	static bool ApplyKeyfileData (Crc32 &crc32, const byte *data, size_t length, const BufferPtr &pool, size_t &poolPos, uint64 &totalLength)
+	{
+		for (size_t i = 0; i < length; i++)
+		{
+			uint32 crc = crc32.Process (data[i]);
+
+			pool[poolPos++] += (byte) (crc >> 24);
+			pool[poolPos++] += (byte) (crc >> 16);
+			pool[poolPos++] += (byte) (crc >> 8);
+			pool[poolPos++] += (byte) crc;
+
+			if (poolPos >= pool.Size())
+				poolPos = 0;
+
+			if (++totalLength >= Keyfile::MaxProcessedLength)
+				return false;
+		}
+
+		return true;
+	}
+
+	static void AddContribution (const BufferPtr &pool, const ConstBufferPtr &contribution)
+	{
+		for (size_t i = 0; i < pool.Size(); ++i)
+			pool[i] += contribution[i];
+	}
+
+#ifdef TC_UNIX
+	// Accessing a part of a mapped file removed by truncation raises SIGBUS. Files that other users
+	// can modify, and files on network filesystems, which may be modified by other hosts, are read.
+	static bool IsFileMappingSafe (int fd, const struct stat &fileStat)
+	{
+		if ((fileStat.st_uid != getuid() && fileStat.st_uid != 0) || (fileStat.st_mode & (S_IWGRP | S_IWOTH)))
+			return false;
+
+#if defined (TC_LINUX)
+		struct statfs fsStat;
+		if (fstatfs (fd, &fsStat) != 0)
+			return false;
+
+		switch ((uint32) fsStat.f_type)
+		{
+		case 0x6969:		// NFS
+		case 0x517b:		// SMB
+		case 0xfe534d42:	// SMB2
+		case 0xff534d42:	// CIFS
+		case 0x65735546:	// FUSE
+		case 0x00c36400:	// Ceph
+		case 0x01021997:	// 9P
+		case 0x5346414f:	// AFS
+		case 0x73757245:	// Coda
+			return false;
+		}
+
+		return true;
+#elif defined (TC_BSD)
+		struct statfs fsStat;
+		return fstatfs (fd, &fsStat) == 0 && (fsStat.f_flags & MNT_LOCAL);
+#else
+		return false;
+#endif
+	}
+
+	static bool GetKeyfileIdentity (int fd, const struct stat &fileStat, KeyfileIdentity &identity)
+	{
+#ifdef TC_MACOSX
+		identity.ChangeTime = (uint64) fileStat.st_ctimespec.tv_sec * 1000000000ULL + fileStat.st_ctimespec.tv_nsec;
+		identity.ModificationTime = (uint64) fileStat.st_mtimespec.tv_sec * 1000000000ULL + fileStat.st_mtimespec.tv_nsec;
+#else
+		identity.ChangeTime = (uint64) fileStat.st_ctim.tv_sec * 1000000000ULL + fileStat.st_ctim.tv_nsec;
+		identity.ModificationTime = (uint64) fileStat.st_mtim.tv_sec * 1000000000ULL + fileStat.st_mtim.tv_nsec;
+#endif
+		identity.Device = (uint64) fileStat.st_dev;
+		identity.Inode = (uint64) fileStat.st_ino;
+		identity.Size = (uint64) fileStat.st_size;
+
+		SecureBuffer data (KeyfileIdentity::FingerprintLength * 2);
+		size_t length = identity.Size < KeyfileIdentity::FingerprintLength ? (size_t) identity.Size : KeyfileIdentity::FingerprintLength;
+
+		if (pread (fd, data.Ptr(), length, 0) != (ssize_t) length
+			|| pread (fd, data.Ptr() + length, length, (off_t) (identity.Size - length)) != (ssize_t) length)
+		{
+			return false;
+		}
+
+		identity.Fingerprint = Crc32::ProcessBuffer (data.GetRange (0, length * 2));
+		return true;
+	}
+#endif
+
+	void Keyfile::Apply (const BufferPtr &pool, bool useCache) const
 	{
 		if (Path.IsDirectory())
 			throw ParameterIncorrect (SRC_POS);
@@ -30,8 +136,6 @@ namespace VeraCrypt
 		uint64 totalLength = 0;
 		uint64 readLength;
 
-		SecureBuffer keyfileBuf (File::GetOptimalReadSize());
-
 		if (SecurityToken::IsKeyfilePathValid (Path))
 		{
 			// Apply keyfile generated by a security token
@@ -41,52 +145,202 @@ namespace VeraCrypt
 			if (keyfileData.size() < MinProcessedLength)
 				throw InsufficientData (SRC_POS, Path);
 
-			for (size_t i = 0; i < keyfileData.size(); i++)
+			ApplyKeyfileData (crc32, &keyfileData.front(), keyfileData.size(), pool, poolPos, totalLength);
+
+			burn (&keyfileData.front(), keyfileData.size());
+			goto done;
+		}
+
+#ifdef TC_UNIX
+		{
+			// Regular files are mapped instead of being copied through a buffer, unless they cannot be mapped
+			// safely. Other files are read below, which also reports errors of opening the file.
+			int fd = open (string (Path).c_str(), O_RDONLY);
+			if (fd != -1)
 			{
-				uint32 crc = crc32.Process (keyfileData[i]);
+				finally_do_arg (int, fd, { close (finally_arg); });
+
+				struct stat fileStat;
+				if (fstat (fd, &fileStat) == 0 && S_ISREG (fileStat.st_mode) && fileStat.st_size > 0)
+				{
+					KeyfileIdentity identity;
+					bool identified = useCache && GetKeyfileIdentity (fd, fileStat, identity);
+
+					SecureBuffer contribution (pool.Size());
+					if (identified && KeyfileCache::Get (identity, contribution))
+					{
+						AddContribution (pool, contribution);
+						return;
+					}
+
+					contribution.Zero();
+					size_t mapLength = (uint64) fileStat.st_size < MaxProcessedLength ? (size_t) fileStat.st_size : MaxProcessedLength;
+
+					void *data = IsFileMappingSafe (fd, fileStat) ? mmap (nullptr, mapLength, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+					if (data != MAP_FAILED)
+					{
+						finally_do_arg2 (void *, data, size_t, mapLength, { munmap (finally_arg, finally_arg2); });
+#ifdef MADV_SEQUENTIAL
+						madvise (data, mapLength, MADV_SEQUENTIAL);
+#endif
+						ApplyKeyfileData (crc32, static_cast <const byte *> (data), mapLength, contribution, poolPos, totalLength);
+					}
+					else
+					{
+						// The file is read through the descriptor its identity was obtained from
+						file.AssignSystemHandle (fd);
+						SecureBuffer keyfileBuf (File::GetOptimalReadSize());
+
+						while ((readLength = file.Read (keyfileBuf)) > 0)
+						{
+							if (!ApplyKeyfileData (crc32, keyfileBuf, (size_t) readLength, contribution, poolPos, totalLength))
+								break;
+						}
+					}
 
-				pool[poolPos++] += (byte) (crc >> 24);
-				pool[poolPos++] += (byte) (crc >> 16);
-				pool[poolPos++] += (byte) (crc >> 8);
-				pool[poolPos++] += (byte) crc;
+					if (totalLength < MinProcessedLength)
+						throw InsufficientData (SRC_POS, Path);
 
-				if (poolPos >= pool.Size())
-					poolPos = 0;
+					if (identified)
+						KeyfileCache::Store (identity, contribution);
+
+					AddContribution (pool, contribution);
+					return;
+				}
+			}
+		}
+#endif
+		{
+			SecureBuffer keyfileBuf (File::GetOptimalReadSize());
+			file.Open (Path, File::OpenRead, File::ShareRead);
 
-				if (++totalLength >= MaxProcessedLength)
+			while ((readLength = file.Read (keyfileBuf)) > 0)
+			{
+				if (!ApplyKeyfileData (crc32, keyfileBuf, (size_t) readLength, pool, poolPos, totalLength))
 					break;
 			}
+		}
+done:
+		if (totalLength < MinProcessedLength)
+			throw InsufficientData (SRC_POS, Path);
+	}
 
-			burn (&keyfileData.front(), keyfileData.size());
-			goto done;
+	void Keyfile::ApplyList (const KeyfileList &keyfiles, const BufferPtr &pool, bool useCache)
+	{
+		// Keyfiles of security tokens are applied by this thread, as token libraries may not support concurrent use
+		vector < shared_ptr <Keyfile> > fileKeyfiles;
+
+		foreach (shared_ptr <Keyfile> keyfile, keyfiles)
+		{
+			if (SecurityToken::IsKeyfilePathValid (keyfile->Path))
+				keyfile->Apply (pool, useCache);
+			else
+				fileKeyfiles.push_back (keyfile);
 		}
 
-		file.Open (Path, File::OpenRead, File::ShareRead);
+		size_t threadCount = fileKeyfiles.size() < MaxThreadCount ? fileKeyfiles.size() : MaxThreadCount;
+		if (threadCount <= 1)
+		{
+			foreach_ref (const Keyfile &k, fileKeyfiles)
+				k.Apply (pool, useCache);
+			return;
+		}
+
+		// Each keyfile adds its contribution modulo 256 starting at the beginning of the pool, so that
+		// keyfiles can be applied in any order. Each thread applies its keyfiles to a separate pool.
+		struct WorkerState
+		{
+			WorkerState () : FailedKeyfileIndex (0) { }
 
-		while ((readLength = file.Read (keyfileBuf)) > 0)
+			size_t FailedKeyfileIndex;
+			shared_ptr <SecureBuffer> Pool;
+			shared_ptr <Exception> ThreadException;
+		};
+
+		struct WorkerFunctor : public Functor
 		{
-			for (size_t i = 0; i < readLength; i++)
+			WorkerFunctor (const vector < shared_ptr <Keyfile> > &keyfiles, size_t firstIndex, size_t stride, bool useCache, WorkerState &state)
+				: FirstIndex (firstIndex), Keyfiles (keyfiles), State (state), Stride (stride), UseCache (useCache) { }
+
+			virtual void operator() ()
 			{
-				uint32 crc = crc32.Process (keyfileBuf[i]);
+				size_t i = FirstIndex;
+				try
+				{
+					for (; i < Keyfiles.size(); i += Stride)
+						Keyfiles[i]->Apply (*State.Pool, UseCache);
+				}
+				catch (Exception &e)
+				{
+					State.FailedKeyfileIndex = i;
+					State.ThreadException.reset (e.CloneNew());
+				}
+				catch (exception &e)
+				{
+					State.FailedKeyfileIndex = i;
+					State.ThreadException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+				}
+				catch (...)
+				{
+					State.FailedKeyfileIndex = i;
+					State.ThreadException.reset (new UnknownException (SRC_POS));
+				}
+			}
+
+			size_t FirstIndex;
+			const vector < shared_ptr <Keyfile> > &Keyfiles;
+			WorkerState &State;
+			size_t Stride;
+			bool UseCache;
+		};
 
-				pool[poolPos++] += (byte) (crc >> 24);
-				pool[poolPos++] += (byte) (crc >> 16);
-				pool[poolPos++] += (byte) (crc >> 8);
-				pool[poolPos++] += (byte) crc;
+		vector <WorkerState> states (threadCount);
+		list < shared_ptr <Thread> > threads;
 
-				if (poolPos >= pool.Size())
-					poolPos = 0;
+		try
+		{
+			for (size_t i = 0; i < threadCount; ++i)
+			{
+				states[i].Pool.reset (new SecureBuffer (pool.Size()));
+				states[i].Pool->Zero();
 
-				if (++totalLength >= MaxProcessedLength)
-					goto done;
+				make_shared_auto (Thread, thread);
+				thread->Start (new WorkerFunctor (fileKeyfiles, i, threadCount, useCache, states[i]));
+				threads.push_back (thread);
 			}
 		}
-done:
-		if (totalLength < MinProcessedLength)
-			throw InsufficientData (SRC_POS, Path);
+		catch (...)
+		{
+			// Workers already started refer to the local state of this function
+			foreach_ref (const Thread &thread, threads)
+				thread.Join();
+
+			throw;
+		}
+
+		foreach_ref (const Thread &thread, threads)
+			thread.Join();
+
+		// The error of the first failed keyfile in the list is reported
+		const WorkerState *failedState = nullptr;
+		for (size_t i = 0; i < threadCount; ++i)
+		{
+			if (states[i].ThreadException && (!failedState || states[i].FailedKeyfileIndex < failedState->FailedKeyfileIndex))
+				failedState = &states[i];
+		}
+
+		if (failedState)
+			failedState->ThreadException->Throw();
+
+		for (size_t i = 0; i < threadCount; ++i)
+		{
+			const SecureBuffer &threadPool = *states[i].Pool;
+			for (size_t j = 0; j < pool.Size(); ++j)
+				pool[j] += threadPool[j];
+		}
 	}
 
-	shared_ptr <VolumePassword> Keyfile::ApplyListToPassword (shared_ptr <KeyfileList> keyfiles, shared_ptr <VolumePassword> password)
+	shared_ptr <VolumePassword> Keyfile::ApplyListToPassword (shared_ptr <KeyfileList> keyfiles, shared_ptr <VolumePassword> password, bool useCache)
 	{
 		if (!password)
 			password.reset (new VolumePassword);
@@ -140,11 +394,7 @@ namespace VeraCrypt
 			keyfilePool.Zero();
 			keyfilePool.CopyFrom (ConstBufferPtr (password->DataPtr(), password->Size()));
 
-			// Apply all keyfiles
-			foreach_ref (const Keyfile &k, keyfilesExp)
-			{
-				k.Apply (keyfilePool);
-			}
+			ApplyList (keyfilesExp, keyfilePool, useCache);
 
 			newPassword->Set (keyfilePool);
 		}
@@ -29,16 +29,18 @@ namespace VeraCrypt
 		virtual ~Keyfile () { };
 
 		operator FilesystemPath () const { return Path; }
-		static shared_ptr <VolumePassword> ApplyListToPassword (shared_ptr <KeyfileList> keyfiles, shared_ptr <VolumePassword> password);
+		static shared_ptr <VolumePassword> ApplyListToPassword (shared_ptr <KeyfileList> keyfiles, shared_ptr <VolumePassword> password, bool useCache = false);
 		static shared_ptr <KeyfileList> DeserializeList (shared_ptr <Stream> stream, const string &name);
 		static void SerializeList (shared_ptr <Stream> stream, const string &name, shared_ptr <KeyfileList> keyfiles);
 		static bool WasHiddenFilePresentInKeyfilePath() { bool r = HiddenFileWasPresentInKeyfilePath; HiddenFileWasPresentInKeyfilePath = false; return r; }
 
 		static const size_t MinProcessedLength = 1;
 		static const size_t MaxProcessedLength = 1024 * 1024;
+		static const size_t MaxThreadCount = 8;	// Keyfiles applied concurrently
 
 	protected:
-		void Apply (const BufferPtr &pool) const;
+		void Apply (const BufferPtr &pool, bool useCache) const;
+		static void ApplyList (const KeyfileList &keyfiles, const BufferPtr &pool, bool useCache);
 
 		static bool HiddenFileWasPresentInKeyfilePath;
 
@@ -0,0 +1,70 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include "KeyfileCache.h"
+
+namespace VeraCrypt
+{
+	bool KeyfileIdentity::operator== (const KeyfileIdentity &other) const
+	{
+		return ChangeTime == other.ChangeTime
+			&& Device == other.Device
+			&& Fingerprint == other.Fingerprint
+			&& Inode == other.Inode
+			&& ModificationTime == other.ModificationTime
+			&& Size == other.Size;
+	}
+
+	void KeyfileCache::Clear ()
+	{
+		ScopeLock lock (CacheMutex);
+		CachedContributions.clear();
+	}
+
+	bool KeyfileCache::Get (const KeyfileIdentity &identity, const BufferPtr &contribution)
+	{
+		ScopeLock lock (CacheMutex);
+
+		for (CachedKeyfileContributionList::const_iterator it = CachedContributions.begin(); it != CachedContributions.end(); ++it)
+		{
+			// Contributions depend on the size of the pool
+			if (it->Identity == identity && it->Contribution->Size() == contribution.Size())
+			{
+				contribution.CopyFrom (*it->Contribution);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void KeyfileCache::Store (const KeyfileIdentity &identity, const ConstBufferPtr &contribution)
+	{
+		ScopeLock lock (CacheMutex);
+
+		for (CachedKeyfileContributionList::iterator it = CachedContributions.begin(); it != CachedContributions.end(); ++it)
+		{
+			if (it->Identity == identity && it->Contribution->Size() == contribution.Size())
+			{
+				CachedContributions.erase (it);
+				break;
+			}
+		}
+
+		CachedKeyfileContribution cached;
+		cached.Contribution.reset (new SecureBuffer (contribution));
+		cached.Identity = identity;
+		CachedContributions.push_front (cached);
+
+		if (CachedContributions.size() > Capacity)
+			CachedContributions.pop_back();
+	}
+
+	CachedKeyfileContributionList KeyfileCache::CachedContributions;
+	Mutex KeyfileCache::CacheMutex;
+}
@@ -0,0 +1,62 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Volume_KeyfileCache
+#define TC_HEADER_Volume_KeyfileCache
+
+#include "Platform/Platform.h"
+
+namespace VeraCrypt
+{
+	// Identifies the content of a keyfile without reading all of it. Any modification of the file
+	// changes its change time, and the fingerprint covers files restored with their original times.
+	struct KeyfileIdentity
+	{
+		KeyfileIdentity () : ChangeTime (0), Device (0), Fingerprint (0), Inode (0), ModificationTime (0), Size (0) { }
+
+		bool operator== (const KeyfileIdentity &other) const;
+
+		uint64 ChangeTime;			// Nanoseconds
+		uint64 Device;
+		uint32 Fingerprint;			// CRC-32 of the first and last FingerprintLength bytes
+		uint64 Inode;
+		uint64 ModificationTime;	// Nanoseconds
+		uint64 Size;
+
+		static const size_t FingerprintLength = 4096;
+	};
+
+	struct CachedKeyfileContribution
+	{
+		shared_ptr <SecureBuffer> Contribution;
+		KeyfileIdentity Identity;
+	};
+
+	typedef list <CachedKeyfileContribution> CachedKeyfileContributionList;
+
+	// Contributions of keyfiles to a zeroed password pool of a given size, kept in locked memory for
+	// the lifetime of the process so that keyfiles used by several mounts are read only once. The
+	// cache is used only when passwords are cached, and is cleared together with the password cache.
+	class KeyfileCache
+	{
+	public:
+		static void Clear ();
+		static bool Get (const KeyfileIdentity &identity, const BufferPtr &contribution);
+		static void Store (const KeyfileIdentity &identity, const ConstBufferPtr &contribution);
+		static const size_t Capacity = 256;
+
+	protected:
+		static CachedKeyfileContributionList CachedContributions;
+		static Mutex CacheMutex;
+
+	private:
+		KeyfileCache ();
+	};
+}
+
+#endif // TC_HEADER_Volume_KeyfileCache
@@ -14,11 +14,14 @@
 #ifndef TC_WINDOWS
 #include <errno.h>
 #endif
+#include "Calibration.h"
 #include "EncryptionModeXTS.h"
 #include "Volume.h"
 #include "VolumeHeader.h"
 #include "VolumeLayout.h"
 #include "Common/Crypto.h"
+#include "Platform/Time.h"
+#include "Platform/Tracepoint.h"
 
 namespace VeraCrypt
 {
@@ -33,7 +36,9 @@ namespace VeraCrypt
 		TotalDataWritten (0),
 		TrueCryptMode (false),
 		Pim (0),
-		EncryptionNotCompleted (false)
+		EncryptionNotCompleted (false),
+		OpenTime (0),
+		StateGeneration (0)
 	{
 	}
 
@@ -48,6 +53,8 @@ namespace VeraCrypt
 		if ((writeHostOffset < ProtectedRangeStart) ? (writeHostEndOffset >= ProtectedRangeStart) : (writeHostOffset <= ProtectedRangeEnd - 1))
 		{
 			HiddenVolumeProtectionTriggered = true;
+			StateGeneration.fetch_add (1, std::memory_order_release);
+
 			throw VolumeProtected (SRC_POS);
 		}
 	}
@@ -118,12 +125,17 @@ namespace VeraCrypt
 
 		Protection = protection;
 		VolumeFile = volumeFile;
+		OpenStatistics = VolumeOpenStatistics();
+		OpenTime = Time::GetMonotonic();
 		SystemEncryption = partitionInSystemEncryptionScope;
 
 		try
 		{
 			VolumeHostSize = VolumeFile->Length();
+
+			uint64 keyfileStartTime = Time::GetMonotonic();
 			shared_ptr <VolumePassword> passwordKey = Keyfile::ApplyListToPassword (keyfiles, password);
+			OpenStatistics.KeyfileTime = Time::GetMonotonic() - keyfileStartTime;
 
 			bool skipLayoutV1Normal = false;
 
@@ -140,6 +152,7 @@ namespace VeraCrypt
 					continue;
 
 				SecureBuffer headerBuffer (layout->GetHeaderSize());
+				uint64 headerReadStartTime = Time::GetMonotonic();
 
 				if (layout->HasDriveHeader())
 				{
@@ -180,6 +193,8 @@ namespace VeraCrypt
 						continue;
 				}
 
+				OpenStatistics.HeaderReadTime += Time::GetMonotonic() - headerReadStartTime;
+
 				EncryptionAlgorithmList layoutEncryptionAlgorithms = layout->GetSupportedEncryptionAlgorithms();
 				EncryptionModeList layoutEncryptionModes = layout->GetSupportedEncryptionModes();
 
@@ -193,8 +208,19 @@ namespace VeraCrypt
 				}
 
 				shared_ptr <VolumeHeader> header = layout->GetHeader();
+				KdfTrialList trials;
 
-				if (header->Decrypt (headerBuffer, *passwordKey, pim, kdf, truecryptMode, layout->GetSupportedKeyDerivationFunctions(truecryptMode), layoutEncryptionAlgorithms, layoutEncryptionModes))
+				bool headerDecrypted = header->Decrypt (headerBuffer, *passwordKey, pim, kdf, truecryptMode,
+					Calibration::SortKeyDerivationFunctions (layout->GetSupportedKeyDerivationFunctions(truecryptMode), pim), layoutEncryptionAlgorithms, layoutEncryptionModes, &trials);
+
+				foreach (KdfTrial trial, trials)
+				{
+					trial.Layout = layout->GetName();
+					trial.Source = L"password";
+					OpenStatistics.KdfTrials.push_back (trial);
+				}
+
+				if (headerDecrypted)
 				{
 					puts("VolumeHeader::Decrypt OK");
 					// Header decrypted
@@ -264,6 +290,12 @@ namespace VeraCrypt
 
 								ProtectedRangeStart = protectedVolume.VolumeDataOffset;
 								ProtectedRangeEnd = protectedVolume.VolumeDataOffset + protectedVolume.VolumeDataSize;
+
+								VolumeOpenStatistics protectionStatistics = protectedVolume.GetOpenStatistics();
+								for (KdfTrialList::iterator trial = protectionStatistics.KdfTrials.begin(); trial != protectionStatistics.KdfTrials.end(); ++trial)
+									trial->Source = L"protection";
+
+								OpenStatistics.Add (protectionStatistics);
 							}
 							catch (PasswordException&)
 							{
@@ -273,6 +305,8 @@ namespace VeraCrypt
 							}
 						}
 					}
+
+					OpenStatistics.TotalTime = Time::GetMonotonic() - OpenTime;
 					return;
 				}
 			}
@@ -315,6 +349,15 @@ namespace VeraCrypt
 		}
 	}
 
+	VolumeStatistics Volume::GetStatistics () const
+	{
+		VolumeStatistics statistics;
+		statistics.Read = ReadStatistics.Get();
+		statistics.Write = WriteStatistics.Get();
+		statistics.ElapsedTime = Time::GetMonotonic() - OpenTime;
+		return statistics;
+	}
+
 	void Volume::ReadSectors (const BufferPtr &buffer, uint64 byteOffset)
 	{
 		if_debug (ValidateState ());
@@ -326,9 +369,14 @@ namespace VeraCrypt
 		if (length % SectorSize != 0 || byteOffset % SectorSize != 0)
 			throw ParameterIncorrect (SRC_POS);
 
+		TC_TRACE2 (volume_read_start, byteOffset, length);
+		uint64 startTime = Time::GetMonotonic();
+
 		if (VolumeFile->ReadAt (buffer, hostOffset) != length)
 			throw MissingVolumeData (SRC_POS);
 
+		uint64 hostIoEndTime = Time::GetMonotonic();
+
 		// first sector can be unencrypted in some cases (e.g. windows repair)
 		// detect this case by looking for NTFS header
 		if (SystemEncryption && (hostOffset == 0) && ((BE64 (*(uint64 *) buffer.Get ())) == 0xEB52904E54465320ULL))
@@ -355,6 +403,10 @@ namespace VeraCrypt
 		}
 
 		TotalDataRead += length;
+
+		uint64 endTime = Time::GetMonotonic();
+		ReadStatistics.Add (buffer.Size(), hostIoEndTime - startTime, endTime - hostIoEndTime);
+		TC_TRACE4 (volume_read_done, byteOffset, buffer.Size(), hostIoEndTime - startTime, endTime - hostIoEndTime);
 	}
 
 	void Volume::ReEncryptHeader (bool backupHeader, const ConstBufferPtr &newSalt, const ConstBufferPtr &newHeaderKey, shared_ptr <Pkcs5Kdf> newPkcs5Kdf)
@@ -408,7 +460,11 @@ namespace VeraCrypt
 		SecureBuffer encBuf (buffer.Size());
 		encBuf.CopyFrom (buffer);
 
+		TC_TRACE2 (volume_write_start, byteOffset, length);
+		uint64 startTime = Time::GetMonotonic();
 		EA->EncryptSectors (encBuf, hostOffset / SectorSize, length / SectorSize, SectorSize);
+
+		uint64 cryptoEndTime = Time::GetMonotonic();
 		VolumeFile->WriteAt (encBuf, hostOffset);
 
 		TotalDataWritten += length;
@@ -416,5 +472,9 @@ namespace VeraCrypt
 		uint64 writeEndOffset = byteOffset + buffer.Size();
 		if (writeEndOffset > TopWriteOffset)
 			TopWriteOffset = writeEndOffset;
+
+		uint64 endTime = Time::GetMonotonic();
+		WriteStatistics.Add (length, endTime - cryptoEndTime, cryptoEndTime - startTime);
+		TC_TRACE4 (volume_write_done, byteOffset, length, endTime - cryptoEndTime, cryptoEndTime - startTime);
 	}
 }
@@ -21,6 +21,7 @@
 #include "VolumePassword.h"
 #include "VolumeException.h"
 #include "VolumeLayout.h"
+#include "VolumeStatistics.h"
 
 namespace VeraCrypt
 {
@@ -107,6 +108,7 @@ namespace VeraCrypt
 		uint64 GetHeaderCreationTime () const { return Header->GetHeaderCreationTime(); }
 		uint64 GetHostSize () const { return VolumeHostSize; }
 		shared_ptr <VolumeLayout> GetLayout () const { return Layout; }
+		const VolumeOpenStatistics &GetOpenStatistics () const { return OpenStatistics; }
 		VolumePath GetPath () const { return VolumeFile->GetPath(); }
 		VolumeProtection::Enum GetProtectionType () const { return Protection; }
 		shared_ptr <Pkcs5Kdf> GetPkcs5Kdf () const { return Header->GetPkcs5Kdf(); }
@@ -114,6 +116,8 @@ namespace VeraCrypt
 		size_t GetSectorSize () const { return SectorSize; }
 		uint64 GetSize () const { return VolumeDataSize; }
 		uint64 GetEncryptedSize () const { return EncryptedDataSize; }
+		uint64 GetStateGeneration () const { return StateGeneration.load (std::memory_order_acquire); }	// Changes when the state of the volume changes, but not on I/O
+		VolumeStatistics GetStatistics () const;
 		uint64 GetTopWriteOffset () const { return TopWriteOffset; }
 		uint64 GetTotalDataRead () const { return TotalDataRead; }
 		uint64 GetTotalDataWritten () const { return TotalDataWritten; }
@@ -156,6 +160,12 @@ namespace VeraCrypt
 		int Pim;
 		bool EncryptionNotCompleted;
 
+		VolumeOpenStatistics OpenStatistics;
+		uint64 OpenTime;
+		AtomicVolumeIoStatistics ReadStatistics;
+		std::atomic <uint64> StateGeneration;
+		AtomicVolumeIoStatistics WriteStatistics;
+
 	private:
 		Volume (const Volume &);
 		Volume &operator= (const Volume &);
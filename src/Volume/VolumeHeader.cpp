@@ -18,6 +18,8 @@
 #include "VolumeException.h"
 #include "Common/Crypto.h"
 #include "Common/Hexdump.h"
+#include "Platform/Time.h"
+#include "Platform/Tracepoint.h"
 
 #include <stdio.h>
 
@@ -85,7 +87,7 @@ namespace VeraCrypt
 		EncryptNew (headerBuffer, options.Salt, options.HeaderKey, options.Kdf);
 	}
 
-	bool VolumeHeader::Decrypt (const ConstBufferPtr &encryptedData, const VolumePassword &password, int pim, shared_ptr <Pkcs5Kdf> kdf, bool truecryptMode, const Pkcs5KdfList &keyDerivationFunctions, const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes)
+	bool VolumeHeader::Decrypt (const ConstBufferPtr &encryptedData, const VolumePassword &password, int pim, shared_ptr <Pkcs5Kdf> kdf, bool truecryptMode, const Pkcs5KdfList &keyDerivationFunctions, const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes, KdfTrialList *trials)
 	{
 		if (password.Size() < 1)
 			throw PasswordEmpty (SRC_POS);
@@ -100,8 +102,33 @@ namespace VeraCrypt
 			if (kdf && (kdf->GetName() != pkcs5->GetName()))
 				continue;
 
+#ifdef TC_USDT
+			string kdfName = StringConverter::ToSingle (pkcs5->GetName());
+#endif
+			TC_TRACE3 (kdf_trial_start, kdfName.c_str(), pkcs5->GetIterationCount (pim), pim);
+
+			uint64 trialStartTime = Time::GetMonotonic();
 			pkcs5->DeriveKey (headerKey, password, pim, salt);
 
+			if (trials)
+			{
+				KdfTrial trial;
+				trial.Kdf = pkcs5->GetName();
+				trial.Iterations = (uint32) pkcs5->GetIterationCount (pim);
+				trials->push_back (trial);
+			}
+
+			TC_TRACE3 (kdf_trial_done, kdfName.c_str(), pkcs5->GetIterationCount (pim), Time::GetMonotonic() - trialStartTime);
+
+			if (EventStream::IsEnabled())
+			{
+				JsonObject trial;
+				trial.Add ("kdf", pkcs5->GetName());
+				trial.Add ("iterations", (uint64) pkcs5->GetIterationCount (pim));
+				trial.Add ("elapsed_ms", (double) (Time::GetMonotonic() - trialStartTime) / 1000000.0);
+				EventStream::Emit ("kdf_trial", trial);
+			}
+
 			foreach (shared_ptr <EncryptionMode> mode, encryptionModes)
 			{
 				if (typeid (*mode) != typeid (EncryptionModeXTS))
@@ -147,11 +174,20 @@ namespace VeraCrypt
 
 						EA = ea;
 						Pkcs5 = pkcs5;
+
+						if (trials)
+						{
+							trials->back().Success = true;
+							trials->back().Time = Time::GetMonotonic() - trialStartTime;
+						}
 						return true;
 					} else {
 					}
 				}
 			}
+
+			if (trials)
+				trials->back().Time = Time::GetMonotonic() - trialStartTime;
 		}
 
 		return false;
@@ -20,6 +20,7 @@
 #include "Volume/EncryptionMode.h"
 #include "Volume/Keyfile.h"
 #include "Volume/VolumePassword.h"
+#include "Volume/VolumeStatistics.h"
 #include "Volume/Pkcs5Kdf.h"
 #include "Version.h"
 
@@ -60,7 +61,7 @@ namespace VeraCrypt
 		virtual ~VolumeHeader ();
 
 		void Create (const BufferPtr &headerBuffer, VolumeHeaderCreationOptions &options);
-		bool Decrypt (const ConstBufferPtr &encryptedData, const VolumePassword &password, int pim, shared_ptr <Pkcs5Kdf> kdf, bool truecryptMode, const Pkcs5KdfList &keyDerivationFunctions, const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes);
+		bool Decrypt (const ConstBufferPtr &encryptedData, const VolumePassword &password, int pim, shared_ptr <Pkcs5Kdf> kdf, bool truecryptMode, const Pkcs5KdfList &keyDerivationFunctions, const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes, KdfTrialList *trials = nullptr);
 		void EncryptNew (const BufferPtr &newHeaderBuffer, const ConstBufferPtr &newSalt, const ConstBufferPtr &newHeaderKey, shared_ptr <Pkcs5Kdf> newPkcs5Kdf);
 		void Encrypt (const BufferPtr &newHeaderBuffer);
 		uint64 GetEncryptedAreaStart () const { return EncryptedAreaStart; }
@@ -56,6 +56,20 @@ namespace VeraCrypt
 		sr.Deserialize ("VolumeCreationTime", VolumeCreationTime);
 		sr.Deserialize ("TrueCryptMode", TrueCryptMode);
 		sr.Deserialize ("Pim", Pim);
+
+		// Older versions end the structure here (control files of volumes they mounted)
+		uint32 revision = 0;
+		try
+		{
+			sr.Deserialize ("SerializationRevision", revision);
+		}
+		catch (InsufficientData &) { }
+
+		if (revision >= 1)
+			Statistics.Deserialize (stream);
+
+		if (revision >= 2)
+			OpenStatistics.Deserialize (stream);
 	}
 
 	bool VolumeInfo::FirstVolumeMountedAfterSecond (shared_ptr <VolumeInfo> first, shared_ptr <VolumeInfo> second)
@@ -97,6 +111,9 @@ namespace VeraCrypt
 		sr.Serialize ("VolumeCreationTime", VolumeCreationTime);
 		sr.Serialize ("TrueCryptMode", TrueCryptMode);
 		sr.Serialize ("Pim", Pim);
+		sr.Serialize ("SerializationRevision", SerializationRevision);
+		Statistics.Serialize (stream);
+		OpenStatistics.Serialize (stream);
 	}
 
 	void VolumeInfo::Set (const Volume &volume)
@@ -110,11 +127,13 @@ namespace VeraCrypt
 		VolumeCreationTime = volume.GetVolumeCreationTime();
 		HiddenVolumeProtectionTriggered = volume.IsHiddenVolumeProtectionTriggered();
 		MinRequiredProgramVersion = volume.GetHeader()->GetRequiredMinProgramVersion();
+		OpenStatistics = volume.GetOpenStatistics();
 		Path = volume.GetPath();
 		Pkcs5IterationCount = volume.GetPkcs5Kdf()->GetIterationCount(volume.GetPim ());
 		Pkcs5PrfName = volume.GetPkcs5Kdf()->GetName();
 		Protection = volume.GetProtectionType();
 		Size = volume.GetSize();
+		Statistics = volume.GetStatistics();
 		SystemEncryption = volume.IsInSystemEncryptionScope();
 		Type = volume.GetType();
 		TopWriteOffset = volume.GetTopWriteOffset();
@@ -17,6 +17,7 @@
 #include "Platform/Serializable.h"
 #include "Volume/Volume.h"
 #include "Volume/VolumeSlot.h"
+#include "Volume/VolumeStatistics.h"
 
 namespace VeraCrypt
 {
@@ -45,6 +46,7 @@ namespace VeraCrypt
 		DevicePath LoopDevice;
 		uint32 MinRequiredProgramVersion;
 		DirectoryPath MountPoint;
+		VolumeOpenStatistics OpenStatistics;
 		VolumePath Path;
 		uint32 Pkcs5IterationCount;
 		wstring Pkcs5PrfName;
@@ -53,6 +55,7 @@ namespace VeraCrypt
 		uint64 SerialInstanceNumber;
 		uint64 Size;
 		VolumeSlotNumber SlotNumber;
+		VolumeStatistics Statistics;
 		bool SystemEncryption;
 		uint64 TopWriteOffset;
 		uint64 TotalDataRead;
@@ -63,6 +66,10 @@ namespace VeraCrypt
 		bool TrueCryptMode;
 		int Pim;
 
+	protected:
+		// Revision of the serialized structure, which gates the fields added within a program version
+		static const uint32 SerializationRevision = 2;	// 1: Statistics, 2: OpenStatistics
+
 	private:
 		VolumeInfo (const VolumeInfo &);
 		VolumeInfo &operator= (const VolumeInfo &);
@@ -37,6 +37,7 @@ namespace VeraCrypt
 		virtual int GetHeaderOffset () const { return HeaderOffset; } // Positive value: offset from the start of host, negative: offset from the end
 		virtual uint32 GetHeaderSize () const { return HeaderSize; }
 		virtual uint64 GetMaxDataSize (uint64 volumeSize) const = 0;
+		virtual wstring GetName () const = 0;
 		virtual EncryptionAlgorithmList GetSupportedEncryptionAlgorithms () const { return SupportedEncryptionAlgorithms; }
 		virtual Pkcs5KdfList GetSupportedKeyDerivationFunctions (bool truecryptMode) const { return Pkcs5Kdf::GetAvailableAlgorithms(truecryptMode); }
 		virtual EncryptionModeList GetSupportedEncryptionModes () const { return SupportedEncryptionModes; }
@@ -74,6 +75,7 @@ namespace VeraCrypt
 		virtual uint64 GetDataOffset (uint64 volumeHostSize) const;
 		virtual uint64 GetDataSize (uint64 volumeHostSize) const;
 		virtual uint64 GetMaxDataSize (uint64 volumeSize) const { throw NotApplicable (SRC_POS); }
+		virtual wstring GetName () const { return L"V1 normal"; }
 		virtual bool HasBackupHeader () const { return false; }
 
 	private:
@@ -91,6 +93,7 @@ namespace VeraCrypt
 		virtual uint64 GetDataOffset (uint64 volumeHostSize) const;
 		virtual uint64 GetDataSize (uint64 volumeHostSize) const;
 		virtual uint64 GetMaxDataSize (uint64 volumeSize) const;
+		virtual wstring GetName () const { return L"V2 normal"; }
 		virtual bool HasBackupHeader () const { return true; }
 
 	private:
@@ -108,6 +111,7 @@ namespace VeraCrypt
 		virtual uint64 GetDataOffset (uint64 volumeHostSize) const;
 		virtual uint64 GetDataSize (uint64 volumeHostSize) const;
 		virtual uint64 GetMaxDataSize (uint64 volumeSize) const;
+		virtual wstring GetName () const { return L"V2 hidden"; }
 		virtual bool HasBackupHeader () const { return true; }
 
 	private:
@@ -126,6 +130,7 @@ namespace VeraCrypt
 		virtual uint64 GetDataOffset (uint64 volumeHostSize) const;
 		virtual uint64 GetDataSize (uint64 volumeHostSize) const;
 		virtual uint64 GetMaxDataSize (uint64 volumeSize) const { throw NotApplicable (SRC_POS); }
+		virtual wstring GetName () const { return L"System encryption"; }
 		virtual Pkcs5KdfList GetSupportedKeyDerivationFunctions (bool truecryptMode) const;
 		virtual bool HasBackupHeader () const { return false; }
 		virtual bool HasDriveHeader () const { return true; }
@@ -81,6 +81,18 @@ namespace VeraCrypt
 
 	TC_SERIALIZER_FACTORY_ADD_CLASS (VolumePassword);
 
+	void PasswordIncorrect::Deserialize (shared_ptr <Stream> stream)
+	{
+		Exception::Deserialize (stream);
+		OpenStatistics.Deserialize (stream);
+	}
+
+	void PasswordIncorrect::Serialize (shared_ptr <Stream> stream) const
+	{
+		Exception::Serialize (stream);
+		OpenStatistics.Serialize (stream);
+	}
+
 #define TC_EXCEPTION(TYPE) TC_SERIALIZER_FACTORY_ADD(TYPE)
 #undef TC_EXCEPTION_NODECL
 #define TC_EXCEPTION_NODECL(TYPE) TC_SERIALIZER_FACTORY_ADD(TYPE)
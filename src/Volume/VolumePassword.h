@@ -15,6 +15,7 @@
 
 #include "Platform/Platform.h"
 #include "Platform/Serializable.h"
+#include "VolumeStatistics.h"
 
 namespace VeraCrypt
 {
@@ -61,7 +62,22 @@ namespace VeraCrypt
 		PasswordException (const string &message, const wstring &subject) : Exception (message, subject) { }
 	};
 
-	TC_EXCEPTION_DECL (PasswordIncorrect, PasswordException);
+	struct PasswordIncorrect : public PasswordException
+	{
+		PasswordIncorrect () { }
+		PasswordIncorrect (const string &message) : PasswordException (message) { }
+		PasswordIncorrect (const string &message, const wstring &subject) : PasswordException (message, subject) { }
+		virtual ~PasswordIncorrect () throw () { }
+
+		TC_SERIALIZABLE_EXCEPTION (PasswordIncorrect);
+
+		const VolumeOpenStatistics &GetOpenStatistics () const { return OpenStatistics; }
+		void SetOpenStatistics (const VolumeOpenStatistics &statistics) { OpenStatistics = statistics; }
+
+	protected:
+		VolumeOpenStatistics OpenStatistics;	// Time spent trying the password
+	};
+
 	TC_EXCEPTION_DECL (PasswordKeyfilesIncorrect, PasswordIncorrect);
 	TC_EXCEPTION_DECL (PasswordOrKeyboardLayoutIncorrect, PasswordException);
 	TC_EXCEPTION_DECL (PasswordOrMountOptionsIncorrect, PasswordException);
@@ -0,0 +1,321 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#include "VolumeStatistics.h"
+
+namespace VeraCrypt
+{
+	void LatencyHistogram::Add (uint64 latency)
+	{
+		++Buckets[GetBucketIndex (latency)];
+		++Count;
+		Total += latency;
+
+		if (latency > Max)
+			Max = latency;
+	}
+
+	void LatencyHistogram::Clear ()
+	{
+		Memory::Zero (Buckets, sizeof (Buckets));
+		Count = 0;
+		Max = 0;
+		Total = 0;
+	}
+
+	void LatencyHistogram::Deserialize (Serializer &sr, const string &name)
+	{
+		sr.Deserialize (name + "Count", Count);
+		sr.Deserialize (name + "Max", Max);
+		sr.Deserialize (name + "Total", Total);
+		sr.Deserialize (name + "Buckets", BufferPtr ((byte *) Buckets, sizeof (Buckets)));
+
+		for (size_t i = 0; i < BucketCount; ++i)
+			Buckets[i] = Endian::Big (Buckets[i]);
+	}
+
+	size_t LatencyHistogram::GetBucketIndex (uint64 latency)
+	{
+		if (latency < SubBucketCount)
+			return (size_t) latency;
+
+		size_t exponent = 0;
+		for (uint64 v = latency; v > 1; v >>= 1)
+			++exponent;
+
+		size_t index = (exponent - SubBucketBits + 1) * SubBucketCount + (size_t) ((latency >> (exponent - SubBucketBits)) & (SubBucketCount - 1));
+		return index < BucketCount ? index : BucketCount - 1;
+	}
+
+	uint64 LatencyHistogram::GetBucketUpperBound (size_t index)
+	{
+		if (index < SubBucketCount)
+			return index;
+
+		size_t shift = index / SubBucketCount - 1;
+		uint64 lowerBound = (uint64) (SubBucketCount + index % SubBucketCount) << shift;
+		return lowerBound + (1ULL << shift) - 1;
+	}
+
+	uint64 LatencyHistogram::GetPercentile (double percentile) const
+	{
+		if (Count == 0)
+			return 0;
+
+		uint64 rank = (uint64) (percentile / 100.0 * Count + 0.5);
+		if (rank < 1)
+			rank = 1;
+
+		uint64 seen = 0;
+		for (size_t i = 0; i < BucketCount; ++i)
+		{
+			seen += Buckets[i];
+			if (seen >= rank)
+				return i == BucketCount - 1 ? Max : VC_MIN (GetBucketUpperBound (i), Max);
+		}
+
+		return Max;
+	}
+
+	void LatencyHistogram::Serialize (Serializer &sr, const string &name) const
+	{
+		uint64 buckets[BucketCount];
+		for (size_t i = 0; i < BucketCount; ++i)
+			buckets[i] = Endian::Big (Buckets[i]);
+
+		sr.Serialize (name + "Count", Count);
+		sr.Serialize (name + "Max", Max);
+		sr.Serialize (name + "Total", Total);
+		sr.Serialize (name + "Buckets", ConstBufferPtr ((const byte *) buckets, sizeof (buckets)));
+	}
+
+	AtomicLatencyHistogram::AtomicLatencyHistogram ()
+	{
+		for (size_t i = 0; i < LatencyHistogram::BucketCount; ++i)
+			Buckets[i].store (0, std::memory_order_relaxed);
+
+		Count.store (0, std::memory_order_relaxed);
+		Max.store (0, std::memory_order_relaxed);
+		Total.store (0, std::memory_order_relaxed);
+	}
+
+	void AtomicLatencyHistogram::Add (uint64 latency)
+	{
+		Buckets[LatencyHistogram::GetBucketIndex (latency)].fetch_add (1, std::memory_order_relaxed);
+		Count.fetch_add (1, std::memory_order_relaxed);
+		Total.fetch_add (latency, std::memory_order_relaxed);
+
+		uint64 max = Max.load (std::memory_order_relaxed);
+		while (latency > max && !Max.compare_exchange_weak (max, latency, std::memory_order_relaxed));
+	}
+
+	LatencyHistogram AtomicLatencyHistogram::Get () const
+	{
+		LatencyHistogram histogram;
+
+		for (size_t i = 0; i < LatencyHistogram::BucketCount; ++i)
+			histogram.Buckets[i] = Buckets[i].load (std::memory_order_relaxed);
+
+		histogram.Count = Count.load (std::memory_order_relaxed);
+		histogram.Max = Max.load (std::memory_order_relaxed);
+		histogram.Total = Total.load (std::memory_order_relaxed);
+		return histogram;
+	}
+
+	AtomicVolumeIoStatistics::AtomicVolumeIoStatistics ()
+	{
+		Bytes.store (0, std::memory_order_relaxed);
+		Operations.store (0, std::memory_order_relaxed);
+
+		for (size_t i = 0; i < VolumeIoStatistics::SizeBucketCount; ++i)
+			SizeBuckets[i].store (0, std::memory_order_relaxed);
+	}
+
+	void AtomicVolumeIoStatistics::Add (uint64 size, uint64 hostLatency, uint64 cryptoLatency)
+	{
+		Operations.fetch_add (1, std::memory_order_relaxed);
+		Bytes.fetch_add (size, std::memory_order_relaxed);
+		SizeBuckets[VolumeIoStatistics::GetSizeBucketIndex (size)].fetch_add (1, std::memory_order_relaxed);
+		HostLatency.Add (hostLatency);
+		CryptoLatency.Add (cryptoLatency);
+	}
+
+	VolumeIoStatistics AtomicVolumeIoStatistics::Get () const
+	{
+		VolumeIoStatistics statistics;
+		statistics.Operations = Operations.load (std::memory_order_relaxed);
+		statistics.Bytes = Bytes.load (std::memory_order_relaxed);
+
+		for (size_t i = 0; i < VolumeIoStatistics::SizeBucketCount; ++i)
+			statistics.SizeBuckets[i] = SizeBuckets[i].load (std::memory_order_relaxed);
+
+		statistics.HostLatency = HostLatency.Get();
+		statistics.CryptoLatency = CryptoLatency.Get();
+		return statistics;
+	}
+
+	void VolumeIoStatistics::Add (uint64 size, uint64 hostLatency, uint64 cryptoLatency)
+	{
+		++Operations;
+		Bytes += size;
+		++SizeBuckets[GetSizeBucketIndex (size)];
+		HostLatency.Add (hostLatency);
+		CryptoLatency.Add (cryptoLatency);
+	}
+
+	void VolumeIoStatistics::Deserialize (Serializer &sr, const string &name)
+	{
+		sr.Deserialize (name + "Operations", Operations);
+		sr.Deserialize (name + "Bytes", Bytes);
+
+		for (size_t i = 0; i < SizeBucketCount; ++i)
+			sr.Deserialize (name + "SizeBucket", SizeBuckets[i]);
+
+		HostLatency.Deserialize (sr, name + "HostLatency");
+		CryptoLatency.Deserialize (sr, name + "CryptoLatency");
+	}
+
+	size_t VolumeIoStatistics::GetSizeBucketIndex (uint64 size)
+	{
+		size_t index = 0;
+		while (index < SizeBucketCount - 1 && size > GetSizeBucketLimit (index))
+			++index;
+
+		return index;
+	}
+
+	void VolumeIoStatistics::Serialize (Serializer &sr, const string &name) const
+	{
+		sr.Serialize (name + "Operations", Operations);
+		sr.Serialize (name + "Bytes", Bytes);
+
+		for (size_t i = 0; i < SizeBucketCount; ++i)
+			sr.Serialize (name + "SizeBucket", SizeBuckets[i]);
+
+		HostLatency.Serialize (sr, name + "HostLatency");
+		CryptoLatency.Serialize (sr, name + "CryptoLatency");
+	}
+
+	void VolumeStatistics::Deserialize (shared_ptr <Stream> stream)
+	{
+		Serializer sr (stream);
+		sr.Deserialize ("StatisticsElapsedTime", ElapsedTime);
+		Read.Deserialize (sr, "Read");
+		Write.Deserialize (sr, "Write");
+	}
+
+	void VolumeStatistics::Serialize (shared_ptr <Stream> stream) const
+	{
+		Serializer sr (stream);
+		sr.Serialize ("StatisticsElapsedTime", ElapsedTime);
+		Read.Serialize (sr, "Read");
+		Write.Serialize (sr, "Write");
+	}
+
+	void VolumeOpenStatistics::Add (const VolumeOpenStatistics &statistics)
+	{
+		HeaderReadTime += statistics.HeaderReadTime;
+		KeyfileTime += statistics.KeyfileTime;
+		KdfTrials.insert (KdfTrials.end(), statistics.KdfTrials.begin(), statistics.KdfTrials.end());
+	}
+
+	void VolumeOpenStatistics::Deserialize (shared_ptr <Stream> stream)
+	{
+		Serializer sr (stream);
+		sr.Deserialize ("HeaderReadTime", HeaderReadTime);
+		sr.Deserialize ("KeyfileTime", KeyfileTime);
+		sr.Deserialize ("TotalTime", TotalTime);
+
+		KdfTrials.clear();
+		uint32 trialCount = sr.DeserializeUInt32 ("KdfTrialCount");
+
+		for (uint32 i = 0; i < trialCount; ++i)
+		{
+			KdfTrial trial;
+			sr.Deserialize ("KdfTrialIterations", trial.Iterations);
+			sr.Deserialize ("KdfTrialKdf", trial.Kdf);
+			sr.Deserialize ("KdfTrialLayout", trial.Layout);
+			sr.Deserialize ("KdfTrialSource", trial.Source);
+			sr.Deserialize ("KdfTrialSuccess", trial.Success);
+			sr.Deserialize ("KdfTrialTime", trial.Time);
+			KdfTrials.push_back (trial);
+		}
+	}
+
+	void VolumeOpenStatistics::Serialize (shared_ptr <Stream> stream) const
+	{
+		Serializer sr (stream);
+		sr.Serialize ("HeaderReadTime", HeaderReadTime);
+		sr.Serialize ("KeyfileTime", KeyfileTime);
+		sr.Serialize ("TotalTime", TotalTime);
+		sr.Serialize ("KdfTrialCount", (uint32) KdfTrials.size());
+
+		foreach (const KdfTrial &trial, KdfTrials)
+		{
+			sr.Serialize ("KdfTrialIterations", trial.Iterations);
+			sr.Serialize ("KdfTrialKdf", trial.Kdf);
+			sr.Serialize ("KdfTrialLayout", trial.Layout);
+			sr.Serialize ("KdfTrialSource", trial.Source);
+			sr.Serialize ("KdfTrialSuccess", trial.Success);
+			sr.Serialize ("KdfTrialTime", trial.Time);
+		}
+	}
+
+	JsonObject VolumeOpenStatistics::ToJson () const
+	{
+		// Trials are summed per key derivation function, layout and password source
+		map <wstring, double> kdfTimes;
+		map <wstring, double> layoutTimes;
+		map <wstring, double> sourceTimes;
+		double kdfTotalTime = 0;
+
+		foreach (const KdfTrial &trial, KdfTrials)
+		{
+			double time = (double) trial.Time / 1000000.0;
+			kdfTimes[trial.Kdf] += time;
+			layoutTimes[trial.Layout] += time;
+			sourceTimes[trial.Source] += time;
+			kdfTotalTime += time;
+		}
+
+		struct Converter
+		{
+			static JsonObject ToJson (const map <wstring, double> &times)
+			{
+				JsonObject json;
+
+				typedef pair <wstring, double> TimePair;
+				foreach (TimePair time, times)
+					json.Add (StringConverter::ToSingle (time.first), time.second);
+
+				return json;
+			}
+		};
+
+		JsonObject json;
+		json.Add ("total_ms", (double) TotalTime / 1000000.0);
+		json.Add ("keyfiles_ms", (double) KeyfileTime / 1000000.0);
+		json.Add ("header_read_ms", (double) HeaderReadTime / 1000000.0);
+		json.Add ("kdf_trials", (uint64) KdfTrials.size());
+		json.Add ("kdf_ms", kdfTotalTime);
+		json.Add ("kdf_ms_by_prf", Converter::ToJson (kdfTimes));
+		json.Add ("kdf_ms_by_layout", Converter::ToJson (layoutTimes));
+		json.Add ("kdf_ms_by_source", Converter::ToJson (sourceTimes));
+
+		foreach (const KdfTrial &trial, KdfTrials)
+		{
+			if (trial.Success && trial.Source == L"password")
+			{
+				json.Add ("prf", trial.Kdf);
+				json.Add ("layout", trial.Layout);
+			}
+		}
+
+		return json;
+	}
+}
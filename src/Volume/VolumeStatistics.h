@@ -0,0 +1,160 @@
+/*
+ Copyright (c) 2013-2017 IDRIX. All rights reserved.
+
+ Governed by the Apache License 2.0 the full text of which is
+ contained in the file License.txt included in VeraCrypt binary and source
+ code distribution packages.
+*/
+
+#ifndef TC_HEADER_Volume_VolumeStatistics
+#define TC_HEADER_Volume_VolumeStatistics
+
+#include <atomic>
+#include "Platform/Platform.h"
+#include "Platform/JsonObject.h"
+#include "Platform/Serializer.h"
+
+namespace VeraCrypt
+{
+	// Log-linear histogram of latencies in nanoseconds. Each power of two is divided
+	// into eight sub-buckets, which bounds the relative error of a percentile to 12.5%.
+	class LatencyHistogram
+	{
+	public:
+		LatencyHistogram () { Clear(); }
+
+		void Add (uint64 latency);
+		void Clear ();
+		void Deserialize (Serializer &sr, const string &name);
+		uint64 GetCount () const { return Count; }
+		uint64 GetMax () const { return Max; }
+		uint64 GetMean () const { return Count ? Total / Count : 0; }
+		uint64 GetPercentile (double percentile) const;
+		void Serialize (Serializer &sr, const string &name) const;
+
+		static const size_t SubBucketBits = 3;
+		static const size_t SubBucketCount = 1 << SubBucketBits;
+		static const size_t MaxExponent = 36; // Latencies of 2^36 ns (~69 s) and more share the last bucket
+		static const size_t BucketCount = (MaxExponent - SubBucketBits + 1) * SubBucketCount;
+
+	protected:
+		friend class AtomicLatencyHistogram;
+
+		static size_t GetBucketIndex (uint64 latency);
+		static uint64 GetBucketUpperBound (size_t index);
+
+		uint64 Buckets[BucketCount];
+		uint64 Count;
+		uint64 Max;
+		uint64 Total;
+	};
+
+	// Statistics of requests in one direction (reads or writes)
+	struct VolumeIoStatistics
+	{
+		VolumeIoStatistics () : Bytes (0), Operations (0) { Memory::Zero (SizeBuckets, sizeof (SizeBuckets)); }
+
+		void Add (uint64 size, uint64 hostLatency, uint64 cryptoLatency);
+		void Deserialize (Serializer &sr, const string &name);
+		static size_t GetSizeBucketIndex (uint64 size);
+		static uint64 GetSizeBucketLimit (size_t index) { return MinSizeBucketLimit << index; }
+		void Serialize (Serializer &sr, const string &name) const;
+
+		// Bucket i counts requests of up to 512 << i bytes; the last bucket counts all larger requests
+		static const uint64 MinSizeBucketLimit = 512;
+		static const size_t SizeBucketCount = 12;
+
+		uint64 Bytes;
+		LatencyHistogram CryptoLatency;
+		LatencyHistogram HostLatency;
+		uint64 Operations;
+		uint64 SizeBuckets[SizeBucketCount];
+	};
+
+	// Counterpart of LatencyHistogram updated by concurrent requests without locking. Counters
+	// are updated independently, so a snapshot taken during I/O may be slightly inconsistent.
+	class AtomicLatencyHistogram
+	{
+	public:
+		AtomicLatencyHistogram ();
+
+		void Add (uint64 latency);
+		LatencyHistogram Get () const;
+
+	protected:
+		std::atomic <uint64> Buckets[LatencyHistogram::BucketCount];
+		std::atomic <uint64> Count;
+		std::atomic <uint64> Max;
+		std::atomic <uint64> Total;
+
+	private:
+		AtomicLatencyHistogram (const AtomicLatencyHistogram &);
+		AtomicLatencyHistogram &operator= (const AtomicLatencyHistogram &);
+	};
+
+	// Counterpart of VolumeIoStatistics updated by concurrent requests without locking
+	class AtomicVolumeIoStatistics
+	{
+	public:
+		AtomicVolumeIoStatistics ();
+
+		void Add (uint64 size, uint64 hostLatency, uint64 cryptoLatency);
+		VolumeIoStatistics Get () const;
+
+	protected:
+		std::atomic <uint64> Bytes;
+		AtomicLatencyHistogram CryptoLatency;
+		AtomicLatencyHistogram HostLatency;
+		std::atomic <uint64> Operations;
+		std::atomic <uint64> SizeBuckets[VolumeIoStatistics::SizeBucketCount];
+
+	private:
+		AtomicVolumeIoStatistics (const AtomicVolumeIoStatistics &);
+		AtomicVolumeIoStatistics &operator= (const AtomicVolumeIoStatistics &);
+	};
+
+	// Header decryption attempt using one key derivation function
+	struct KdfTrial
+	{
+		KdfTrial () : Iterations (0), Success (false), Time (0) { }
+
+		uint32 Iterations;
+		wstring Kdf;
+		wstring Layout;
+		wstring Source;		// "password", or "protection" for the password of a protected hidden volume
+		bool Success;
+		uint64 Time;		// Nanoseconds spent deriving the header key and testing it with all algorithms
+	};
+
+	typedef list <KdfTrial> KdfTrialList;
+
+	// Time spent opening a volume, which is mostly spent in key derivation
+	struct VolumeOpenStatistics
+	{
+		VolumeOpenStatistics () : HeaderReadTime (0), KeyfileTime (0), TotalTime (0) { }
+
+		void Add (const VolumeOpenStatistics &statistics);
+		void Deserialize (shared_ptr <Stream> stream);
+		void Serialize (shared_ptr <Stream> stream) const;
+		JsonObject ToJson () const;
+
+		uint64 HeaderReadTime;	// Nanoseconds
+		KdfTrialList KdfTrials;
+		uint64 KeyfileTime;		// Nanoseconds spent applying keyfiles to passwords
+		uint64 TotalTime;		// Nanoseconds
+	};
+
+	struct VolumeStatistics
+	{
+		VolumeStatistics () : ElapsedTime (0) { }
+
+		void Deserialize (shared_ptr <Stream> stream);
+		void Serialize (shared_ptr <Stream> stream) const;
+
+		uint64 ElapsedTime;	// Nanoseconds since the volume was opened
+		VolumeIoStatistics Read;
+		VolumeIoStatistics Write;
+	};
+}
+
+#endif // TC_HEADER_Volume_VolumeStatistics